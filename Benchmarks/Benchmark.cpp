@@ -0,0 +1,96 @@
+#include "Benchmark.h"
+
+#include "GLEW/include/GL/glew.h"
+#include "SDL/include/SDL.h"
+
+#include "MATH_GEO_LIB/Math/float3.h"
+#include "MATH_GEO_LIB/Math/Quat.h"
+
+#include <cstdio>
+
+static SDL_Window* hidden_window = nullptr;
+static SDL_GLContext hidden_context = nullptr;
+
+math::Frustum CreateBenchmarkFrustum(float angle, float far_plane_distance)
+{
+	const math::float3 front = math::Quat::RotateY(angle) * -math::float3::unitZ;
+
+	math::Frustum frustum;
+	frustum.SetKind(math::FrustumSpaceGL, math::FrustumRightHanded);
+	frustum.SetViewPlaneDistances(0.1f, far_plane_distance);
+	frustum.SetFrame(math::float3::zero, front, math::float3::unitY);
+	frustum.SetPerspective(1.2f, 0.9f);
+
+	return frustum;
+}
+
+bool CreateHiddenGLContext()
+{
+	if (hidden_context != nullptr)
+	{
+		return true;
+	}
+
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+	{
+		printf("  SDL could not be initialized: %s\n", SDL_GetError());
+		return false;
+	}
+
+	// Same context ModuleRender creates:
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_COMPATIBILITY);
+
+	hidden_window = SDL_CreateWindow("Benchmarks", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 1, 1, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+
+	if (hidden_window == nullptr)
+	{
+		printf("  Hidden window could not be created: %s\n", SDL_GetError());
+		return false;
+	}
+
+	hidden_context = SDL_GL_CreateContext(hidden_window);
+
+	if (hidden_context == nullptr)
+	{
+		printf("  OpenGL context could not be created: %s\n", SDL_GetError());
+		return false;
+	}
+
+	if (glewInit() != GLEW_OK)
+	{
+		printf("  GLEW could not be initialized.\n");
+		return false;
+	}
+
+	return true;
+}
+
+void DestroyHiddenGLContext()
+{
+	if (hidden_context != nullptr)
+	{
+		SDL_GL_DeleteContext(hidden_context);
+	}
+
+	if (hidden_window != nullptr)
+	{
+		SDL_DestroyWindow(hidden_window);
+	}
+
+	hidden_context = nullptr;
+	hidden_window = nullptr;
+
+	SDL_Quit();
+}
+
+void PrintTime(const char* name, double milliseconds)
+{
+	printf("  %-48s %12.3f ms\n", name, milliseconds);
+}
+
+void PrintSpeedup(const char* name, double reference_milliseconds, double optimized_milliseconds)
+{
+	printf("  %-48s %12.1f x\n", name, optimized_milliseconds > 0.0 ? reference_milliseconds / optimized_milliseconds : 0.0);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "MATH_GEO_LIB/Geometry/Frustum.h"
+
+#include <chrono>
+#include <cstddef>
+
+/// <summary>
+/// Measures the wall clock time between Start and Stop.
+/// </summary>
+class BenchmarkTimer
+{
+private:
+	std::chrono::high_resolution_clock::time_point start_time;
+	std::chrono::high_resolution_clock::time_point end_time;
+
+public:
+	void Start() { start_time = std::chrono::high_resolution_clock::now(); };
+	void Stop() { end_time = std::chrono::high_resolution_clock::now(); };
+
+	double Milliseconds() const { return std::chrono::duration<double, std::milli>(end_time - start_time).count(); };
+	double Microseconds() const { return std::chrono::duration<double, std::micro>(end_time - start_time).count(); };
+	double Seconds() const { return std::chrono::duration<double>(end_time - start_time).count(); };
+};
+
+/// <summary>
+/// Small deterministic random number generator, so that every run of a
+/// benchmark works on the same data.
+/// </summary>
+class BenchmarkRandom
+{
+private:
+	unsigned int state;
+
+public:
+	explicit BenchmarkRandom(unsigned int seed) : state(seed == 0 ? 1 : seed) {};
+
+	/// <returns>
+	/// Next random value in [0, 1).
+	/// </returns>
+	float Float()
+	{
+		// xorshift32:
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+
+		return (state >> 8) * (1.0f / 16777216.0f);
+	};
+
+	/// <returns>
+	/// Next random value in [min, max).
+	/// </returns>
+	float Range(float min, float max) { return min + (max - min) * Float(); };
+};
+
+/// <summary>
+/// Frustum of a camera at the center of the world, turned around the y
+/// axis by angle, with the same kind ComponentCamera uses.
+/// </summary>
+/// <param name="angle">Angle around the y axis in radians, 0 looks towards -z.</param>
+/// <param name="far_plane_distance">Distance of the far plane from the camera.</param>
+math::Frustum CreateBenchmarkFrustum(float angle, float far_plane_distance);
+
+/// <summary>
+/// Creates an OpenGL context on a hidden window, for the benchmarks that
+/// load ResourceMeshes, as they upload their buffers on Load. Does nothing
+/// if the context is already created.
+/// </summary>
+/// <returns>False if the context couldn't be created.</returns>
+bool CreateHiddenGLContext();
+
+/// <summary>
+/// Destroys the context created by CreateHiddenGLContext, if any. Must be
+/// called after the ResourceMeshes are destroyed.
+/// </summary>
+void DestroyHiddenGLContext();
+
+/// <summary>
+/// Prints the name of a benchmark case and the time it took.
+/// </summary>
+void PrintTime(const char* name, double milliseconds);
+
+/// <summary>
+/// Prints how many times faster the optimized case is than the reference.
+/// </summary>
+void PrintSpeedup(const char* name, double reference_milliseconds, double optimized_milliseconds);
+
+// Benchmarks, each one prints its own results:
+void RunTransformPropagationBenchmark();
+void RunBoundingBoxBenchmark();
+void RunVisibleSetBenchmark();
+void RunQuadTreeBenchmark();
+void RunFrustumCullingBenchmark();
+void RunRayPickingBenchmark();
+void RunParallelCullingBenchmark();
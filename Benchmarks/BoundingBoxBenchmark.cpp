@@ -0,0 +1,375 @@
+#include "Benchmark.h"
+
+#include "Application.h"
+#include "ModuleSceneManager.h"
+#include "ResourceMeshCache.h"
+#include "Entity.h"
+#include "ComponentBoundingBox.h"
+#include "ComponentMesh.h"
+#include "ComponentTransform.h"
+#include "TransformStore.h"
+#include "Event.h"
+
+#include "MATH_GEO_LIB/Geometry/AABB.h"
+#include "MATH_GEO_LIB/Geometry/OBB.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_set>
+#include <vector>
+
+#define BOUNDING_BOX_BENCHMARK_FLAT_NODE_COUNT 4000
+#define BOUNDING_BOX_BENCHMARK_TREE_BRANCHING 4
+#define BOUNDING_BOX_BENCHMARK_TREE_DEPTH 6
+#define BOUNDING_BOX_BENCHMARK_FRAMES 60
+#define BOUNDING_BOX_BENCHMARK_EDITS_PER_FRAME 4
+
+/// <summary>
+/// Adds the world space obb of mesh to aabb, the same way
+/// ComponentBoundingBox::AddMeshComponentToAABB does.
+/// </summary>
+static void EncloseReferenceMesh(const ComponentMesh* mesh, math::AABB& aabb)
+{
+	const ComponentTransform* transform = mesh->Owner()->Transform();
+
+	math::OBB local_obb;
+	local_obb.SetFrom(mesh->GetAABB());
+	local_obb.Scale(math::float3::zero, transform->GetScale());
+	local_obb.Transform(transform->GetRotation());
+	local_obb.Translate(transform->GetPosition());
+
+	aabb.Enclose(local_obb);
+}
+
+/// <summary>
+/// Same calculation ComponentBoundingBox::Load made before the bounds were
+/// cached: encloses every mesh in the subtree of entity from scratch.
+/// </summary>
+static math::AABB ReferenceLoad(const Entity* entity)
+{
+	math::AABB aabb;
+	aabb.SetNegativeInfinity();
+
+	std::vector<ComponentMesh*> mesh_components = entity->GetComponentsInDescendants<ComponentMesh>();
+	ComponentMesh* owner_mesh_component = entity->GetComponent<ComponentMesh>();
+
+	if (owner_mesh_component != nullptr)
+	{
+		mesh_components.push_back(owner_mesh_component);
+	}
+
+	for (const ComponentMesh* mesh_component : mesh_components)
+	{
+		EncloseReferenceMesh(mesh_component, aabb);
+	}
+
+	return aabb;
+}
+
+/// <summary>
+/// Every ancestor reloaded its bounding box when a descendant changed, as
+/// they all listened to the components changed in descendants event.
+/// </summary>
+/// <returns>Bounds of the root of entity.</returns>
+static math::AABB ReferenceLoadPathToRoot(const Entity* entity)
+{
+	math::AABB aabb;
+
+	for (const Entity* current = entity; current != nullptr; current = current->Parent())
+	{
+		aabb = ReferenceLoad(current);
+	}
+
+	return aabb;
+}
+
+/// <summary>
+/// Creates the unit cube every node of the benchmark hierarchies shares,
+/// with the vertex layout of ModelImporter: position, normal and uv.
+/// </summary>
+static ResourceMesh* CreateCubeMesh()
+{
+	static const float corners[8][3] =
+	{
+		{ -0.5f, -0.5f, -0.5f }, { 0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, -0.5f }, { -0.5f, 0.5f, -0.5f },
+		{ -0.5f, -0.5f,  0.5f }, { 0.5f, -0.5f,  0.5f }, { 0.5f, 0.5f,  0.5f }, { -0.5f, 0.5f,  0.5f },
+	};
+
+	static const unsigned int faces[36] =
+	{
+		0, 2, 1, 0, 3, 2,
+		4, 5, 6, 4, 6, 7,
+		0, 1, 5, 0, 5, 4,
+		3, 6, 2, 3, 7, 6,
+		0, 4, 7, 0, 7, 3,
+		1, 2, 6, 1, 6, 5,
+	};
+
+	// Mesh cache takes the ownership of both:
+	float* vertices = (float*)calloc(8 * 8, sizeof(float));
+	unsigned int* indices = (unsigned int*)calloc(36, sizeof(unsigned int));
+
+	for (int i = 0; i < 8; ++i)
+	{
+		vertices[i * 8 + 0] = corners[i][0];
+		vertices[i * 8 + 1] = corners[i][1];
+		vertices[i * 8 + 2] = corners[i][2];
+	}
+
+	for (int i = 0; i < 36; ++i)
+	{
+		indices[i] = faces[i];
+	}
+
+	return App->scene_manager->GetMeshCache()->Create(ResourceMeshCache::MakePathKey("benchmark_cube", 0), vertices, indices, 8, 36, 12);
+}
+
+/// <summary>
+/// Hierarchy of entities with a cube mesh on each node except the root,
+/// built the way ModelImporter builds a model.
+/// </summary>
+struct BoundingBoxHierarchy
+{
+	Entity* root;
+	std::vector<Entity*> nodes;
+	ResourceMesh* cube;
+	BenchmarkRandom random;
+
+	// Set to reload the reference bounds after each node is added:
+	bool load_reference_while_building;
+	math::AABB reference_aabb;
+
+	BoundingBoxHierarchy(bool load_reference) :
+		root(nullptr),
+		cube(nullptr),
+		random(3),
+		load_reference_while_building(load_reference)
+	{
+		reference_aabb.SetNegativeInfinity();
+	}
+
+	~BoundingBoxHierarchy()
+	{
+		delete root;
+	}
+
+	void Begin()
+	{
+		cube = CreateCubeMesh();
+
+		root = new Entity();
+		root->Initialize("Benchmark Model");
+		root->BeginBatchBuild();
+
+		nodes.push_back(root);
+	}
+
+	Entity* Add(Entity* parent)
+	{
+		Entity* node = new Entity();
+		node->Initialize("Benchmark Node");
+		node->SetParent(parent);
+		node->Transform()->SetLocalPosition(math::float3(random.Range(-50.0f, 50.0f), random.Range(-50.0f, 50.0f), random.Range(-50.0f, 50.0f)));
+
+		ComponentMesh* mesh = new ComponentMesh();
+		mesh->Initialize(node);
+		mesh->Load(cube);
+
+		nodes.push_back(node);
+
+		if (load_reference_while_building)
+		{
+			reference_aabb = ReferenceLoadPathToRoot(node);
+		}
+
+		return node;
+	}
+
+	void End()
+	{
+		root->EndBatchBuild();
+
+		DeferredEventQueue::Flush();
+	}
+};
+
+static void BuildFlatHierarchy(BoundingBoxHierarchy& hierarchy)
+{
+	hierarchy.Begin();
+
+	for (int i = 0; i < BOUNDING_BOX_BENCHMARK_FLAT_NODE_COUNT; ++i)
+	{
+		hierarchy.Add(hierarchy.root);
+	}
+
+	hierarchy.End();
+}
+
+static void BuildTreeHierarchy(BoundingBoxHierarchy& hierarchy, Entity* parent, int depth)
+{
+	if (depth >= BOUNDING_BOX_BENCHMARK_TREE_DEPTH)
+	{
+		return;
+	}
+
+	for (int i = 0; i < BOUNDING_BOX_BENCHMARK_TREE_BRANCHING; ++i)
+	{
+		BuildTreeHierarchy(hierarchy, hierarchy.Add(parent), depth + 1);
+	}
+}
+
+static void BuildTreeHierarchy(BoundingBoxHierarchy& hierarchy)
+{
+	hierarchy.Begin();
+
+	BuildTreeHierarchy(hierarchy, hierarchy.root, 1);
+
+	hierarchy.End();
+}
+
+static bool RootMatches(const BoundingBoxHierarchy& hierarchy, const math::AABB& reference_aabb)
+{
+	const math::AABB aabb = hierarchy.root->BoundingBox()->GetBoundingBox().MinimalEnclosingAABB();
+
+	return aabb.minPoint.Equals(reference_aabb.minPoint, 1e-2f) && aabb.maxPoint.Equals(reference_aabb.maxPoint, 1e-2f);
+}
+
+/// <summary>
+/// Builds the same hierarchy twice, once reloading the reference bounds of
+/// every ancestor after each node is added, and once letting the bounding
+/// boxes refit on the first query, and prints the time both took. Both
+/// times include creating the entities, so the difference between them is
+/// the time spent updating the bounds.
+/// </summary>
+static void RunImportCase(const char* name, void (*build)(BoundingBoxHierarchy&))
+{
+	BenchmarkTimer timer;
+
+	BoundingBoxHierarchy reference_hierarchy(true);
+
+	timer.Start();
+	build(reference_hierarchy);
+	timer.Stop();
+
+	const double reference_milliseconds = timer.Milliseconds();
+
+	BoundingBoxHierarchy hierarchy(false);
+
+	timer.Start();
+	build(hierarchy);
+	hierarchy.root->BoundingBox()->GetBoundingBox();
+	timer.Stop();
+
+	const double cached_milliseconds = timer.Milliseconds();
+
+	printf(" %s model import, %zu entities:\n", name, hierarchy.nodes.size());
+
+	PrintTime("reload every ancestor per added node", reference_milliseconds);
+	PrintTime("refit cached child bounds once", cached_milliseconds);
+	PrintSpeedup("speedup", reference_milliseconds, cached_milliseconds);
+	printf("  %-48s %15s\n", "root bounds match", RootMatches(hierarchy, reference_hierarchy.reference_aabb) ? "yes" : "NO");
+}
+
+/// <summary>
+/// Moves random nodes of hierarchy for BOUNDING_BOX_BENCHMARK_FRAMES frames
+/// with BOUNDING_BOX_BENCHMARK_EDITS_PER_FRAME edits each. The reference
+/// reloads every ancestor of the moved nodes once per frame, as the
+/// deferred events did, while the bounding boxes refit the dirty paths
+/// when the root is queried.
+/// </summary>
+static void RunEditCase(const char* name, void (*build)(BoundingBoxHierarchy&))
+{
+	BoundingBoxHierarchy hierarchy(false);
+	build(hierarchy);
+
+	TransformStore* store = App->scene_manager->GetTransformStore();
+	const size_t node_count = hierarchy.nodes.size();
+
+	BenchmarkRandom random(7);
+	std::vector<Entity*> edited_nodes;
+	std::unordered_set<const Entity*> reloaded_entities;
+	math::AABB reference_aabb;
+
+	double reference_milliseconds = 0.0;
+	double cached_milliseconds = 0.0;
+
+	BenchmarkTimer timer;
+
+	for (int frame = 0; frame < BOUNDING_BOX_BENCHMARK_FRAMES; ++frame)
+	{
+		edited_nodes.clear();
+
+		for (int edit = 0; edit < BOUNDING_BOX_BENCHMARK_EDITS_PER_FRAME; ++edit)
+		{
+			// Never the root, it has no mesh of its own:
+			Entity* node = hierarchy.nodes[1 + (size_t)(random.Float() * (node_count - 1))];
+
+			node->Transform()->SetLocalPosition(math::float3(random.Range(-50.0f, 50.0f), random.Range(-50.0f, 50.0f), random.Range(-50.0f, 50.0f)));
+
+			edited_nodes.push_back(node);
+		}
+
+		// Same world matrices and dirty flags for both:
+		store->UpdateWorldMatrices();
+		DeferredEventQueue::Flush();
+
+		timer.Start();
+
+		reloaded_entities.clear();
+
+		for (const Entity* node : edited_nodes)
+		{
+			for (const Entity* current = node; current != nullptr; current = current->Parent())
+			{
+				if (!reloaded_entities.insert(current).second)
+				{
+					continue;
+				}
+
+				const math::AABB aabb = ReferenceLoad(current);
+
+				if (current == hierarchy.root)
+				{
+					reference_aabb = aabb;
+				}
+			}
+		}
+
+		timer.Stop();
+
+		reference_milliseconds += timer.Milliseconds();
+
+		timer.Start();
+		hierarchy.root->BoundingBox()->GetBoundingBox();
+		timer.Stop();
+
+		cached_milliseconds += timer.Milliseconds();
+	}
+
+	printf(" %s model, %zu entities, %d frames of %d edits:\n",
+		name,
+		node_count,
+		BOUNDING_BOX_BENCHMARK_FRAMES,
+		BOUNDING_BOX_BENCHMARK_EDITS_PER_FRAME);
+
+	PrintTime("reload every ancestor of moved nodes", reference_milliseconds);
+	PrintTime("refit dirty paths of cached bounds", cached_milliseconds);
+	PrintSpeedup("speedup", reference_milliseconds, cached_milliseconds);
+	printf("  %-48s %15s\n", "root bounds match", RootMatches(hierarchy, reference_aabb) ? "yes" : "NO");
+}
+
+void RunBoundingBoxBenchmark()
+{
+	// ResourceMesh uploads its buffers on Load:
+	if (!CreateHiddenGLContext())
+	{
+		printf("  Skipped, needs an OpenGL context.\n");
+		return;
+	}
+
+	RunImportCase("Flat", &BuildFlatHierarchy);
+	RunImportCase("Tree", &BuildTreeHierarchy);
+
+	RunEditCase("Flat", &BuildFlatHierarchy);
+	RunEditCase("Tree", &BuildTreeHierarchy);
+}
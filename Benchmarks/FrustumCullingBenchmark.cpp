@@ -0,0 +1,128 @@
+#include "Benchmark.h"
+
+#include "FrustumCulling.h"
+
+#include "MATH_GEO_LIB/Geometry/AABB.h"
+#include "MATH_GEO_LIB/Geometry/Frustum.h"
+#include "MATH_GEO_LIB/Geometry/OBB.h"
+#include "MATH_GEO_LIB/Math/float3.h"
+
+#include <cstdio>
+#include <vector>
+
+#define FRUSTUM_CULLING_BENCHMARK_VOLUME_COUNT 100000
+#define FRUSTUM_CULLING_BENCHMARK_WORLD_HALF_SIZE 200.0f
+#define FRUSTUM_CULLING_BENCHMARK_FRAMES 60
+
+static void PrintObjectsPerMicrosecond(const char* name, double milliseconds)
+{
+	const double objects = (double)FRUSTUM_CULLING_BENCHMARK_VOLUME_COUNT * FRUSTUM_CULLING_BENCHMARK_FRAMES;
+
+	printf("  %-48s %12.1f objects/us\n", name, milliseconds > 0.0 ? objects / (milliseconds * 1000.0) : 0.0);
+}
+
+void RunFrustumCullingBenchmark()
+{
+	// Scattered boxes of different sizes, as the volumes of the meshes
+	// Scene::GatherCullingVolumes would fill:
+	std::vector<math::OBB> bounding_boxes;
+	bounding_boxes.reserve(FRUSTUM_CULLING_BENCHMARK_VOLUME_COUNT);
+
+	StrawMath::CullingVolumes volumes;
+
+	BenchmarkRandom random(17);
+
+	for (int i = 0; i < FRUSTUM_CULLING_BENCHMARK_VOLUME_COUNT; ++i)
+	{
+		const math::float3 center(
+			random.Range(-FRUSTUM_CULLING_BENCHMARK_WORLD_HALF_SIZE, FRUSTUM_CULLING_BENCHMARK_WORLD_HALF_SIZE),
+			random.Range(-FRUSTUM_CULLING_BENCHMARK_WORLD_HALF_SIZE, FRUSTUM_CULLING_BENCHMARK_WORLD_HALF_SIZE),
+			random.Range(-FRUSTUM_CULLING_BENCHMARK_WORLD_HALF_SIZE, FRUSTUM_CULLING_BENCHMARK_WORLD_HALF_SIZE)
+		);
+		const math::float3 half_size(random.Range(0.1f, 10.0f), random.Range(0.1f, 10.0f), random.Range(0.1f, 10.0f));
+
+		const math::AABB bounding_box(center - half_size, center + half_size);
+
+		bounding_boxes.push_back(math::OBB(bounding_box));
+		volumes.Add(bounding_box, half_size.Length());
+	}
+
+	std::vector<unsigned int> scalar_visibility;
+	std::vector<unsigned int> simd_visibility;
+	std::vector<unsigned int> obb_visibility((FRUSTUM_CULLING_BENCHMARK_VOLUME_COUNT + 31) / 32);
+
+	double obb_milliseconds = 0.0;
+	double scalar_milliseconds = 0.0;
+	double simd_milliseconds = 0.0;
+
+	size_t visible_count = 0;
+	size_t mismatch_count = 0;
+	size_t missed_count = 0;
+
+	BenchmarkTimer timer;
+
+	for (int frame = 0; frame < FRUSTUM_CULLING_BENCHMARK_FRAMES; ++frame)
+	{
+		// Turn the camera a full circle over the frames:
+		const math::Frustum frustum = CreateBenchmarkFrustum(frame * (6.2831853f / FRUSTUM_CULLING_BENCHMARK_FRAMES), 200.0f);
+
+		// Same test ComponentCamera::DoesOBBIntersectFrustum makes for each
+		// mesh:
+		timer.Start();
+
+		for (size_t i = 0; i < bounding_boxes.size(); ++i)
+		{
+			if (bounding_boxes[i].Intersects(frustum))
+			{
+				obb_visibility[i / 32] |= 1u << (i % 32);
+			}
+			else
+			{
+				obb_visibility[i / 32] &= ~(1u << (i % 32));
+			}
+		}
+
+		timer.Stop();
+
+		obb_milliseconds += timer.Milliseconds();
+
+		timer.Start();
+		StrawMath::CullVolumesScalar(frustum, volumes, scalar_visibility);
+		timer.Stop();
+
+		scalar_milliseconds += timer.Milliseconds();
+
+		timer.Start();
+		StrawMath::CullVolumes(frustum, volumes, simd_visibility);
+		timer.Stop();
+
+		simd_milliseconds += timer.Milliseconds();
+
+		// Scalar and SIMD kernels must agree, and both must keep every
+		// volume the exact test finds visible:
+		for (size_t i = 0; i < bounding_boxes.size(); ++i)
+		{
+			const bool is_simd_visible = StrawMath::IsVisible(simd_visibility, i);
+
+			mismatch_count += StrawMath::IsVisible(scalar_visibility, i) != is_simd_visible ? 1 : 0;
+			missed_count += StrawMath::IsVisible(obb_visibility, i) && !is_simd_visible ? 1 : 0;
+			visible_count += is_simd_visible ? 1 : 0;
+		}
+	}
+
+	printf(" %d volumes, %d frames, %zu visible per frame on average:\n",
+		FRUSTUM_CULLING_BENCHMARK_VOLUME_COUNT,
+		FRUSTUM_CULLING_BENCHMARK_FRAMES,
+		visible_count / FRUSTUM_CULLING_BENCHMARK_FRAMES);
+
+	PrintTime("OBB::Intersects(Frustum) per object", obb_milliseconds);
+	PrintTime("CullVolumesScalar", scalar_milliseconds);
+	PrintTime("CullVolumes", simd_milliseconds);
+	PrintObjectsPerMicrosecond("OBB::Intersects(Frustum) per object", obb_milliseconds);
+	PrintObjectsPerMicrosecond("CullVolumesScalar", scalar_milliseconds);
+	PrintObjectsPerMicrosecond("CullVolumes", simd_milliseconds);
+	PrintSpeedup("CullVolumes over CullVolumesScalar", scalar_milliseconds, simd_milliseconds);
+	PrintSpeedup("CullVolumes over OBB::Intersects", obb_milliseconds, simd_milliseconds);
+	printf("  %-48s %15zu\n", "scalar and SIMD mismatches", mismatch_count);
+	printf("  %-48s %15zu\n", "visible volumes culled", missed_count);
+}
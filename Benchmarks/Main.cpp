@@ -0,0 +1,83 @@
+#include "Benchmark.h"
+
+#include "Application.h"
+#include "Globals.h"
+
+#include <cstdio>
+#include <cstring>
+
+// Globals the engine sources expect, defined inside Main.cpp of Engine:
+Console* console = NULL;
+TimeManager* Time = NULL;
+Application* App = NULL;
+
+struct benchmark_entry
+{
+	const char* name;
+	void (*run)();
+};
+
+static const benchmark_entry benchmarks[] =
+{
+	{ "transform_propagation", &RunTransformPropagationBenchmark },
+	{ "bounding_box", &RunBoundingBoxBenchmark },
+	{ "visible_set", &RunVisibleSetBenchmark },
+	{ "quad_tree", &RunQuadTreeBenchmark },
+	{ "frustum_culling", &RunFrustumCullingBenchmark },
+	{ "ray_picking", &RunRayPickingBenchmark },
+	{ "parallel_culling", &RunParallelCullingBenchmark },
+};
+
+static bool ShouldRun(const char* name, int argc, char** argv)
+{
+	// Run everything if no benchmark is named:
+	if (argc <= 1)
+	{
+		return true;
+	}
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], name) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int main(int argc, char** argv)
+{
+	console = new Console();
+	Time = new TimeManager();
+
+	// Application is created but never initialized, so no window is opened
+	// and no module runs. Entities only need the TransformStore and the
+	// ResourceMeshCache of ModuleSceneManager, which are created with it:
+	App = new Application();
+
+	for (const benchmark_entry& benchmark : benchmarks)
+	{
+		if (!ShouldRun(benchmark.name, argc, argv))
+		{
+			continue;
+		}
+
+		printf("%s\n", benchmark.name);
+
+		benchmark.run();
+
+		printf("\n");
+	}
+
+	// Resources of ModuleSceneManager are destroyed with App, while the
+	// context is still there:
+	delete App;
+	delete Time;
+	delete console;
+
+	DestroyHiddenGLContext();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+#include "Benchmark.h"
+
+#include "FrustumCulling.h"
+#include "Scene.h"
+#include "WorkerPool.h"
+
+#include "MATH_GEO_LIB/Geometry/AABB.h"
+#include "MATH_GEO_LIB/Geometry/Frustum.h"
+#include "MATH_GEO_LIB/Geometry/OBB.h"
+#include "MATH_GEO_LIB/Math/float3.h"
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#define PARALLEL_CULLING_BENCHMARK_VOLUME_COUNT 200000
+#define PARALLEL_CULLING_BENCHMARK_WORLD_HALF_SIZE 300.0f
+#define PARALLEL_CULLING_BENCHMARK_FRAMES 60
+
+/// <summary>
+/// Gathers the culling volumes of the boxes in [begin, end) and culls them,
+/// the same job Scene::CullMeshes gives each chunk.
+/// </summary>
+static void CullChunk(
+	const math::Frustum& frustum,
+	const std::vector<math::OBB>& bounding_boxes,
+	size_t begin,
+	size_t end,
+	StrawMath::CullingVolumes& volumes,
+	std::vector<unsigned int>& visibility)
+{
+	for (size_t i = begin; i < end; ++i)
+	{
+		volumes.Set(i, bounding_boxes[i].MinimalEnclosingAABB(), bounding_boxes[i].HalfDiagonal().Length());
+	}
+
+	StrawMath::CullVolumes(frustum, volumes, begin, end, visibility);
+}
+
+/// <summary>
+/// Culls the boxes for every frame with thread_count threads, the calling
+/// thread and thread_count - 1 workers, in chunks of SCENE_CULLING_CHUNK_SIZE.
+/// </summary>
+/// <returns>Milliseconds all the frames took.</returns>
+static double CullOnThreads(
+	size_t thread_count,
+	const std::vector<math::OBB>& bounding_boxes,
+	StrawMath::CullingVolumes& volumes,
+	std::vector<unsigned int>& visibility)
+{
+	// A WorkerPool of 0 workers would create one per hardware thread, so
+	// the single thread case runs the chunks on the calling thread:
+	WorkerPool* worker_pool = thread_count > 1 ? new WorkerPool(thread_count - 1) : nullptr;
+
+	BenchmarkTimer timer;
+	timer.Start();
+
+	for (int frame = 0; frame < PARALLEL_CULLING_BENCHMARK_FRAMES; ++frame)
+	{
+		// Turn the camera a full circle over the frames:
+		const math::Frustum frustum = CreateBenchmarkFrustum(frame * (6.2831853f / PARALLEL_CULLING_BENCHMARK_FRAMES), 200.0f);
+
+		auto cull_chunk = [&frustum, &bounding_boxes, &volumes, &visibility](size_t begin, size_t end)
+		{
+			CullChunk(frustum, bounding_boxes, begin, end, volumes, visibility);
+		};
+
+		if (worker_pool != nullptr)
+		{
+			worker_pool->ParallelFor(bounding_boxes.size(), SCENE_CULLING_CHUNK_SIZE, cull_chunk);
+		}
+		else
+		{
+			for (size_t begin = 0; begin < bounding_boxes.size(); begin += SCENE_CULLING_CHUNK_SIZE)
+			{
+				size_t end = begin + SCENE_CULLING_CHUNK_SIZE < bounding_boxes.size() ? begin + SCENE_CULLING_CHUNK_SIZE : bounding_boxes.size();
+				cull_chunk(begin, end);
+			}
+		}
+	}
+
+	timer.Stop();
+
+	delete worker_pool;
+
+	return timer.Milliseconds();
+}
+
+void RunParallelCullingBenchmark()
+{
+	// Scattered boxes of different sizes, as the bounding boxes of the
+	// dynamic meshes Scene::GatherCullingVolumes reads:
+	std::vector<math::OBB> bounding_boxes;
+	bounding_boxes.reserve(PARALLEL_CULLING_BENCHMARK_VOLUME_COUNT);
+
+	BenchmarkRandom random(23);
+
+	for (int i = 0; i < PARALLEL_CULLING_BENCHMARK_VOLUME_COUNT; ++i)
+	{
+		const math::float3 center(
+			random.Range(-PARALLEL_CULLING_BENCHMARK_WORLD_HALF_SIZE, PARALLEL_CULLING_BENCHMARK_WORLD_HALF_SIZE),
+			random.Range(-PARALLEL_CULLING_BENCHMARK_WORLD_HALF_SIZE, PARALLEL_CULLING_BENCHMARK_WORLD_HALF_SIZE),
+			random.Range(-PARALLEL_CULLING_BENCHMARK_WORLD_HALF_SIZE, PARALLEL_CULLING_BENCHMARK_WORLD_HALF_SIZE)
+		);
+		const math::float3 half_size(random.Range(0.1f, 10.0f), random.Range(0.1f, 10.0f), random.Range(0.1f, 10.0f));
+
+		bounding_boxes.push_back(math::OBB(math::AABB(center - half_size, center + half_size)));
+	}
+
+	size_t max_thread_count = std::thread::hardware_concurrency();
+	max_thread_count = max_thread_count > 0 ? max_thread_count : 1;
+
+	printf(" %d volumes, %d frames, chunks of %d, 1 to %zu threads:\n",
+		PARALLEL_CULLING_BENCHMARK_VOLUME_COUNT,
+		PARALLEL_CULLING_BENCHMARK_FRAMES,
+		SCENE_CULLING_CHUNK_SIZE,
+		max_thread_count);
+
+	StrawMath::CullingVolumes single_thread_volumes;
+	single_thread_volumes.Resize(bounding_boxes.size());
+	std::vector<unsigned int> single_thread_visibility((bounding_boxes.size() + 31) / 32);
+
+	const double single_thread_milliseconds = CullOnThreads(1, bounding_boxes, single_thread_volumes, single_thread_visibility);
+
+	PrintTime("1 thread", single_thread_milliseconds);
+
+	StrawMath::CullingVolumes volumes;
+	std::vector<unsigned int> visibility;
+
+	char name[64];
+	bool matches = true;
+
+	for (size_t thread_count = 2; thread_count <= max_thread_count; ++thread_count)
+	{
+		volumes.Resize(bounding_boxes.size());
+		visibility.assign((bounding_boxes.size() + 31) / 32, 0u);
+
+		const double milliseconds = CullOnThreads(thread_count, bounding_boxes, volumes, visibility);
+
+		snprintf(name, sizeof(name), "%zu threads", thread_count);
+		PrintTime(name, milliseconds);
+
+		snprintf(name, sizeof(name), "%zu threads over 1 thread", thread_count);
+		PrintSpeedup(name, single_thread_milliseconds, milliseconds);
+
+		// Every thread count culls the last frame, so the chunks must
+		// leave the same bitset as the single thread:
+		matches = matches && visibility == single_thread_visibility;
+	}
+
+	printf("  %-48s %15s\n", "visibility matches 1 thread", matches ? "yes" : "NO");
+}
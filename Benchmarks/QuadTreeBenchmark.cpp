@@ -0,0 +1,424 @@
+#include "Benchmark.h"
+
+#include "Application.h"
+#include "ModuleSceneManager.h"
+#include "Entity.h"
+#include "ComponentBoundingBox.h"
+#include "ComponentTransform.h"
+#include "TransformStore.h"
+#include "QuadTree.h"
+#include "Event.h"
+
+#include "MATH_GEO_LIB/Geometry/AABB.h"
+#include "MATH_GEO_LIB/Geometry/Frustum.h"
+#include "MATH_GEO_LIB/Geometry/OBB.h"
+#include "MATH_GEO_LIB/Math/float3.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#define QUADTREE_BENCHMARK_ENTITY_COUNT 50000
+#define QUADTREE_BENCHMARK_WORLD_HALF_SIZE 1000.0f
+#define QUADTREE_BENCHMARK_WORLD_HALF_HEIGHT 50.0f
+#define QUADTREE_BENCHMARK_QUERIES 240
+#define QUADTREE_BENCHMARK_REBUILDS 10
+
+// Same limits QuadTree had before its nodes were pooled:
+#define REFERENCE_QUADTREE_MAX_ITEMS 8
+#define REFERENCE_QUADTREE_MIN_SIZE 10.0f
+
+class ReferenceQuadTree;
+
+/// <summary>
+/// QuadTreeNode as it was before the nodes were pooled: each child is
+/// allocated with new, entities are kept in a std::list and queries reach
+/// the OBB of each entity through its bounding box component.
+/// </summary>
+class ReferenceQuadTreeNode
+{
+public:
+	ReferenceQuadTree* tree;
+	ReferenceQuadTreeNode* children[4];
+	std::list<Entity*> entities;
+	math::AABB container;
+
+	ReferenceQuadTreeNode(ReferenceQuadTree* new_tree, const math::AABB& new_container) :
+		tree(new_tree),
+		container(new_container)
+	{
+		children[0] = children[1] = children[2] = children[3] = nullptr;
+	}
+
+	~ReferenceQuadTreeNode()
+	{
+		for (size_t i = 0; i < 4; ++i)
+		{
+			delete children[i];
+		}
+	}
+
+	bool IsLeaf() const { return children[0] == nullptr; }
+
+	void CreateChildren();
+	void Insert(Entity* const entity);
+	void DistributeChildren();
+
+	template<typename INTERSECTABLE_T>
+	void FillWithIntersections(std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const
+	{
+		if (!intersectable.Intersects(container))
+		{
+			return;
+		}
+
+		for (Entity* entity : entities)
+		{
+			if (intersectable.Intersects(entity->BoundingBox()->GetBoundingBox()))
+			{
+				intersecting_entities.push_back(entity);
+			}
+		}
+
+		if (IsLeaf())
+		{
+			return;
+		}
+
+		for (size_t i = 0; i < 4; ++i)
+		{
+			children[i]->FillWithIntersections(intersecting_entities, intersectable);
+		}
+	}
+};
+
+/// <summary>
+/// QuadTree as it was before the nodes were pooled, keeping the inserted
+/// AABB and the nodes of each entity in a map.
+/// </summary>
+class ReferenceQuadTree
+{
+public:
+	struct EntityEntry
+	{
+		math::AABB bounding_box;
+		std::vector<ReferenceQuadTreeNode*> nodes;
+	};
+
+	ReferenceQuadTreeNode* root_node;
+	std::unordered_map<const Entity*, EntityEntry> entity_entries;
+
+	ReferenceQuadTree() : root_node(nullptr) {};
+	~ReferenceQuadTree() { CleanUp(); };
+
+	void SetContainer(const math::AABB& new_container)
+	{
+		CleanUp();
+
+		root_node = new ReferenceQuadTreeNode(this, new_container);
+	}
+
+	bool Insert(Entity* const entity)
+	{
+		const math::AABB entity_aabb = entity->BoundingBox()->GetBoundingBox().MinimalEnclosingAABB();
+
+		if (root_node == nullptr || !root_node->container.Contains(entity_aabb))
+		{
+			return false;
+		}
+
+		entity_entries[entity].bounding_box = entity_aabb;
+
+		root_node->Insert(entity);
+
+		return true;
+	}
+
+	void CleanUp()
+	{
+		delete root_node;
+
+		root_node = nullptr;
+
+		entity_entries.clear();
+	}
+
+	template<typename INTERSECTABLE_T>
+	void FillWithIntersections(std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const
+	{
+		if (root_node != nullptr)
+		{
+			root_node->FillWithIntersections(intersecting_entities, intersectable);
+		}
+	}
+
+	void AddNodeReference(const Entity* entity, ReferenceQuadTreeNode* node)
+	{
+		entity_entries[entity].nodes.push_back(node);
+	}
+
+	void RemoveNodeReference(const Entity* entity, ReferenceQuadTreeNode* node)
+	{
+		std::vector<ReferenceQuadTreeNode*>& nodes = entity_entries[entity].nodes;
+		std::vector<ReferenceQuadTreeNode*>::iterator index = std::find(nodes.begin(), nodes.end(), node);
+
+		if (index != nodes.end())
+		{
+			*index = nodes.back();
+			nodes.pop_back();
+		}
+	}
+};
+
+void ReferenceQuadTreeNode::CreateChildren()
+{
+	const math::float3 size = container.Size();
+	const math::float3 new_size(size.x * 0.5f, size.y, size.z * 0.5f);
+	const math::float3 center = container.CenterPoint();
+
+	// NE, SE, SW and NW, in the order QuadTree created them:
+	static const float offsets[4][2] = { { 0.25f, 0.25f }, { 0.25f, -0.25f }, { -0.25f, -0.25f }, { -0.25f, 0.25f } };
+
+	for (size_t i = 0; i < 4; ++i)
+	{
+		const math::float3 new_center(center.x + size.x * offsets[i][0], center.y, center.z + size.z * offsets[i][1]);
+
+		children[i] = new ReferenceQuadTreeNode(tree, math::AABB::FromCenterAndSize(new_center, new_size));
+	}
+}
+
+void ReferenceQuadTreeNode::Insert(Entity* const entity)
+{
+	const bool is_container_smaller_than_max_box_size = container.HalfSize().LengthSq() <= REFERENCE_QUADTREE_MIN_SIZE * REFERENCE_QUADTREE_MIN_SIZE;
+	const bool has_less_than_maximum_items = entities.size() < REFERENCE_QUADTREE_MAX_ITEMS;
+
+	if (IsLeaf() && (has_less_than_maximum_items || is_container_smaller_than_max_box_size))
+	{
+		entities.push_back(entity);
+		tree->AddNodeReference(entity, this);
+
+		return;
+	}
+
+	if (IsLeaf())
+	{
+		CreateChildren();
+	}
+
+	entities.push_back(entity);
+	tree->AddNodeReference(entity, this);
+
+	DistributeChildren();
+}
+
+void ReferenceQuadTreeNode::DistributeChildren()
+{
+	for (std::list<Entity*>::iterator iterator = entities.begin(); iterator != entities.end();)
+	{
+		Entity* entity = *iterator;
+
+		const math::AABB& bounding_box = tree->entity_entries.at(entity).bounding_box;
+
+		bool intersections[4];
+		for (size_t i = 0; i < 4; ++i)
+		{
+			intersections[i] = bounding_box.Intersects(children[i]->container);
+		}
+
+		// Entities overlapping all the children stay in this node:
+		if (intersections[0] && intersections[1] && intersections[2] && intersections[3])
+		{
+			++iterator;
+			continue;
+		}
+
+		iterator = entities.erase(iterator);
+		tree->RemoveNodeReference(entity, this);
+
+		for (size_t i = 0; i < 4; ++i)
+		{
+			if (intersections[i])
+			{
+				children[i]->Insert(entity);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Sets the container of tree to container and inserts all the entities.
+/// </summary>
+template<typename TREE_T>
+static void FillTree(TREE_T& tree, const math::AABB& container, const std::vector<Entity*>& entities)
+{
+	tree.SetContainer(container);
+
+	for (Entity* entity : entities)
+	{
+		tree.Insert(entity);
+	}
+}
+
+/// <summary>
+/// Runs QUADTREE_BENCHMARK_QUERIES frustum queries on tree, turning the
+/// camera a full circle. The result of the last query is left in
+/// intersecting_entities.
+/// </summary>
+template<typename TREE_T>
+static void QueryTree(const TREE_T& tree, std::vector<Entity*>& intersecting_entities)
+{
+	for (int query = 0; query < QUADTREE_BENCHMARK_QUERIES; ++query)
+	{
+		const math::Frustum frustum = CreateBenchmarkFrustum(query * (6.2831853f / QUADTREE_BENCHMARK_QUERIES), 500.0f);
+
+		intersecting_entities.clear();
+		tree.FillWithIntersections(intersecting_entities, frustum);
+	}
+}
+
+/// <summary>
+/// Counts the distinct entities of entities, as both trees may find an
+/// entity more than once if it's in more than one node.
+/// </summary>
+static size_t CountDistinct(const std::vector<Entity*>& entities)
+{
+	std::unordered_set<const Entity*> distinct_entities(entities.begin(), entities.end());
+
+	return distinct_entities.size();
+}
+
+static void PrintComparison(const char* name, double reference_milliseconds, double pooled_milliseconds)
+{
+	printf(" %s:\n", name);
+
+	PrintTime("pointer nodes, std::list entities", reference_milliseconds);
+	PrintTime("pooled nodes, inline items", pooled_milliseconds);
+	PrintSpeedup("speedup", reference_milliseconds, pooled_milliseconds);
+}
+
+void RunQuadTreeBenchmark()
+{
+	// Scatter the entities under one root. They have no meshes, so each
+	// one keeps the 1 unit cube its bounding box has as a placeholder:
+	Entity* root = new Entity();
+	root->Initialize("Benchmark Scene");
+	root->BeginBatchBuild();
+
+	std::vector<Entity*> entities;
+	entities.reserve(QUADTREE_BENCHMARK_ENTITY_COUNT);
+
+	BenchmarkRandom random(13);
+
+	for (int i = 0; i < QUADTREE_BENCHMARK_ENTITY_COUNT; ++i)
+	{
+		Entity* entity = new Entity();
+		entity->Initialize("Benchmark Entity");
+		entity->SetParent(root);
+		entity->Transform()->SetLocalPosition(math::float3(
+			random.Range(-QUADTREE_BENCHMARK_WORLD_HALF_SIZE, QUADTREE_BENCHMARK_WORLD_HALF_SIZE),
+			random.Range(-QUADTREE_BENCHMARK_WORLD_HALF_HEIGHT, QUADTREE_BENCHMARK_WORLD_HALF_HEIGHT),
+			random.Range(-QUADTREE_BENCHMARK_WORLD_HALF_SIZE, QUADTREE_BENCHMARK_WORLD_HALF_SIZE)
+		));
+
+		entities.push_back(entity);
+	}
+
+	root->EndBatchBuild();
+
+	App->scene_manager->GetTransformStore()->UpdateWorldMatrices();
+	DeferredEventQueue::Flush();
+
+	// Refit every bounding box before timing anything:
+	root->BoundingBox()->GetBoundingBox();
+
+	math::AABB container;
+	container.SetNegativeInfinity();
+
+	for (const Entity* entity : entities)
+	{
+		container.Enclose(entity->BoundingBox()->GetBoundingBox());
+	}
+
+	ReferenceQuadTree reference_tree;
+	StrawMath::QuadTree pooled_tree;
+
+	BenchmarkTimer timer;
+
+	// Insert into empty trees:
+	timer.Start();
+	FillTree(reference_tree, container, entities);
+	timer.Stop();
+
+	const double reference_insert_milliseconds = timer.Milliseconds();
+
+	timer.Start();
+	FillTree(pooled_tree, container, entities);
+	timer.Stop();
+
+	const double pooled_insert_milliseconds = timer.Milliseconds();
+
+	// Query both:
+	std::vector<Entity*> intersecting_entities;
+	intersecting_entities.reserve(entities.size());
+
+	timer.Start();
+	QueryTree(reference_tree, intersecting_entities);
+	timer.Stop();
+
+	const double reference_query_milliseconds = timer.Milliseconds();
+	const size_t reference_found_count = CountDistinct(intersecting_entities);
+
+	timer.Start();
+	QueryTree(pooled_tree, intersecting_entities);
+	timer.Stop();
+
+	const double pooled_query_milliseconds = timer.Milliseconds();
+	const size_t pooled_found_count = CountDistinct(intersecting_entities);
+
+	// Rebuild both from scratch, as Scene::RebuildSpatialIndex does:
+	timer.Start();
+
+	for (int rebuild = 0; rebuild < QUADTREE_BENCHMARK_REBUILDS; ++rebuild)
+	{
+		reference_tree.CleanUp();
+		FillTree(reference_tree, container, entities);
+	}
+
+	timer.Stop();
+
+	const double reference_rebuild_milliseconds = timer.Milliseconds();
+
+	timer.Start();
+
+	for (int rebuild = 0; rebuild < QUADTREE_BENCHMARK_REBUILDS; ++rebuild)
+	{
+		pooled_tree.CleanUp();
+		FillTree(pooled_tree, container, entities);
+	}
+
+	timer.Stop();
+
+	const double pooled_rebuild_milliseconds = timer.Milliseconds();
+
+	printf(" %d scattered entities:\n", QUADTREE_BENCHMARK_ENTITY_COUNT);
+
+	char name[64];
+
+	snprintf(name, sizeof(name), "Insert %d entities", QUADTREE_BENCHMARK_ENTITY_COUNT);
+	PrintComparison(name, reference_insert_milliseconds, pooled_insert_milliseconds);
+
+	snprintf(name, sizeof(name), "%d frustum queries", QUADTREE_BENCHMARK_QUERIES);
+	PrintComparison(name, reference_query_milliseconds, pooled_query_milliseconds);
+	printf("  %-48s %15s\n", "found entities match", reference_found_count == pooled_found_count ? "yes" : "NO");
+
+	snprintf(name, sizeof(name), "%d rebuilds", QUADTREE_BENCHMARK_REBUILDS);
+	PrintComparison(name, reference_rebuild_milliseconds, pooled_rebuild_milliseconds);
+
+	reference_tree.CleanUp();
+	pooled_tree.CleanUp();
+
+	delete root;
+}
@@ -0,0 +1,209 @@
+#include "Benchmark.h"
+
+#include "PackedTriangles.h"
+#include "TriangleBVH.h"
+
+#include "MATH_GEO_LIB/Geometry/LineSegment.h"
+#include "MATH_GEO_LIB/Geometry/Triangle.h"
+#include "MATH_GEO_LIB/Math/float3.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#define RAY_PICKING_BENCHMARK_PICKS 200
+#define RAY_PICKING_BENCHMARK_BVH_REPEATS 50
+#define RAY_PICKING_BENCHMARK_CAMERA_DISTANCE 20.0f
+
+/// <summary>
+/// Point on a sphere of radius 5 with bumps on it, so that the triangles
+/// are not all the same size and the tree is not perfectly regular.
+/// </summary>
+static math::float3 BumpySpherePoint(int ring, int segment, int ring_count, int segment_count)
+{
+	const float theta = 3.14159265f * ring / ring_count;
+	const float phi = 6.2831853f * segment / segment_count;
+	const float radius = 5.0f + 0.3f * sinf(7.0f * theta) * cosf(5.0f * phi);
+
+	return math::float3(radius * sinf(theta) * cosf(phi), radius * cosf(theta), radius * sinf(theta) * sinf(phi));
+}
+
+static void BuildBumpySphere(int ring_count, int segment_count, math::TriangleArray& triangles)
+{
+	triangles.clear();
+
+	for (int ring = 0; ring < ring_count; ++ring)
+	{
+		for (int segment = 0; segment < segment_count; ++segment)
+		{
+			const math::float3 a = BumpySpherePoint(ring, segment, ring_count, segment_count);
+			const math::float3 b = BumpySpherePoint(ring + 1, segment, ring_count, segment_count);
+			const math::float3 c = BumpySpherePoint(ring + 1, segment + 1, ring_count, segment_count);
+			const math::float3 d = BumpySpherePoint(ring, segment + 1, ring_count, segment_count);
+
+			triangles.push_back(math::Triangle(a, b, c));
+			triangles.push_back(math::Triangle(a, c, d));
+		}
+	}
+}
+
+/// <summary>
+/// Same search Scene::CheckRaycast made for each mesh before the BVH:
+/// every triangle is tested against the segment.
+/// </summary>
+/// <returns>Distance of the closest hit along the segment, -1 if nothing is hit.</returns>
+static float PickBruteForce(const math::TriangleArray& triangles, const math::LineSegment& segment)
+{
+	float best_distance = 1.0f;
+	bool is_hit = false;
+
+	for (const math::Triangle& triangle : triangles)
+	{
+		float distance;
+		math::float3 hit_point = math::float3::zero;
+
+		if (segment.Intersects(triangle, &distance, &hit_point) && distance < best_distance)
+		{
+			best_distance = distance;
+			is_hit = true;
+		}
+	}
+
+	return is_hit ? best_distance : -1.0f;
+}
+
+/// <returns>Distance of the closest hit along the segment, -1 if nothing is hit.</returns>
+static float PickBVH(const StrawMath::TriangleBVH& bvh, const math::LineSegment& segment)
+{
+	StrawMath::TriangleHit hit;
+	hit.distance = 1.0f;
+	hit.triangle_index = TRIANGLE_HIT_INVALID_INDEX;
+
+	return bvh.Intersects(segment, hit) ? hit.distance : -1.0f;
+}
+
+/// <summary>
+/// Closest hit of segment on every triangle of packed_triangles, through the
+/// scalar or the SSE kernel.
+/// </summary>
+/// <returns>Distance of the closest hit along the segment, -1 if nothing is hit.</returns>
+static float PickPacked(const StrawMath::PackedTriangles& packed_triangles, const math::LineSegment& segment, bool is_scalar)
+{
+	StrawMath::TriangleHit hit;
+	hit.distance = 1.0f;
+	hit.triangle_index = TRIANGLE_HIT_INVALID_INDEX;
+
+	const bool is_hit = is_scalar ?
+		StrawMath::IntersectPackedTrianglesScalar(packed_triangles, 0, packed_triangles.Size(), segment, hit) :
+		StrawMath::IntersectPackedTriangles(packed_triangles, 0, packed_triangles.Size(), segment, hit);
+
+	return is_hit ? hit.distance : -1.0f;
+}
+
+/// <summary>
+/// Picks a mesh of ring_count x segment_count quads with segments from
+/// random points around it towards its center, first by brute force and
+/// then through a TriangleBVH, and prints picks per second of both.
+/// </summary>
+static void RunPickingCase(const char* name, int ring_count, int segment_count)
+{
+	math::TriangleArray triangles;
+	BuildBumpySphere(ring_count, segment_count, triangles);
+
+	BenchmarkTimer timer;
+
+	StrawMath::TriangleBVH bvh;
+
+	timer.Start();
+	bvh.Build(triangles);
+	timer.Stop();
+
+	const double build_milliseconds = timer.Milliseconds();
+
+	// Segments from points around the mesh towards random points near its
+	// center, some of them miss it:
+	std::vector<math::LineSegment> segments;
+	segments.reserve(RAY_PICKING_BENCHMARK_PICKS);
+
+	BenchmarkRandom random(19);
+
+	for (int i = 0; i < RAY_PICKING_BENCHMARK_PICKS; ++i)
+	{
+		const math::float3 direction = math::float3(random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f)).Normalized();
+		const math::float3 start = direction * RAY_PICKING_BENCHMARK_CAMERA_DISTANCE;
+		const math::float3 target(random.Range(-7.0f, 7.0f), random.Range(-7.0f, 7.0f), random.Range(-7.0f, 7.0f));
+
+		segments.push_back(math::LineSegment(start, start + (target - start) * 2.0f));
+	}
+
+	std::vector<float> brute_force_distances(segments.size());
+	std::vector<float> bvh_distances(segments.size());
+
+	timer.Start();
+
+	for (size_t i = 0; i < segments.size(); ++i)
+	{
+		brute_force_distances[i] = PickBruteForce(triangles, segments[i]);
+	}
+
+	timer.Stop();
+
+	const double brute_force_seconds = timer.Seconds();
+
+	timer.Start();
+
+	for (int repeat = 0; repeat < RAY_PICKING_BENCHMARK_BVH_REPEATS; ++repeat)
+	{
+		for (size_t i = 0; i < segments.size(); ++i)
+		{
+			bvh_distances[i] = PickBVH(bvh, segments[i]);
+		}
+	}
+
+	timer.Stop();
+
+	const double bvh_seconds = timer.Seconds() / RAY_PICKING_BENCHMARK_BVH_REPEATS;
+
+	// Both kernels on their own, over every triangle of the mesh, must
+	// find the same closest hits as the tree:
+	StrawMath::PackedTriangles packed_triangles;
+
+	for (const math::Triangle& triangle : triangles)
+	{
+		packed_triangles.Add(triangle);
+	}
+
+	size_t hit_count = 0;
+	size_t mismatch_count = 0;
+	size_t kernel_mismatch_count = 0;
+
+	for (size_t i = 0; i < segments.size(); ++i)
+	{
+		const float scalar_distance = PickPacked(packed_triangles, segments[i], true);
+		const float sse_distance = PickPacked(packed_triangles, segments[i], false);
+
+		hit_count += brute_force_distances[i] >= 0.0f ? 1 : 0;
+		mismatch_count += fabsf(brute_force_distances[i] - bvh_distances[i]) > 1e-5f ? 1 : 0;
+		kernel_mismatch_count += fabsf(scalar_distance - sse_distance) > 1e-5f || fabsf(scalar_distance - bvh_distances[i]) > 1e-5f ? 1 : 0;
+	}
+
+	printf(" %s mesh, %zu triangles, %zu nodes, %zu of %zu picks hit:\n",
+		name,
+		triangles.size(),
+		bvh.GetNodeCount(),
+		hit_count,
+		segments.size());
+
+	PrintTime("TriangleBVH build", build_milliseconds);
+	printf("  %-48s %12.0f picks/s\n", "every triangle per pick", brute_force_seconds > 0.0 ? segments.size() / brute_force_seconds : 0.0);
+	printf("  %-48s %12.0f picks/s\n", "TriangleBVH", bvh_seconds > 0.0 ? segments.size() / bvh_seconds : 0.0);
+	PrintSpeedup("speedup", brute_force_seconds, bvh_seconds);
+	printf("  %-48s %15zu\n", "closest hit mismatches", mismatch_count);
+	printf("  %-48s %15zu\n", "scalar and SSE kernel mismatches", kernel_mismatch_count);
+}
+
+void RunRayPickingBenchmark()
+{
+	RunPickingCase("Low poly", 40, 40);
+	RunPickingCase("High poly", 300, 300);
+}
@@ -0,0 +1,237 @@
+#include "Benchmark.h"
+
+#include "TransformStore.h"
+
+#include "MATH_GEO_LIB/Math/float3.h"
+#include "MATH_GEO_LIB/Math/float4x4.h"
+#include "MATH_GEO_LIB/Math/Quat.h"
+
+#include <cstdio>
+#include <vector>
+
+#define TRANSFORM_BENCHMARK_NODE_COUNT 10000
+#define TRANSFORM_BENCHMARK_TREE_BRANCHING 4
+#define TRANSFORM_BENCHMARK_TREE_DEPTH 7
+#define TRANSFORM_BENCHMARK_FRAMES 60
+#define TRANSFORM_BENCHMARK_EDITS_PER_FRAME 4
+
+/// <summary>
+/// Transform as it was kept by ComponentTransform before TransformStore,
+/// every setter recalculated the whole subtree right away.
+/// </summary>
+struct ReferenceTransform
+{
+	math::float3 position_local;
+	math::Quat rotation_local;
+	math::float3 scale_local;
+	math::float4x4 matrix_local;
+	math::float4x4 matrix;
+	math::float3 position;
+	math::Quat rotation;
+	math::float3 scale;
+	math::float3 rotation_euler;
+	math::float3 right;
+	math::float3 up;
+	math::float3 front;
+	int parent;
+	std::vector<int> children;
+};
+
+/// <summary>
+/// Same calculation ComponentTransform::UpdateTransformOfHierarchy made for
+/// each descendant: FromTRS, parent multiplication, Decompose and ToEulerXYZ.
+/// </summary>
+static void UpdateReferenceHierarchy(std::vector<ReferenceTransform>& transforms, int index)
+{
+	ReferenceTransform& transform = transforms[index];
+
+	transform.matrix_local = math::float4x4::FromTRS(transform.position_local, transform.rotation_local, transform.scale_local);
+
+	transform.matrix = transform.parent < 0 ?
+		transform.matrix_local :
+		transforms[transform.parent].matrix * transform.matrix_local;
+
+	transform.matrix.Decompose(transform.position, transform.rotation, transform.scale);
+
+	transform.rotation_euler = math::RadToDeg(transform.rotation.ToEulerXYZ());
+
+	transform.right = transform.matrix.WorldX();
+	transform.up = transform.matrix.WorldY();
+	transform.front = transform.matrix.WorldZ();
+
+	for (int child : transform.children)
+	{
+		UpdateReferenceHierarchy(transforms, child);
+	}
+}
+
+/// <summary>
+/// Same hierarchy kept in both the reference transforms and a TransformStore.
+/// </summary>
+struct TransformHierarchy
+{
+	std::vector<ReferenceTransform> reference_transforms;
+	std::vector<unsigned int> handles;
+	TransformStore store;
+
+	/// <summary>
+	/// Adds a transform under parent, -1 for a root.
+	/// </summary>
+	/// <returns>Index of the added transform.</returns>
+	int Add(int parent)
+	{
+		const int index = (int)reference_transforms.size();
+
+		// Children are offset and slightly rotated, so that the matrices
+		// are not trivial:
+		const math::float3 position_local = parent < 0 ? math::float3::zero : math::float3(1.0f, 0.5f, 0.0f);
+		const math::Quat rotation_local = math::Quat::RotateY(0.01f);
+		const math::float3 scale_local = math::float3::one;
+
+		ReferenceTransform reference_transform;
+		reference_transform.position_local = position_local;
+		reference_transform.rotation_local = rotation_local;
+		reference_transform.scale_local = scale_local;
+		reference_transform.parent = parent;
+		reference_transforms.push_back(reference_transform);
+
+		if (parent >= 0)
+		{
+			reference_transforms[parent].children.push_back(index);
+		}
+
+		const unsigned int handle = store.Create();
+		handles.push_back(handle);
+
+		if (parent >= 0)
+		{
+			store.SetParent(handle, handles[parent]);
+		}
+
+		store.SetLocal(handle, position_local, rotation_local, scale_local);
+
+		return index;
+	}
+};
+
+static void BuildDeepHierarchy(TransformHierarchy& hierarchy)
+{
+	int parent = hierarchy.Add(-1);
+
+	for (int i = 1; i < TRANSFORM_BENCHMARK_NODE_COUNT; ++i)
+	{
+		parent = hierarchy.Add(parent);
+	}
+}
+
+static void BuildWideHierarchy(TransformHierarchy& hierarchy)
+{
+	const int root = hierarchy.Add(-1);
+
+	for (int i = 1; i < TRANSFORM_BENCHMARK_NODE_COUNT; ++i)
+	{
+		hierarchy.Add(root);
+	}
+}
+
+static void BuildTreeHierarchy(TransformHierarchy& hierarchy, int parent, int depth)
+{
+	const int index = hierarchy.Add(parent);
+
+	if (depth + 1 >= TRANSFORM_BENCHMARK_TREE_DEPTH)
+	{
+		return;
+	}
+
+	for (int i = 0; i < TRANSFORM_BENCHMARK_TREE_BRANCHING; ++i)
+	{
+		BuildTreeHierarchy(hierarchy, index, depth + 1);
+	}
+}
+
+/// <summary>
+/// Drags the root of hierarchy for TRANSFORM_BENCHMARK_FRAMES frames with
+/// TRANSFORM_BENCHMARK_EDITS_PER_FRAME edits each, once through the
+/// reference transforms and once through the TransformStore, and prints
+/// the time both took.
+/// </summary>
+static void RunDragRootCase(const char* name, TransformHierarchy& hierarchy)
+{
+	printf(" %s hierarchy, %zu transforms, %d frames of %d edits:\n",
+		name,
+		hierarchy.reference_transforms.size(),
+		TRANSFORM_BENCHMARK_FRAMES,
+		TRANSFORM_BENCHMARK_EDITS_PER_FRAME);
+
+	std::vector<ReferenceTransform>& reference_transforms = hierarchy.reference_transforms;
+	TransformStore& store = hierarchy.store;
+	const unsigned int root_handle = hierarchy.handles[0];
+
+	// Start both from up to date world matrices:
+	UpdateReferenceHierarchy(reference_transforms, 0);
+	store.UpdateWorldMatrices();
+
+	BenchmarkTimer timer;
+
+	timer.Start();
+
+	for (int frame = 0; frame < TRANSFORM_BENCHMARK_FRAMES; ++frame)
+	{
+		for (int edit = 0; edit < TRANSFORM_BENCHMARK_EDITS_PER_FRAME; ++edit)
+		{
+			reference_transforms[0].position_local = math::float3((float)frame, (float)edit, 0.0f);
+
+			UpdateReferenceHierarchy(reference_transforms, 0);
+		}
+	}
+
+	timer.Stop();
+
+	const double reference_milliseconds = timer.Milliseconds();
+
+	timer.Start();
+
+	for (int frame = 0; frame < TRANSFORM_BENCHMARK_FRAMES; ++frame)
+	{
+		for (int edit = 0; edit < TRANSFORM_BENCHMARK_EDITS_PER_FRAME; ++edit)
+		{
+			store.SetLocal(root_handle, math::float3((float)frame, (float)edit, 0.0f), store.GetLocalRotation(root_handle), store.GetLocalScale(root_handle));
+		}
+
+		store.UpdateWorldMatrices();
+	}
+
+	timer.Stop();
+
+	const double store_milliseconds = timer.Milliseconds();
+
+	// Both must end up with the same world matrix for the last transform:
+	const size_t last = reference_transforms.size() - 1;
+	const bool matches = store.GetWorldMatrix(hierarchy.handles[last]).Equals(reference_transforms[last].matrix, 1e-2f);
+
+	PrintTime("eager recursive update per edit", reference_milliseconds);
+	PrintTime("TransformStore, one pass per frame", store_milliseconds);
+	PrintSpeedup("speedup", reference_milliseconds, store_milliseconds);
+	printf("  %-48s %15s\n", "last world matrix matches", matches ? "yes" : "NO");
+}
+
+void RunTransformPropagationBenchmark()
+{
+	{
+		TransformHierarchy hierarchy;
+		BuildDeepHierarchy(hierarchy);
+		RunDragRootCase("Deep", hierarchy);
+	}
+
+	{
+		TransformHierarchy hierarchy;
+		BuildWideHierarchy(hierarchy);
+		RunDragRootCase("Wide", hierarchy);
+	}
+
+	{
+		TransformHierarchy hierarchy;
+		BuildTreeHierarchy(hierarchy, -1, 0);
+		RunDragRootCase("Tree", hierarchy);
+	}
+}
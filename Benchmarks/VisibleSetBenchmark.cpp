@@ -0,0 +1,163 @@
+#include "Benchmark.h"
+
+#include "Application.h"
+#include "ModuleSceneManager.h"
+#include "Entity.h"
+#include "ComponentBoundingBox.h"
+#include "ComponentTransform.h"
+#include "TransformStore.h"
+#include "SpatialIndex.h"
+#include "Event.h"
+
+#include "MATH_GEO_LIB/Geometry/AABB.h"
+#include "MATH_GEO_LIB/Geometry/Frustum.h"
+#include "MATH_GEO_LIB/Geometry/OBB.h"
+#include "MATH_GEO_LIB/Math/float3.h"
+
+#include <cstdio>
+#include <unordered_set>
+#include <vector>
+
+#define VISIBLE_SET_BENCHMARK_ENTITY_COUNT 100000
+#define VISIBLE_SET_BENCHMARK_WORLD_HALF_SIZE 1000.0f
+#define VISIBLE_SET_BENCHMARK_WORLD_HALF_HEIGHT 50.0f
+#define VISIBLE_SET_BENCHMARK_FRAMES 60
+
+/// <summary>
+/// Counts the distinct entities of entities, as the hierarchical queries
+/// may find an entity more than once.
+/// </summary>
+static size_t CountDistinct(const std::vector<Entity*>& entities)
+{
+	std::unordered_set<const Entity*> distinct_entities(entities.begin(), entities.end());
+
+	return distinct_entities.size();
+}
+
+void RunVisibleSetBenchmark()
+{
+	// Scatter the entities under one root, in a batch build as a scene
+	// load would. They have no meshes, so each one keeps the 1 unit cube
+	// its bounding box has as a placeholder:
+	Entity* root = new Entity();
+	root->Initialize("Benchmark Scene");
+	root->BeginBatchBuild();
+
+	std::vector<Entity*> entities;
+	entities.reserve(VISIBLE_SET_BENCHMARK_ENTITY_COUNT);
+
+	BenchmarkRandom random(11);
+
+	for (int i = 0; i < VISIBLE_SET_BENCHMARK_ENTITY_COUNT; ++i)
+	{
+		Entity* entity = new Entity();
+		entity->Initialize("Benchmark Entity");
+		entity->SetParent(root);
+		entity->Transform()->SetLocalPosition(math::float3(
+			random.Range(-VISIBLE_SET_BENCHMARK_WORLD_HALF_SIZE, VISIBLE_SET_BENCHMARK_WORLD_HALF_SIZE),
+			random.Range(-VISIBLE_SET_BENCHMARK_WORLD_HALF_HEIGHT, VISIBLE_SET_BENCHMARK_WORLD_HALF_HEIGHT),
+			random.Range(-VISIBLE_SET_BENCHMARK_WORLD_HALF_SIZE, VISIBLE_SET_BENCHMARK_WORLD_HALF_SIZE)
+		));
+
+		entities.push_back(entity);
+	}
+
+	root->EndBatchBuild();
+
+	App->scene_manager->GetTransformStore()->UpdateWorldMatrices();
+	DeferredEventQueue::Flush();
+
+	// Refit every bounding box before timing anything, as Scene::CullMeshes
+	// does before culling:
+	root->BoundingBox()->GetBoundingBox();
+
+	BenchmarkTimer timer;
+
+	// Fill the spatial index the way Scene::RebuildSpatialIndex does, with
+	// the container enclosing the bounds of all the entities:
+	StrawMath::SpatialIndex spatial_index;
+	spatial_index.SetType(spatial_index_type::QUADTREE);
+
+	timer.Start();
+
+	math::AABB scene_bounds;
+	scene_bounds.SetNegativeInfinity();
+
+	for (const Entity* entity : entities)
+	{
+		scene_bounds.Enclose(entity->BoundingBox()->GetBoundingBox());
+	}
+
+	spatial_index.SetContainer(scene_bounds);
+
+	for (Entity* entity : entities)
+	{
+		spatial_index.Insert(entity);
+	}
+
+	timer.Stop();
+
+	const double build_milliseconds = timer.Milliseconds();
+
+	std::vector<Entity*> linear_visible_entities;
+	std::vector<Entity*> hierarchical_visible_entities;
+	linear_visible_entities.reserve(entities.size());
+	hierarchical_visible_entities.reserve(entities.size());
+
+	double linear_milliseconds = 0.0;
+	double hierarchical_milliseconds = 0.0;
+	size_t visible_entity_count = 0;
+	bool matches = true;
+
+	for (int frame = 0; frame < VISIBLE_SET_BENCHMARK_FRAMES; ++frame)
+	{
+		// Turn the camera a full circle over the frames:
+		const math::Frustum frustum = CreateBenchmarkFrustum(frame * (6.2831853f / VISIBLE_SET_BENCHMARK_FRAMES), 500.0f);
+
+		linear_visible_entities.clear();
+
+		timer.Start();
+
+		// Same test ComponentCamera::DoesOBBIntersectFrustum makes for
+		// each entity:
+		for (Entity* entity : entities)
+		{
+			if (entity->BoundingBox()->GetBoundingBox().Intersects(frustum))
+			{
+				linear_visible_entities.push_back(entity);
+			}
+		}
+
+		timer.Stop();
+
+		linear_milliseconds += timer.Milliseconds();
+
+		hierarchical_visible_entities.clear();
+
+		timer.Start();
+		spatial_index.FillWithIntersections(hierarchical_visible_entities, frustum);
+		timer.Stop();
+
+		hierarchical_milliseconds += timer.Milliseconds();
+
+		const size_t hierarchical_count = CountDistinct(hierarchical_visible_entities);
+
+		matches = matches && hierarchical_count == linear_visible_entities.size();
+		visible_entity_count += linear_visible_entities.size();
+	}
+
+	printf(" %d scattered entities, %d frames, %zu visible per frame on average:\n",
+		VISIBLE_SET_BENCHMARK_ENTITY_COUNT,
+		VISIBLE_SET_BENCHMARK_FRAMES,
+		visible_entity_count / VISIBLE_SET_BENCHMARK_FRAMES);
+
+	PrintTime("QuadTree build", build_milliseconds);
+	PrintTime("linear OBB test per entity", linear_milliseconds);
+	PrintTime("QuadTree hierarchical query", hierarchical_milliseconds);
+	PrintSpeedup("speedup", linear_milliseconds, hierarchical_milliseconds);
+	printf("  %-48s %15s\n", "visible sets match", matches ? "yes" : "NO");
+
+	spatial_index.CleanUp();
+
+	delete root;
+}
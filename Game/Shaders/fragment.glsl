@@ -4,46 +4,29 @@
 
 out vec4 frag_color;
 
+// Laid out to match the std140 mirrors in UniformBlocks.h:
 struct LightD {
-    vec3  position;
     vec3  direction;
-    float radius;
     float intensity;
-  
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-	float shininess;
-
+    vec3  diffuse;
 };
 
 struct LightP {
     vec3  position;
-    vec3  direction;
     float radius;
+    vec3  diffuse;
     float intensity;
-  
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-
-    float shininess;
-}; 
+};
 
 struct LightS {
     vec3  position;
-    vec3  direction;
     float radius;
+    vec3  direction;
     float intensity;
+    vec3  diffuse;
     float inner;
     float outer;
-  
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-
-    float shininess;
-}; 
+};
 
 struct Material {
     sampler2D diffuse;
@@ -51,6 +34,7 @@ struct Material {
     sampler2D occlusion;
     sampler2D normalmap;
     vec4 color;
+    float shininess;
 };
 
 
@@ -60,17 +44,22 @@ in vec3 fragment_position;
 in vec3 fragment_normal;
 in vec2 fragment_texture_coordinate;
 
-uniform vec3 camera_position;
+layout (std140, row_major) uniform PerFrame {
+    mat4 view_matrix;
+    mat4 projection_matrix;
+    vec3 camera_position;
+    float time;
+};
 
 uniform sampler2D input_texture;
 
-uniform LightD lightD;
-uniform LightP lightP;
-uniform LightS lightS;
+layout (std140) uniform Lights {
+    LightD lightD;
+    LightP lightP;
+    LightS lightS;
+};
 uniform Material material;
 
-in vec3 world_normal;
-
 vec3 SchlickFresnel(const vec3 f0, float cos_theta)
 {
     return f0 + (vec3(1.0) - f0) * pow(1.0 - cos_theta, 5.0);
@@ -93,7 +82,7 @@ vec3 PBRDirectional()
     vec3 fresnel = SchlickFresnel(texture(material.specular, fragment_texture_coordinate).rgb, NdotL);
 
     vec3 step1 = (diffuse_color * (vec3(1.0) - texture(material.specular, fragment_texture_coordinate).rgb)) / PI;
-    vec3 step2 = ((lightD.shininess + 2.0) / (2.0 * PI)) * fresnel * pow(VdotR, lightD.shininess);
+    vec3 step2 = ((material.shininess + 2.0) / (2.0 * PI)) * fresnel * pow(VdotR, material.shininess);
     vec3 PRBDirectional = lightD.diffuse * (step1 + step2) * NdotL * lightD.intensity;
 
     return PRBDirectional;
@@ -120,7 +109,7 @@ vec3 PBRPoint()
     float attenuation = max(pow(max(1 - pow(light_distance/lightP.radius, 4), 0.0), 2.0), 0.0) / ((light_distance * light_distance) + 1);
 
     vec3 step1 = (diffuse_color * (vec3(1.0) - texture(material.specular, fragment_texture_coordinate).rgb)) / PI;
-    vec3 step2 = ((lightP.shininess + 2.0) / (2.0 * PI)) * fresnel * pow(VdotR, lightP.shininess);
+    vec3 step2 = ((material.shininess + 2.0) / (2.0 * PI)) * fresnel * pow(VdotR, material.shininess);
     vec3 PBRPoint = lightP.diffuse * (step1 + step2) * NdotL * attenuation * lightP.intensity;
 
     return PBRPoint;
@@ -160,7 +149,7 @@ vec3 PBRSpot()
     float attenuation = pow(max(1 - pow(light_distance/lightS.radius, 4), 0.0), 2.0) / ((light_distance * light_distance) + 1);
 
     vec3 step1 = (diffuse_color * (vec3(1.0) - texture(material.specular, fragment_texture_coordinate).rgb)) / PI;
-    vec3 step2 = ((lightS.shininess + 2.0) / (2.0 * PI)) * fresnel * pow(VdotR, lightS.shininess);
+    vec3 step2 = ((material.shininess + 2.0) / (2.0 * PI)) * fresnel * pow(VdotR, material.shininess);
     // Adjusting the cosinus with the 1 - on the attenuation formula part 
     vec3 PBRSpot = lightS.diffuse * (step1 + step2) * NdotL * ((1-attenuation) * (1-cone_attenuation)) * lightS.intensity;
 
@@ -0,0 +1,448 @@
+#include "AABBTree.h"
+
+#include "Entity.h"
+#include "ComponentBoundingBox.h"
+
+namespace StrawMath
+{
+	/// <returns>AABB that encloses both a and b.</returns>
+	static math::AABB Union(const math::AABB& a, const math::AABB& b)
+	{
+		math::AABB result(a);
+		result.Enclose(b);
+
+		return result;
+	}
+
+	static int MaxHeight(int a, int b)
+	{
+		return a > b ? a : b;
+	}
+
+	AABBTree::AABBTree() :
+		root(AABB_TREE_INVALID_HANDLE),
+		free_list(AABB_TREE_INVALID_HANDLE)
+	{
+
+	}
+
+	AABBTree::~AABBTree()
+	{
+		CleanUp();
+	}
+
+	/// <summary>
+	/// AABBTree grows with its entities, so this only clears the tree to
+	/// match the other spatial indices.
+	/// </summary>
+	void AABBTree::SetContainer(const math::AABB& new_container)
+	{
+		CleanUp();
+	}
+
+	/// <summary>
+	/// Inserts a leaf for entity. If it's already in the tree, this is the
+	/// same as Update.
+	/// </summary>
+	/// <returns>Always true, AABBTree has no bounds.</returns>
+	bool AABBTree::Insert(Entity* const entity)
+	{
+		if (Contains(entity))
+		{
+			return Update(entity);
+		}
+
+		math::AABB entity_aabb = entity->BoundingBox()->GetBoundingBox().MinimalEnclosingAABB();
+		math::float3 margin(AABB_TREE_MARGIN, AABB_TREE_MARGIN, AABB_TREE_MARGIN);
+
+		unsigned int leaf = AllocateNode();
+
+		AABBTreeNode& node = nodes[leaf];
+		node.bounding_box = entity_aabb;
+		node.fat_bounding_box = math::AABB(entity_aabb.minPoint - margin, entity_aabb.maxPoint + margin);
+		node.entity = entity;
+
+		entity_leaves[entity] = leaf;
+
+		InsertLeaf(leaf);
+
+		return true;
+	}
+
+	void AABBTree::Remove(Entity* const entity)
+	{
+		std::unordered_map<const Entity*, unsigned int>::iterator entity_leaf = entity_leaves.find(entity);
+
+		if (entity_leaf == entity_leaves.end())
+		{
+			return;
+		}
+
+		unsigned int leaf = entity_leaf->second;
+		entity_leaves.erase(entity_leaf);
+
+		RemoveLeaf(leaf);
+		FreeNode(leaf);
+	}
+
+	/// <summary>
+	/// Updates the leaf of entity. The tree is only changed if the entity
+	/// has moved out of the fat bounding box of its leaf.
+	/// </summary>
+	/// <returns>Always true, AABBTree has no bounds.</returns>
+	bool AABBTree::Update(Entity* const entity)
+	{
+		std::unordered_map<const Entity*, unsigned int>::iterator entity_leaf = entity_leaves.find(entity);
+
+		if (entity_leaf == entity_leaves.end())
+		{
+			return Insert(entity);
+		}
+
+		unsigned int leaf = entity_leaf->second;
+
+		math::AABB entity_aabb = entity->BoundingBox()->GetBoundingBox().MinimalEnclosingAABB();
+
+		nodes[leaf].bounding_box = entity_aabb;
+
+		if (nodes[leaf].fat_bounding_box.Contains(entity_aabb))
+		{
+			return true;
+		}
+
+		math::float3 margin(AABB_TREE_MARGIN, AABB_TREE_MARGIN, AABB_TREE_MARGIN);
+
+		RemoveLeaf(leaf);
+		nodes[leaf].fat_bounding_box = math::AABB(entity_aabb.minPoint - margin, entity_aabb.maxPoint + margin);
+		InsertLeaf(leaf);
+
+		return true;
+	}
+
+	/// <returns>True if entity is inside this tree.</returns>
+	bool AABBTree::Contains(const Entity* entity) const
+	{
+		return entity_leaves.find(entity) != entity_leaves.end();
+	}
+
+	/// <summary>
+	/// Removes all the nodes and entities. Memory of the node pool is kept
+	/// so that the tree can be rebuilt without allocating.
+	/// </summary>
+	void AABBTree::CleanUp()
+	{
+		nodes.clear();
+		root = AABB_TREE_INVALID_HANDLE;
+		free_list = AABB_TREE_INVALID_HANDLE;
+		entity_leaves.clear();
+	}
+
+	unsigned int AABBTree::AllocateNode()
+	{
+		unsigned int node_handle;
+
+		if (free_list != AABB_TREE_INVALID_HANDLE)
+		{
+			node_handle = free_list;
+			free_list = nodes[node_handle].parent;
+		}
+		else
+		{
+			node_handle = (unsigned int)nodes.size();
+			nodes.emplace_back();
+		}
+
+		AABBTreeNode& node = nodes[node_handle];
+		node.parent = AABB_TREE_INVALID_HANDLE;
+		node.child_1 = AABB_TREE_INVALID_HANDLE;
+		node.child_2 = AABB_TREE_INVALID_HANDLE;
+		node.height = 0;
+		node.entity = nullptr;
+
+		return node_handle;
+	}
+
+	void AABBTree::FreeNode(unsigned int node_handle)
+	{
+		// Free nodes are linked through their parent handles:
+		nodes[node_handle].parent = free_list;
+		nodes[node_handle].height = -1;
+		nodes[node_handle].entity = nullptr;
+		free_list = node_handle;
+	}
+
+	/// <summary>
+	/// Finds the sibling for leaf that increases the surface area of the tree
+	/// the least, pairs them under a new parent and refits the ancestors.
+	/// </summary>
+	void AABBTree::InsertLeaf(unsigned int leaf)
+	{
+		if (root == AABB_TREE_INVALID_HANDLE)
+		{
+			root = leaf;
+			nodes[root].parent = AABB_TREE_INVALID_HANDLE;
+
+			return;
+		}
+
+		const math::AABB leaf_box = nodes[leaf].fat_bounding_box;
+
+		// Descend while pairing with a child is cheaper than pairing with
+		// the current node:
+		unsigned int index = root;
+
+		while (!nodes[index].IsLeaf())
+		{
+			const AABBTreeNode& node = nodes[index];
+
+			float area = node.fat_bounding_box.SurfaceArea();
+			float combined_area = Union(node.fat_bounding_box, leaf_box).SurfaceArea();
+
+			// Cost of creating a new parent for this node and the leaf:
+			float cost = 2.0f * combined_area;
+
+			// Minimum cost of pushing the leaf further down the tree:
+			float inheritance_cost = 2.0f * (combined_area - area);
+
+			float child_costs[2];
+			unsigned int children[2] = { node.child_1, node.child_2 };
+
+			for (size_t i = 0; i < 2; ++i)
+			{
+				const AABBTreeNode& child = nodes[children[i]];
+
+				float child_combined_area = Union(child.fat_bounding_box, leaf_box).SurfaceArea();
+
+				child_costs[i] = child.IsLeaf() ?
+					child_combined_area + inheritance_cost :
+					child_combined_area - child.fat_bounding_box.SurfaceArea() + inheritance_cost;
+			}
+
+			if (cost < child_costs[0] && cost < child_costs[1])
+			{
+				break;
+			}
+
+			index = child_costs[0] < child_costs[1] ? children[0] : children[1];
+		}
+
+		unsigned int sibling = index;
+		unsigned int old_parent = nodes[sibling].parent;
+
+		// NOTE: This may grow nodes, don't keep references to nodes above.
+		unsigned int new_parent = AllocateNode();
+
+		nodes[new_parent].parent = old_parent;
+		nodes[new_parent].fat_bounding_box = Union(leaf_box, nodes[sibling].fat_bounding_box);
+		nodes[new_parent].height = nodes[sibling].height + 1;
+		nodes[new_parent].child_1 = sibling;
+		nodes[new_parent].child_2 = leaf;
+		nodes[sibling].parent = new_parent;
+		nodes[leaf].parent = new_parent;
+
+		if (old_parent == AABB_TREE_INVALID_HANDLE)
+		{
+			root = new_parent;
+		}
+		else if (nodes[old_parent].child_1 == sibling)
+		{
+			nodes[old_parent].child_1 = new_parent;
+		}
+		else
+		{
+			nodes[old_parent].child_2 = new_parent;
+		}
+
+		Refit(nodes[leaf].parent);
+	}
+
+	/// <summary>
+	/// Detaches leaf from the tree, replaces its parent with its sibling
+	/// and refits the ancestors. leaf itself is not freed.
+	/// </summary>
+	void AABBTree::RemoveLeaf(unsigned int leaf)
+	{
+		if (leaf == root)
+		{
+			root = AABB_TREE_INVALID_HANDLE;
+
+			return;
+		}
+
+		unsigned int parent = nodes[leaf].parent;
+		unsigned int grand_parent = nodes[parent].parent;
+		unsigned int sibling = nodes[parent].child_1 == leaf ? nodes[parent].child_2 : nodes[parent].child_1;
+
+		FreeNode(parent);
+
+		nodes[sibling].parent = grand_parent;
+
+		if (grand_parent == AABB_TREE_INVALID_HANDLE)
+		{
+			root = sibling;
+
+			return;
+		}
+
+		if (nodes[grand_parent].child_1 == parent)
+		{
+			nodes[grand_parent].child_1 = sibling;
+		}
+		else
+		{
+			nodes[grand_parent].child_2 = sibling;
+		}
+
+		Refit(grand_parent);
+	}
+
+	/// <summary>
+	/// Balances and recalculates the bounding boxes and heights of the
+	/// node and all its ancestors.
+	/// </summary>
+	void AABBTree::Refit(unsigned int node_handle)
+	{
+		unsigned int index = node_handle;
+
+		while (index != AABB_TREE_INVALID_HANDLE)
+		{
+			index = Balance(index);
+
+			AABBTreeNode& node = nodes[index];
+			const AABBTreeNode& child_1 = nodes[node.child_1];
+			const AABBTreeNode& child_2 = nodes[node.child_2];
+
+			node.height = 1 + MaxHeight(child_1.height, child_2.height);
+			node.fat_bounding_box = Union(child_1.fat_bounding_box, child_2.fat_bounding_box);
+
+			index = node.parent;
+		}
+	}
+
+	/// <summary>
+	/// Rotates the taller child of the node up if the heights of its children
+	/// differ by more than one.
+	/// </summary>
+	/// <returns>Handle of the node that took the place of the node.</returns>
+	unsigned int AABBTree::Balance(unsigned int node_handle)
+	{
+		unsigned int i_a = node_handle;
+		AABBTreeNode& a = nodes[i_a];
+
+		if (a.IsLeaf() || a.height < 2)
+		{
+			return i_a;
+		}
+
+		unsigned int i_b = a.child_1;
+		unsigned int i_c = a.child_2;
+		AABBTreeNode& b = nodes[i_b];
+		AABBTreeNode& c = nodes[i_c];
+
+		int balance = c.height - b.height;
+
+		// Rotate c up:
+		if (balance > 1)
+		{
+			unsigned int i_f = c.child_1;
+			unsigned int i_g = c.child_2;
+			AABBTreeNode& f = nodes[i_f];
+			AABBTreeNode& g = nodes[i_g];
+
+			// Swap a and c:
+			c.child_1 = i_a;
+			c.parent = a.parent;
+			a.parent = i_c;
+
+			if (c.parent == AABB_TREE_INVALID_HANDLE)
+			{
+				root = i_c;
+			}
+			else if (nodes[c.parent].child_1 == i_a)
+			{
+				nodes[c.parent].child_1 = i_c;
+			}
+			else
+			{
+				nodes[c.parent].child_2 = i_c;
+			}
+
+			// Keep the taller child of c under c, give the other to a:
+			if (f.height > g.height)
+			{
+				c.child_2 = i_f;
+				a.child_2 = i_g;
+				g.parent = i_a;
+				a.fat_bounding_box = Union(b.fat_bounding_box, g.fat_bounding_box);
+				c.fat_bounding_box = Union(a.fat_bounding_box, f.fat_bounding_box);
+				a.height = 1 + MaxHeight(b.height, g.height);
+				c.height = 1 + MaxHeight(a.height, f.height);
+			}
+			else
+			{
+				c.child_2 = i_g;
+				a.child_2 = i_f;
+				f.parent = i_a;
+				a.fat_bounding_box = Union(b.fat_bounding_box, f.fat_bounding_box);
+				c.fat_bounding_box = Union(a.fat_bounding_box, g.fat_bounding_box);
+				a.height = 1 + MaxHeight(b.height, f.height);
+				c.height = 1 + MaxHeight(a.height, g.height);
+			}
+
+			return i_c;
+		}
+
+		// Rotate b up:
+		if (balance < -1)
+		{
+			unsigned int i_d = b.child_1;
+			unsigned int i_e = b.child_2;
+			AABBTreeNode& d = nodes[i_d];
+			AABBTreeNode& e = nodes[i_e];
+
+			// Swap a and b:
+			b.child_1 = i_a;
+			b.parent = a.parent;
+			a.parent = i_b;
+
+			if (b.parent == AABB_TREE_INVALID_HANDLE)
+			{
+				root = i_b;
+			}
+			else if (nodes[b.parent].child_1 == i_a)
+			{
+				nodes[b.parent].child_1 = i_b;
+			}
+			else
+			{
+				nodes[b.parent].child_2 = i_b;
+			}
+
+			// Keep the taller child of b under b, give the other to a:
+			if (d.height > e.height)
+			{
+				b.child_2 = i_d;
+				a.child_1 = i_e;
+				e.parent = i_a;
+				a.fat_bounding_box = Union(c.fat_bounding_box, e.fat_bounding_box);
+				b.fat_bounding_box = Union(a.fat_bounding_box, d.fat_bounding_box);
+				a.height = 1 + MaxHeight(c.height, e.height);
+				b.height = 1 + MaxHeight(a.height, d.height);
+			}
+			else
+			{
+				b.child_2 = i_e;
+				a.child_1 = i_d;
+				d.parent = i_a;
+				a.fat_bounding_box = Union(c.fat_bounding_box, d.fat_bounding_box);
+				b.fat_bounding_box = Union(a.fat_bounding_box, e.fat_bounding_box);
+				a.height = 1 + MaxHeight(c.height, d.height);
+				b.height = 1 + MaxHeight(a.height, e.height);
+			}
+
+			return i_b;
+		}
+
+		return i_a;
+	}
+}
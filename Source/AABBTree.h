@@ -0,0 +1,244 @@
+#pragma once
+
+#include "MATH_GEO_LIB/Geometry/AABB.h"
+#include "MATH_GEO_LIB/Math/float3.h"
+
+#include "RayQueryBuffer.h"
+#include "BatchQueryBuffer.h"
+
+#include <vector>
+#include <unordered_map>
+
+#define AABB_TREE_MARGIN 0.5f
+#define AABB_TREE_INVALID_HANDLE 0xFFFFFFFF
+
+class Entity;
+
+namespace StrawMath
+{
+	/// <summary>
+	/// Node of an AABBTree. Nodes live inside the node pool of the tree and
+	/// refer to each other with handles, which are indices into that pool.
+	/// Leaves hold a single entity, inner nodes always have two children.
+	/// </summary>
+	struct AABBTreeNode
+	{
+		/// <summary>
+		/// For leaves, AABB of the entity grown by AABB_TREE_MARGIN on each
+		/// side, so that small moves don't change the tree. For inner nodes,
+		/// AABB that encloses both children.
+		/// </summary>
+		math::AABB fat_bounding_box;
+
+		/// <summary>
+		/// AABB that encloses the OBB of the entity, only used by leaves.
+		/// </summary>
+		math::AABB bounding_box;
+
+		/// <summary>
+		/// Handle of the parent node, AABB_TREE_INVALID_HANDLE for the root.
+		/// Handle of the next free node if this node is free.
+		/// </summary>
+		unsigned int parent;
+
+		/// <summary>
+		/// Handles of the children, AABB_TREE_INVALID_HANDLE for leaves.
+		/// </summary>
+		unsigned int child_1;
+		unsigned int child_2;
+
+		/// <summary>
+		/// Height of the subtree below this node, 0 for leaves.
+		/// </summary>
+		int height;
+
+		/// <summary>
+		/// Entity of this node, nullptr for inner nodes.
+		/// </summary>
+		Entity* entity;
+
+		bool IsLeaf() const { return child_1 == AABB_TREE_INVALID_HANDLE; }
+	};
+
+	/// <summary>
+	/// Dynamic bounding volume hierarchy. Entities are inserted next to the
+	/// node that increases the surface area of the tree the least, and the
+	/// tree is kept balanced with rotations on the way up. Unlike the other
+	/// spatial indices it has no fixed container, so insert always succeeds.
+	/// </summary>
+	class AABBTree
+	{
+	private:
+		std::vector<AABBTreeNode> nodes;
+		unsigned int root;
+		unsigned int free_list;
+		std::unordered_map<const Entity*, unsigned int> entity_leaves;
+
+	public:
+		AABBTree();
+		~AABBTree();
+
+		void SetContainer(const math::AABB& new_container);
+		bool Insert(Entity* const entity);
+		void Remove(Entity* const entity);
+		bool Update(Entity* const entity);
+		bool Contains(const Entity* entity) const;
+		void CleanUp();
+
+		template<typename INTERSECTABLE_T>
+		void FillWithIntersections(std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const;
+		template<typename INTERSECTABLE_T, typename CANDIDATE_FUNCTION_T>
+		void RaycastNearestFirst(const INTERSECTABLE_T& intersectable, float max_distance, RayQueryBuffer& buffer, const CANDIDATE_FUNCTION_T& test_candidate) const;
+		template<typename INTERSECTABLE_T>
+		void FillWithBatchIntersections(const INTERSECTABLE_T* intersectables, size_t count, BatchQueryBuffer& buffer) const;
+
+	private:
+		template<typename INTERSECTABLE_T>
+		void FillWithIntersections(unsigned int node_handle, std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const;
+		template<typename INTERSECTABLE_T>
+		void FillWithBatchIntersections(unsigned int node_handle, const BatchQueryRange& parent_queries, const INTERSECTABLE_T* intersectables, BatchQueryBuffer& buffer) const;
+
+		unsigned int AllocateNode();
+		void FreeNode(unsigned int node_handle);
+		void InsertLeaf(unsigned int leaf);
+		void RemoveLeaf(unsigned int leaf);
+		void Refit(unsigned int node_handle);
+		unsigned int Balance(unsigned int node_handle);
+	};
+
+	template<typename INTERSECTABLE_T>
+	inline void AABBTree::FillWithIntersections(std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const
+	{
+		if (root == AABB_TREE_INVALID_HANDLE)
+		{
+			return;
+		}
+
+		FillWithIntersections(root, intersecting_entities, intersectable);
+	}
+
+	template<typename INTERSECTABLE_T>
+	inline void AABBTree::FillWithIntersections(unsigned int node_handle, std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const
+	{
+		const AABBTreeNode& node = nodes[node_handle];
+
+		if (!node.IsLeaf())
+		{
+			if (intersectable.Intersects(node.fat_bounding_box))
+			{
+				FillWithIntersections(node.child_1, intersecting_entities, intersectable);
+				FillWithIntersections(node.child_2, intersecting_entities, intersectable);
+			}
+
+			return;
+		}
+
+		if (intersectable.Intersects(node.bounding_box))
+		{
+			intersecting_entities.push_back(node.entity);
+		}
+	}
+
+	/// <summary>
+	/// See SpatialIndex::RaycastNearestFirst. Children are pushed by the
+	/// distance to their fat bounding boxes.
+	/// </summary>
+	template<typename INTERSECTABLE_T, typename CANDIDATE_FUNCTION_T>
+	inline void AABBTree::RaycastNearestFirst(const INTERSECTABLE_T& intersectable, float max_distance, RayQueryBuffer& buffer, const CANDIDATE_FUNCTION_T& test_candidate) const
+	{
+		buffer.Clear();
+
+		float hit_near = 0.0f;
+		float hit_far = 0.0f;
+
+		if (root == AABB_TREE_INVALID_HANDLE || !intersectable.Intersects(nodes[root].fat_bounding_box, hit_near, hit_far))
+		{
+			return;
+		}
+
+		buffer.PushNode(hit_near, root);
+
+		while (!buffer.IsEmpty())
+		{
+			RayQueryEntry entry = buffer.PopNearest();
+
+			// Everything left starts after the closest hit:
+			if (entry.distance > max_distance)
+			{
+				break;
+			}
+
+			if (entry.entity != nullptr)
+			{
+				test_candidate(entry.entity, max_distance);
+				continue;
+			}
+
+			const AABBTreeNode& node = nodes[entry.node_handle];
+
+			// Leaves are pushed again as their entity, with the distance to
+			// the tight bounding box instead of the fat one:
+			if (node.IsLeaf())
+			{
+				if (intersectable.Intersects(node.bounding_box, hit_near, hit_far) && hit_near <= max_distance)
+				{
+					buffer.PushEntity(hit_near, node.entity);
+				}
+
+				continue;
+			}
+
+			if (intersectable.Intersects(nodes[node.child_1].fat_bounding_box, hit_near, hit_far) && hit_near <= max_distance)
+			{
+				buffer.PushNode(hit_near, node.child_1);
+			}
+
+			if (intersectable.Intersects(nodes[node.child_2].fat_bounding_box, hit_near, hit_far) && hit_near <= max_distance)
+			{
+				buffer.PushNode(hit_near, node.child_2);
+			}
+		}
+	}
+
+	/// <summary>
+	/// See SpatialIndex::FillWithBatchIntersections. Queries are narrowed
+	/// down by the fat bounding box of each node, and leaves test the tight
+	/// bounding box of their entity.
+	/// </summary>
+	template<typename INTERSECTABLE_T>
+	inline void AABBTree::FillWithBatchIntersections(const INTERSECTABLE_T* intersectables, size_t count, BatchQueryBuffer& buffer) const
+	{
+		const BatchQueryRange all_queries = buffer.ActivateAll(count);
+
+		if (root == AABB_TREE_INVALID_HANDLE || count == 0)
+		{
+			return;
+		}
+
+		FillWithBatchIntersections(root, all_queries, intersectables, buffer);
+	}
+
+	template<typename INTERSECTABLE_T>
+	inline void AABBTree::FillWithBatchIntersections(unsigned int node_handle, const BatchQueryRange& parent_queries, const INTERSECTABLE_T* intersectables, BatchQueryBuffer& buffer) const
+	{
+		const AABBTreeNode& node = nodes[node_handle];
+
+		// Leaves test the tight bounding box of their entity:
+		if (node.IsLeaf())
+		{
+			buffer.AddHits(parent_queries, intersectables, node.bounding_box, node.entity);
+
+			return;
+		}
+
+		const BatchQueryRange node_queries = buffer.ActivateIntersecting(parent_queries, intersectables, node.fat_bounding_box);
+
+		if (node_queries.count != 0)
+		{
+			FillWithBatchIntersections(node.child_1, node_queries, intersectables, buffer);
+			FillWithBatchIntersections(node.child_2, node_queries, intersectables, buffer);
+		}
+
+		buffer.Deactivate(node_queries);
+	}
+}
@@ -12,6 +12,9 @@
 #include "ModuleDebugDraw.h"
 #include "ModuleSceneManager.h"
 
+#include "Event.h"
+#include "WorkerPool.h"
+
 #include "Util.h"
 
 Application::Application()
@@ -19,6 +22,9 @@ Application::Application()
     // Get working directory and store it inside working_directory:
     util::GetWorkingDirectory(&working_directory);
 
+    // Created before the modules, so that they can use it from Init:
+    worker_pool = new WorkerPool();
+
 	// Order matters: they will Init/start/update in this order
 	modules.push_back(window = new ModuleWindow());
 	modules.push_back(input = new ModuleInput());
@@ -37,6 +43,8 @@ Application::~Application()
     {
         delete *it;
     }
+
+    delete worker_pool;
 }
 
 bool Application::Init()
@@ -73,6 +81,10 @@ update_status Application::Update()
     {
         ret = (*it)->PreUpdate();
     }
+
+    // Notify listeners of the deferred events invoked since the last flush,
+    // so that Update of modules see the changes made until now:
+    DeferredEventQueue::Flush();
     
 	for(std::vector<Module*>::iterator it = modules.begin();
         it != modules.end() && ret == update_status::UPDATE_CONTINUE;
@@ -16,6 +16,7 @@ class ModuleTexture;
 class ModuleCamera;
 class ModuleDebugDraw;
 class ModuleSceneManager;
+class WorkerPool;
 
 class Application
 {
@@ -41,6 +42,7 @@ public:
 	ModuleTexture* texture = nullptr;
 	ModuleCamera* camera = nullptr;
 	ModuleDebugDraw* debug_draw = nullptr;
+	WorkerPool* worker_pool = nullptr;
 
 private:
 	char* working_directory = nullptr;
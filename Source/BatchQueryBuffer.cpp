@@ -0,0 +1,35 @@
+#include "BatchQueryBuffer.h"
+
+namespace StrawMath
+{
+	void BatchQueryBuffer::Clear()
+	{
+		active_queries.clear();
+		hits.clear();
+	}
+
+	/// <summary>
+	/// Clears the buffer and makes all the queries active, for the root.
+	/// </summary>
+	/// <returns>Range of all the queries.</returns>
+	BatchQueryRange BatchQueryBuffer::ActivateAll(size_t query_count)
+	{
+		Clear();
+
+		for (size_t i = 0; i < query_count; ++i)
+		{
+			active_queries.push_back((unsigned int)i);
+		}
+
+		return { 0, query_count };
+	}
+
+	/// <summary>
+	/// Drops the queries activated by ActivateIntersecting, so that the
+	/// next sibling starts from the queries of the parent again.
+	/// </summary>
+	void BatchQueryBuffer::Deactivate(const BatchQueryRange& queries)
+	{
+		active_queries.resize(queries.first);
+	}
+}
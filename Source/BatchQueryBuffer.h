@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class Entity;
+
+namespace StrawMath
+{
+	/// <summary>
+	/// Entity whose bounds are intersected by one of the queries of a batch.
+	/// </summary>
+	struct BatchQueryHit
+	{
+		unsigned int query_index;
+		Entity* entity;
+	};
+
+	/// <summary>
+	/// Range of active_queries of a BatchQueryBuffer that holds the queries
+	/// still active for a node.
+	/// </summary>
+	struct BatchQueryRange
+	{
+		size_t first;
+		size_t count;
+	};
+
+	/// <summary>
+	/// Memory used by a batched query over a spatial index, meant to be kept
+	/// and reused between batches. While walking the index, each node keeps
+	/// the indices of the queries that intersect it at the end of
+	/// active_queries, and its children only test those.
+	/// </summary>
+	class BatchQueryBuffer
+	{
+	public:
+		std::vector<unsigned int> active_queries;
+		std::vector<BatchQueryHit> hits;
+
+	public:
+		void Clear();
+		BatchQueryRange ActivateAll(size_t query_count);
+
+		template<typename INTERSECTABLE_T, typename BOUNDS_T>
+		BatchQueryRange ActivateIntersecting(const BatchQueryRange& queries, const INTERSECTABLE_T* intersectables, const BOUNDS_T& bounds);
+		template<typename INTERSECTABLE_T, typename BOUNDS_T>
+		void AddHits(const BatchQueryRange& queries, const INTERSECTABLE_T* intersectables, const BOUNDS_T& bounds, Entity* entity);
+
+		void Deactivate(const BatchQueryRange& queries);
+	};
+
+	/// <summary>
+	/// Activates the queries of the given range that intersect bounds, by
+	/// pushing them to the end of active_queries. Must be undone with
+	/// Deactivate once the node is done, before any sibling is visited.
+	/// </summary>
+	/// <returns>Range of the activated queries, empty if bounds is missed by all.</returns>
+	template<typename INTERSECTABLE_T, typename BOUNDS_T>
+	inline BatchQueryRange BatchQueryBuffer::ActivateIntersecting(const BatchQueryRange& queries, const INTERSECTABLE_T* intersectables, const BOUNDS_T& bounds)
+	{
+		const size_t first = active_queries.size();
+
+		for (size_t i = queries.first; i < queries.first + queries.count; ++i)
+		{
+			const unsigned int query_index = active_queries[i];
+
+			if (intersectables[query_index].Intersects(bounds))
+			{
+				active_queries.push_back(query_index);
+			}
+		}
+
+		return { first, active_queries.size() - first };
+	}
+
+	/// <summary>
+	/// Adds a hit of entity for each query of the given range that
+	/// intersects bounds.
+	/// </summary>
+	template<typename INTERSECTABLE_T, typename BOUNDS_T>
+	inline void BatchQueryBuffer::AddHits(const BatchQueryRange& queries, const INTERSECTABLE_T* intersectables, const BOUNDS_T& bounds, Entity* entity)
+	{
+		for (size_t i = queries.first; i < queries.first + queries.count; ++i)
+		{
+			const unsigned int query_index = active_queries[i];
+
+			if (intersectables[query_index].Intersects(bounds))
+			{
+				hits.push_back({ query_index, entity });
+			}
+		}
+	}
+}
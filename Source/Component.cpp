@@ -20,7 +20,7 @@ Entity* Component::Owner() const
 
 component_type Component::Type() const
 {
-	return component_type::UNDEFINED;
+	return StaticType();
 }
 
 bool Component::CanBeMoreThanOne(component_type type)
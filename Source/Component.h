@@ -44,6 +44,13 @@ public:
 	/// </returns>
 	virtual component_type Type() const;
 
+	/// <returns>
+	/// Type of the Component class, known at compile time. Every 
+	/// derived Component must hide this with its own type so that 
+	/// Entity can look up components by class without creating one.
+	/// </returns>
+	static constexpr component_type StaticType() { return component_type::UNDEFINED; }
+
 	/// <returns> 
 	/// If the component is enabled.
 	/// </returns>
@@ -11,7 +11,10 @@
 
 ComponentBoundingBox::ComponentBoundingBox() : 
     Component(), 
-    minimal_enclosing_sphere_radius(1.0f)
+    minimal_enclosing_sphere_radius(1.0f),
+    has_mesh_in_subtree(false),
+    is_dirty(true),
+    fitted_world_stamp(0)
 {
 }
 
@@ -21,7 +24,6 @@ ComponentBoundingBox::~ComponentBoundingBox()
     {
         // Unsubscribe from the component changed events of the owner:
         owner->GetComponentsChangedEvent()->RemoveListener(&component_changed_event_listener);
-        owner->GetComponentsChangedInDescendantsEvent()->RemoveListener(&component_changed_event_listener);
         // Unsubscribe from the hierarchy changed event of the owner:
         owner->GetHierarchyChangedEvent()->RemoveListener(&hierarchy_changed_event_listener);
     }
@@ -29,7 +31,7 @@ ComponentBoundingBox::~ComponentBoundingBox()
 
 component_type ComponentBoundingBox::Type() const
 {
-    return component_type::BOUNDING_BOX;
+    return StaticType();
 }
 
 void ComponentBoundingBox::Initialize(Entity* new_owner)
@@ -45,53 +47,145 @@ void ComponentBoundingBox::Initialize(Entity* new_owner)
     
     // Create component changed event listener:
     component_changed_event_listener = EventListener<component_type>(std::bind(&ComponentBoundingBox::HandleComponentChanged, this, std::placeholders::_1));
-    // Subscribe it to the components changed event and
-    // the components changed in descendants event of the
-    // owner:
+    // Subscribe it to the components changed event of the owner.
+    // NOTE: Changes in descendants don't need to be listened, as
+    // they mark this dirty through MarkDirty:
     owner->GetComponentsChangedEvent()->AddListener(&component_changed_event_listener);
-    owner->GetComponentsChangedInDescendantsEvent()->AddListener(&component_changed_event_listener);
 }
 
 void ComponentBoundingBox::Load()
 {
+    MarkDirty();
+
+    Refit();
+}
+
+void ComponentBoundingBox::MarkDirty()
+{
+    is_dirty = true;
+
+    // Mark ancestors dirty until an already dirty one is found, as 
+    // ancestors of a dirty bounding box are dirty as well.
+    // NOTE: Starting from the parent even if this was already dirty
+    // is on purpose, a dirty bounding box may be moved under a clean 
+    // parent.
+    for (Entity* ancestor = owner->Parent(); ancestor != nullptr; ancestor = ancestor->Parent())
+    {
+        ComponentBoundingBox* ancestor_bounding_box = ancestor->BoundingBox();
+
+        if (ancestor_bounding_box->is_dirty)
+        {
+            break;
+        }
+
+        ancestor_bounding_box->is_dirty = true;
+    }
+}
+
+void ComponentBoundingBox::DrawGizmo()
+{
+    if (!Enabled() || !owner->IsActive())
+    {
+        return;
+    }
+
+    Refit();
+
+    static const int order[8] = { 0, 1, 5, 4, 2, 3, 7, 6 };
+    float3 vertices[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        vertices[i] = obb.CornerPoint(order[i]);
+    }
+        
+    App->debug_draw->DrawCuboid(vertices, math::float3(0.0f, 1.0f, 0.0f));
+}
+
+const math::OBB& ComponentBoundingBox::GetBoundingBox() const
+{
+    Refit();
+
+    return obb;
+}
+
+float ComponentBoundingBox::GetMinimalEnclosingSphereRadius() const
+{
+    Refit();
+
+    return minimal_enclosing_sphere_radius;
+}
+
+const math::float3& ComponentBoundingBox::GetCenterPosition() const
+{
+    Refit();
+
+    return center_position;
+}
+
+void ComponentBoundingBox::DrawInspectorContent()
+{
+    Refit();
+
+    math::float3 obb_half_size = obb.HalfSize();
+    math::float3 obb_position = obb.pos;
+
+    ImGui::TextWrapped("Half Size: %f, %f, %f", obb_half_size.x, obb_half_size.y, obb_half_size.z);
+    ImGui::TextWrapped("Position: %f, %f, %f", obb_position.x, obb_position.y, obb_position.z);
+}
+
+void ComponentBoundingBox::Refit() const
+{
+    const unsigned long long world_stamp = owner->Transform()->GetWorldStamp();
+
+    if (!is_dirty && world_stamp == fitted_world_stamp)
+    {
+        return;
+    }
+
     // NOTE: For now we only get mesh components to calculate the bounding box,
     // In the future when colliders are added for example, we may need to include them
     // as well.
 
-    // NOTE: Should this function use already calculated OBBs of lower ComponentBoundingBoxes 
-    // when called with GetComponentsChangedInDescendantsEvent which is sure of being notified
-    // by it's lower?
-    // TODO: Address this issue if it may be a good optimization.
-
     // Initialize OBB:
     obb.SetNegativeInfinity();
 
-    // Initialize a temp AABB:
-    math::AABB aabb;
-    aabb.SetNegativeInfinity();
-
-    std::vector<ComponentMesh*> mesh_components = owner->GetComponentsInDescendants<ComponentMesh>();
+    // Enclose the cached subtree aabbs of children, refitting 
+    // the out of date ones first:
+    subtree_aabb.SetNegativeInfinity();
 
-    ComponentMesh* owner_mesh_component = owner->GetComponent<ComponentMesh>();
+    bool has_mesh_in_descendants = false;
 
-    if (mesh_components.size() > 0)
+    for (Entity* child : owner->GetChildren())
     {
-        // If the owner also has a mesh component, add it to the list:
-        if (owner_mesh_component != nullptr)
+        ComponentBoundingBox* child_bounding_box = child->BoundingBox();
+
+        child_bounding_box->Refit();
+
+        // Children without any mesh in their subtree don't contribute,
+        // their 1 unit cubes are only placeholders:
+        if (!child_bounding_box->has_mesh_in_subtree)
         {
-            mesh_components.push_back(owner_mesh_component);
+            continue;
         }
 
-        // Calculate the aabb from the list:
-        for (ComponentMesh* mesh_component : mesh_components)
+        subtree_aabb.Enclose(child_bounding_box->subtree_aabb);
+        has_mesh_in_descendants = true;
+    }
+
+    ComponentMesh* owner_mesh_component = owner->GetComponent<ComponentMesh>();
+
+    if (has_mesh_in_descendants)
+    {
+        // If the owner also has a mesh component, add it to the aabb:
+        if (owner_mesh_component != nullptr)
         {
-            AddMeshComponentToAABB(mesh_component, aabb);
+            AddMeshComponentToAABB(owner_mesh_component, subtree_aabb);
         }
 
         // Set the obb from aabb:
-        obb.SetFrom(aabb);
+        obb.SetFrom(subtree_aabb);
     }
-    else if (owner_mesh_component != nullptr && mesh_components.size() <= 0)
+    else if (owner_mesh_component != nullptr)
     {
         // NOTE: This is not added like the previous if statement 
         // because here we directly get the aabb and set an obb
@@ -106,6 +200,9 @@ void ComponentBoundingBox::Load()
         obb.Scale(math::float3::zero, Owner()->Transform()->GetScale());
         obb.Transform(Owner()->Transform()->GetRotation());
         obb.Translate(Owner()->Transform()->GetPosition());
+
+        // Parents enclose the aabb of this obb:
+        subtree_aabb.Enclose(obb);
     }
     else
     {
@@ -118,6 +215,8 @@ void ComponentBoundingBox::Load()
         // we don't want an empty obb to take more space in the world.
     }
 
+    has_mesh_in_subtree = has_mesh_in_descendants || owner_mesh_component != nullptr;
+
     // NOTE: For now this is not a true obb, it's just an obb that acts like aabb,
     // rotations are not truly captured to be more precise. Maybe using child bound
     // ing boxes would give a better result.
@@ -126,47 +225,9 @@ void ComponentBoundingBox::Load()
     const math::Sphere minimal_enclosing_sphere = obb.MinimalEnclosingSphere();
     minimal_enclosing_sphere_radius = minimal_enclosing_sphere.r;
     center_position = minimal_enclosing_sphere.Centroid();
-}
-
-void ComponentBoundingBox::DrawGizmo()
-{
-    if (!Enabled() || !owner->IsActive())
-    {
-        return;
-    }
-
-    static const int order[8] = { 0, 1, 5, 4, 2, 3, 7, 6 };
-    float3 vertices[8];
-    for (int i = 0; i < 8; ++i)
-    {
-        vertices[i] = obb.CornerPoint(order[i]);
-    }
-        
-    App->debug_draw->DrawCuboid(vertices, math::float3(0.0f, 1.0f, 0.0f));
-}
-
-const math::OBB& ComponentBoundingBox::GetBoundingBox() const
-{
-    return obb;
-}
-
-float ComponentBoundingBox::GetMinimalEnclosingSphereRadius() const
-{
-    return minimal_enclosing_sphere_radius;
-}
 
-const math::float3& ComponentBoundingBox::GetCenterPosition() const
-{
-    return center_position;
-}
-
-void ComponentBoundingBox::DrawInspectorContent()
-{
-    math::float3 obb_half_size = obb.HalfSize();
-    math::float3 obb_position = obb.pos;
-
-    ImGui::TextWrapped("Half Size: %f, %f, %f", obb_half_size.x, obb_half_size.y, obb_half_size.z);
-    ImGui::TextWrapped("Position: %f, %f, %f", obb_position.x, obb_position.y, obb_position.z);
+    is_dirty = false;
+    fitted_world_stamp = world_stamp;
 }
 
 void ComponentBoundingBox::AddMeshComponentToAABB(ComponentMesh* mesh, math::AABB& aabb) const
@@ -196,20 +257,18 @@ void ComponentBoundingBox::AddMeshComponentToAABB(ComponentMesh* mesh, math::AAB
 
 void ComponentBoundingBox::HandleHierarchyChanged(entity_operation operation)
 {
-    if (operation != entity_operation::CHILDREN_CHANGED)
+    if (operation != entity_operation::CHILDREN_CHANGED && 
+        operation != entity_operation::PARENT_CHANGED)
     {
         return;
     }
 
-    // NOTE: Right now we only care about the changes in the children
-    // entity to recalculate this bounding box. However this is not
-    // the most optimal way to do this, we could have a more specific
-    // event such as HandleChildWithMeshComponent added type of event
-    // but it would be so specific that it could also decrease the
-    // performance. Right now invoking this function each time the
-    // children are changed makes sense.
+    // NOTE: Children changed affects the bounds of this and the
+    // ancestors, parent changed affects the bounds of the new
+    // ancestors. Marking dirty covers both, actual refit is done
+    // once when the bounding box is needed.
 
-    Load();
+    MarkDirty();
 }
 
 void ComponentBoundingBox::HandleComponentChanged(component_type type)
@@ -227,5 +286,5 @@ void ComponentBoundingBox::HandleComponentChanged(component_type type)
         return;
     }
 
-    Load();
+    MarkDirty();
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "Component.h"
 #include "Event.h"
 
+#include "MATH_GEO_LIB/Geometry/AABB.h"
 #include "MATH_GEO_LIB/Geometry/OBB.h"
 
 class ComponentMesh;
@@ -14,17 +15,42 @@ private:
 	/// <summary>
 	/// OBB that surrounds the owner Entity.
 	/// </summary>
-	math::OBB obb;
+	mutable math::OBB obb;
+
+	/// <summary>
+	/// World AABB that encloses the meshes of owner and its descendants.
+	/// Parents enclose this instead of traversing the meshes of their
+	/// descendants. Only valid if has_mesh_in_subtree is true.
+	/// </summary>
+	mutable math::AABB subtree_aabb;
 
 	/// <summary>
 	/// Minimal enclosing sphere radius of the OBB.
 	/// </summary>
-	float minimal_enclosing_sphere_radius;
+	mutable float minimal_enclosing_sphere_radius;
 
 	/// <summary>
 	/// Center Position of OBB.
 	/// </summary>
-	math::float3 center_position;
+	mutable math::float3 center_position;
+
+	/// <summary>
+	/// True if owner or any of its descendants has a mesh.
+	/// </summary>
+	mutable bool has_mesh_in_subtree;
+
+	/// <summary>
+	/// True if the OBB needs to be refit. If this is true, it's 
+	/// also true for every ancestor.
+	/// </summary>
+	mutable bool is_dirty;
+
+	/// <summary>
+	/// World stamp of the owner's transform when the OBB was last refit.
+	/// Transforms only notify their own owner, so a bounding box whose
+	/// ancestor has moved is found out of date through this.
+	/// </summary>
+	mutable unsigned long long fitted_world_stamp;
 
 	/// <summary>
 	/// Listener to the component changed event of owner Entity.
@@ -44,6 +70,11 @@ public:
 	/// Type of this Component.
 	/// </returns>
 	component_type Type() const override;
+
+	/// <returns>
+	/// Type of this Component class.
+	/// </returns>
+	static constexpr component_type StaticType() { return component_type::BOUNDING_BOX; }
 	
 	/// <summary>
 	/// Initializes this ComponentBoundingBox and sets it's parent.
@@ -54,11 +85,17 @@ public:
 	void Initialize(Entity* new_owner) override;
 
 	/// <summary>
-	/// Loads the internal OBB of this ComponentBoundingBox
-	/// by traversing all the ComponentMeshes of the hierarchy
-	/// of owner including itself.
+	/// Marks this ComponentBoundingBox dirty and refits it
+	/// right away.
 	/// </summary>
 	void Load();
+
+	/// <summary>
+	/// Marks this and the bounding boxes of all the ancestors of
+	/// owner as dirty, so that they are refit the next time they 
+	/// are accessed.
+	/// </summary>
+	void MarkDirty();
 	
 	/// <summary>
 	/// Draws the OBB. Called on each Entity::DrawGizmos 
@@ -81,6 +118,18 @@ public:
 	/// </returns>
 	const math::float3& GetCenterPosition() const;
 
+	/// <returns>
+	/// OBB as of the last refit, without refitting it. Safe to call from
+	/// the workers once the bounding boxes are refit on the main thread.
+	/// </returns>
+	const math::OBB& GetFittedBoundingBox() const { return obb; };
+
+	/// <returns>
+	/// Minimal enclosing sphere radius of OBB as of the last refit,
+	/// without refitting it.
+	/// </returns>
+	float GetFittedMinimalEnclosingSphereRadius() const { return minimal_enclosing_sphere_radius; };
+
 protected:
 	/// <summary>
 	/// Draws the ImGui content of this.
@@ -89,6 +138,13 @@ protected:
 	void DrawInspectorContent() override;
 
 private:
+	/// <summary>
+	/// Recalculates the OBB if this is dirty or the owner's world matrix
+	/// has changed, by refitting the out of date children first and enclosing their cached subtree AABBs along
+	/// with the mesh of the owner.
+	/// </summary>
+	void Refit() const;
+
 	/// <summary>
 	/// Gets the AABB of mesh, transforms it according to
 	/// it's owner's Transform, and adds it to aabb.
@@ -70,21 +70,24 @@ void ComponentCamera::PreUpdate()
 	// Calculate the projection matrix if it's necessary:
 	CalculateProjectionMatrix();
 
+	// Component changed events are deferred until after PreUpdate, so 
+	// make sure transform changes made before this are reflected:
+	UpdateTransformVariables();
+
 	// If it's the main camera, use the matrices of this:
 	// NOTE: When play/stop is implemented, we will start rendering from 
 	// the camera that is flagged as main camera found in the current scene.
 	if (is_main_camera && should_render)
 	{
-		// Make sure we are using the true shader before passing the arguments:
-		App->shader_program->Use();
+		// Write the matrices into the per frame block, which is uploaded
+		// once before the meshes are drawn. They are kept row major, the
+		// block in the shaders declares them as row_major:
+		PerFrameUniformBlock& per_frame_block = App->shader_program->GetPerFrameBlock();
 
-		// Pass transposed model view projection matrices to the shader, as MathGeoLib is row major
-		// and OpenGL is column major:
-		App->shader_program->SetUniformVariable("model_matrix", owner->Transform()->GetMatrix(), true);
-		App->shader_program->SetUniformVariable("view_matrix", view_matrix, true);
-		App->shader_program->SetUniformVariable("projection_matrix", projection_matrix, true);
+		memcpy(per_frame_block.view_matrix, view_matrix.ptr(), sizeof(per_frame_block.view_matrix));
+		memcpy(per_frame_block.projection_matrix, projection_matrix.ptr(), sizeof(per_frame_block.projection_matrix));
 
-		App->shader_program->SetUniformVariable("camera_position", owner->Transform()->GetPosition());
+		per_frame_block.camera_position = owner->Transform()->GetPosition();
 	}
 }
 
@@ -100,7 +103,7 @@ void ComponentCamera::DrawGizmo()
 
 component_type ComponentCamera::Type() const
 {
-	return component_type::CAMERA;
+	return StaticType();
 }
 
 const math::float4x4& ComponentCamera::GetViewMatrix() const
@@ -113,6 +116,11 @@ const math::float4x4& ComponentCamera::GetProjectionMatrix() const
 	return projection_matrix;
 }
 
+const math::Frustum& ComponentCamera::GetFrustum() const
+{
+	return frustum;
+}
+
 float ComponentCamera::GetVerticalFOV() const
 {
 	return frustum.VerticalFov();
@@ -280,7 +288,7 @@ void ComponentCamera::UpdateTransformVariables()
 	frustum.SetFront(owner->Transform()->GetFront());
 
 	// Recalculate the view_matrix according to the changed transform:
-	view_matrix = owner->Transform()->GetMatrix().Inverted();
+	view_matrix = owner->Transform()->GetInverseMatrix();
 }
 
 void ComponentCamera::HandleComponentChanged(component_type type)
@@ -96,6 +96,12 @@ public:
 	///	</returns>
 	component_type Type() const override;
 
+	/// <returns>
+	/// The type of ComponentCamera class, used by Entity to
+	/// look up cameras without creating one.
+	///	</returns>
+	static constexpr component_type StaticType() { return component_type::CAMERA; }
+
 	/// <returns>
 	/// The view matrix of this ComponentCamera.
 	///	</returns>
@@ -106,6 +112,11 @@ public:
 	///	</returns>
 	const math::float4x4& GetProjectionMatrix() const;
 
+	/// <returns>
+	/// The frustum of this ComponentCamera.
+	///	</returns>
+	const math::Frustum& GetFrustum() const;
+
 	/// <returns>
 	/// The vertical field of view of this ComponentCamera.
 	///	</returns>
@@ -26,7 +26,7 @@ ComponentLight::~ComponentLight()
 
 component_type ComponentLight::Type() const
 {
-	return component_type::LIGHT;
+	return StaticType();
 }
 
 void ComponentLight::Initialize(Entity* new_owner)
@@ -41,10 +41,8 @@ void ComponentLight::Update()
 		return;
 	}
 
-	// Make sure we are using the true shader before passing the arguments:
-	App->shader_program->Use();
-
-	// Pass uniforms to the shader:
+	// Write the values of this light into the light block, which is
+	// uploaded once before the meshes are drawn:
 	SetUniforms();
 }
 
@@ -216,36 +214,32 @@ void ComponentLight::SetUniforms()
 
 void ComponentLight::SetUniformsPointLight()
 {
-	App->shader_program->SetUniformVariable("lightP.position", owner->Transform()->GetPosition());
-	App->shader_program->SetUniformVariable("lightP.radius", radius);
-	App->shader_program->SetUniformVariable("lightP.ambient", float3(0.2, 0.2, 0.2));	
-	App->shader_program->SetUniformVariable("lightP.diffuse", color);
-	App->shader_program->SetUniformVariable("lightP.constant", 1.0f);
-	App->shader_program->SetUniformVariable("lightP.linear", 0.9f);
-	App->shader_program->SetUniformVariable("lightP.quadratic", 0.032f);
-	App->shader_program->SetUniformVariable("lightP.intensity", intensity);
+	PointLightUniformBlock& block = App->shader_program->GetLightBlock().point_light;
+
+	block.position = owner->Transform()->GetPosition();
+	block.radius = radius;
+	block.diffuse = color;
+	block.intensity = intensity;
 }
 
 void ComponentLight::SetUniformsDirectionalLight()
 {
-	App->shader_program->SetUniformVariable("lightD.direction", owner->Transform()->GetFront());
-	App->shader_program->SetUniformVariable("lightD.ambient", float3(0.2, 0.2, 0.2));
-	App->shader_program->SetUniformVariable("lightD.diffuse", color);
-	App->shader_program->SetUniformVariable("lightD.intensity", intensity);
+	DirectionalLightUniformBlock& block = App->shader_program->GetLightBlock().directional_light;
+
+	block.direction = owner->Transform()->GetFront();
+	block.diffuse = color;
+	block.intensity = intensity;
 }
 
 void ComponentLight::SetUniformsSpotLight()
 {
-	App->shader_program->SetUniformVariable("lightS.position", owner->Transform()->GetPosition());
-	App->shader_program->SetUniformVariable("lightS.direction", owner->Transform()->GetFront());
-	App->shader_program->SetUniformVariable("lightS.radius", radius);
-	App->shader_program->SetUniformVariable("lightS.inner", inner_angle);
-	App->shader_program->SetUniformVariable("lightS.outer", outer_angle);
-	App->shader_program->SetUniformVariable("lightS.ambient", float3(0.2, 0.2, 0.2));
-	App->shader_program->SetUniformVariable("lightS.diffuse", color);
-	App->shader_program->SetUniformVariable("lightS.specular", float3(1.0f, 1.0f, 1.0f));
-	App->shader_program->SetUniformVariable("lightS.constant", 1.0f);
-	App->shader_program->SetUniformVariable("lightS.linear", 0.9f);
-	App->shader_program->SetUniformVariable("lightS.quadratic", 0.032f);
-	App->shader_program->SetUniformVariable("lightS.intensity", intensity);
+	SpotLightUniformBlock& block = App->shader_program->GetLightBlock().spot_light;
+
+	block.position = owner->Transform()->GetPosition();
+	block.direction = owner->Transform()->GetFront();
+	block.radius = radius;
+	block.inner = inner_angle;
+	block.outer = outer_angle;
+	block.diffuse = color;
+	block.intensity = intensity;
 }
\ No newline at end of file
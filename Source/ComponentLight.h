@@ -50,6 +50,11 @@ public:
 	/// is LIGHT.
 	/// </returns>
 	component_type Type() const override;
+
+	/// <returns>
+	/// LIGHT, without needing an instance.
+	/// </returns>
+	static constexpr component_type StaticType() { return component_type::LIGHT; }
 	
 	/// <summary>
 	/// Initializes this ComponentLight with it's owner
@@ -1,10 +1,7 @@
 #include "ComponentMaterial.h"
 
 #include "Application.h"
-#include "ModuleShaderProgram.h"
-#include "ModuleDebugDraw.h"
-
-#include "GLEW/include/GL/glew.h"
+#include "ModuleTexture.h"
 
 #include "Entity.h"
 
@@ -28,7 +25,7 @@ ComponentMaterial::~ComponentMaterial()
 
 component_type ComponentMaterial::Type() const
 {
-	return component_type::MATERIAL;
+	return StaticType();
 }
 
 void ComponentMaterial::Initialize(Entity* new_owner)
@@ -58,29 +55,6 @@ void ComponentMaterial::Load(const unsigned int* new_texture_ids, size_t new_num
 		texture_ids[i] = new_texture_ids[i];
 	}
 
-	// Use the shader:
-	App->shader_program->Use();
-	// Activate Texture Unit 0:
-	glActiveTexture(GL_TEXTURE0);
-	// Bind Texture Unit 0:
-	glBindTexture(GL_TEXTURE_2D, texture_ids[0]); // Diffuse texture
-	// Set Texture Parameter in shader:
-	App->shader_program->SetUniformVariable("material.diffuse", 0);
-
-	// Activate Texture Unit 1:
-	glActiveTexture(GL_TEXTURE1);
-	// Bind Texture Unit 1:
-	glBindTexture(GL_TEXTURE_2D, texture_ids[1]); // Specular texture
-	// Set Texture Parameter in shader:
-	App->shader_program->SetUniformVariable("material.specular", 1);
-
-	// Activate Texture Unit 2:
-	glActiveTexture(GL_TEXTURE2);
-	// Bind Texture Unit 2:
-	glBindTexture(GL_TEXTURE_2D, texture_ids[2]); // Occlusion texture
-	// Set Texture Parameter in shader:
-	App->shader_program->SetUniformVariable("material.occlusion", 2);
-
 	// Set as currently loaded:
 	is_currently_loaded = true;
 
@@ -88,37 +62,14 @@ void ComponentMaterial::Load(const unsigned int* new_texture_ids, size_t new_num
 	owner->InvokeComponentsChangedEvents(Type());
 }
 
-void ComponentMaterial::Use()
+unsigned int ComponentMaterial::GetTextureId(size_t index) const
 {
-	// Use the shader :
-	App->shader_program->Use();
-	// Activate Texture Unit 0:
-	glActiveTexture(GL_TEXTURE0);
-	// Bind Texture Unit 0:
-	glBindTexture(GL_TEXTURE_2D, texture_ids[0]); // Diffuse texture
-	// Set Texture Parameter in shader:
-	App->shader_program->SetUniformVariable("material.diffuse", 0);
-
-	// Activate Texture Unit 1:
-	glActiveTexture(GL_TEXTURE1);
-	// Bind Texture Unit 1:
-	glBindTexture(GL_TEXTURE_2D, texture_ids[1]); // Specular texture
-	// Set Texture Parameter in shader:
-	App->shader_program->SetUniformVariable("material.specular", 1);
-
-	// Activate Texture Unit 2:
-	glActiveTexture(GL_TEXTURE2);
-	// Bind Texture Unit 2:
-	glBindTexture(GL_TEXTURE_2D, texture_ids[2]); // Occlusion texture
-	// Set Texture Parameter in shader:
-	App->shader_program->SetUniformVariable("material.occlusion", 2);
-
-	// Set shininess parameter in shader:
-	// TODO (Monica): Create a shininess uniform in shader and make all
-	// lights use that for this material.
-	App->shader_program->SetUniformVariable("lightP.shininess", shininess);
-	App->shader_program->SetUniformVariable("lightD.shininess", shininess);
-	App->shader_program->SetUniformVariable("lightS.shininess", shininess);
+	if (texture_ids == nullptr || index >= number_of_texture_ids)
+	{
+		return 0;
+	}
+
+	return texture_ids[index];
 }
 
 void ComponentMaterial::Reset()
@@ -129,7 +80,20 @@ void ComponentMaterial::Reset()
 
 	color_diffuse = math::float4::one;
 
+	if (texture_ids != nullptr)
+	{
+		for (size_t i = 0; i < number_of_texture_ids; ++i)
+		{
+			if (texture_ids[i] != 0)
+			{
+				App->texture->ReleaseTexture(texture_ids[i]);
+			}
+		}
+	}
+
 	free(texture_ids);
+
+	texture_ids = nullptr;
 }
 
 void ComponentMaterial::DrawInspectorContent()
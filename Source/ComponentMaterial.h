@@ -46,6 +46,11 @@ public:
 	/// </returns>
 	component_type Type() const override;
 
+	/// <returns> 
+	/// MATERIAL, the type of this Component class.
+	/// </returns>
+	static constexpr component_type StaticType() { return component_type::MATERIAL; }
+
 	/// <summary>
 	/// Initializes this ComponentMaterial along with it's owner Entity.
 	/// </summary>
@@ -55,6 +60,8 @@ public:
 	/// <summary>
 	/// Loads this ComponentMaterial from given textures.
 	/// Also sets is_currently_loaded flag to true.
+	/// Takes over a reference to each texture acquired from 
+	/// ModuleTexture, which are released on Reset.
 	/// </summary>
 	/// <param name="new_texture_ids">OpenGL Ids of textures.</param>
 	/// <param name="new_number_of_texture_ids">Number of given textures.</param>
@@ -64,14 +71,20 @@ public:
 		size_t new_number_of_texture_ids
 	);
 
-	/// <summary>
-	/// Binds the textures and sets the uniforms related to this ComponentMaterial.
-	/// </summary>
-	void Use();
+	/// <returns>
+	/// OpenGL id of the texture at index, 0 if this has no texture there.
+	/// </returns>
+	unsigned int GetTextureId(size_t index) const;
+
+	/// <returns>
+	/// Shininess of this ComponentMaterial.
+	/// </returns>
+	float GetShininess() const { return shininess; };
 
 	/// <summary>
 	/// Resets this ComponentMaterial like it has never been Initialized before.
-	/// Also sets the is_currently_loaded flag to false.
+	/// Also sets the is_currently_loaded flag to false, and releases the
+	/// textures.
 	/// </summary>
 	void Reset();
 
@@ -1,83 +1,30 @@
 #pragma once
 
 #include "Component.h"
+#include "ResourceMesh.h"
 
-#include "MATH_GEO_LIB/Math/float3.h"
-#include "MATH_GEO_LIB/Geometry/AABB.h"
-
-#include <vector>
+#define COMPONENT_MESH_INVALID_REGISTRY_INDEX 0xFFFFFFFF
 
 class ComponentMesh : public Component
 {
-private:
-	/// <summary>
-	/// Vertices of this ComponentMesh. Vertex data is stored as an 
-	/// interleaved array as follows: 
-	/// position_1.x, position_1.y, position_1.z, normal_1.x, normal_1.y, normal_1.z, texture_1.x, texture_1.y, ...
-	/// </summary>
-	float* vertices; 
-
-	/// <summary>
-	/// Indices of this ComponentMesh. Indices data is stored as follows:
-	/// first_index_1, second_index_1, third_index_1, ...
-	/// </summary>
-	unsigned int* indices;
-
-	/// <summary>
-	/// VAO ID of this ComponentMesh.
-	/// </summary>
-	unsigned int vertex_array_object;
-
-	/// <summary>
-	/// VBO ID of this ComponentMesh.
-	/// </summary>
-	unsigned int vertex_buffer_object;
-
-	/// <summary>
-	/// EBO ID of this ComponentMesh.
-	/// </summary>
-	unsigned int element_buffer_object;
-
-	/// <summary>
-	/// AABB that encloses the vertices of this ComponentMesh.
-	/// </summary>
-	math::AABB bounding_box;
-
-	/// <summary>
-	/// Number of vertices this ComponentMesh has.
-	/// </summary>
-	size_t number_of_vertices;
-
-	/// <summary>
-	/// Number of indices this ComponentMesh has.
-	/// </summary>
-	size_t number_of_indices;
-	
-	/// <summary>
-	/// Number of triangles this ComponentMesh has.
-	/// This should be equal to number_of_indices / 3,
-	/// but stored anyway.
-	/// </summary>
-	size_t number_of_triangles;
-
-	/// <summary>
-	/// This flag is set to true if Initialize or constructor is called, 
-	/// false if Reset or destructor is called.
-	/// </summary>
-	bool is_currently_loaded;
+	friend class Scene;
 
+private:
 	/// <summary>
-	/// This flag is set to true by the scene when this mesh is outside
-	/// the render camera's frustum, false otherwise.
+	/// Geometry this ComponentMesh draws, shared with the other 
+	/// ComponentMeshes that draw the same geometry. Acquired from the
+	/// ResourceMeshCache of ModuleSceneManager on Load and released on 
+	/// Reset. nullptr if this is not loaded.
 	/// </summary>
-	bool is_culled;
+	ResourceMesh* resource;
 
 	/// <summary>
-	/// This vector stores triangles of the mesh for convenience for
-	/// the intersection functions, mouse picking etc.
-	/// This is a special std::vector<math::Triangle> under the hood.
+	/// Index of this ComponentMesh inside the mesh registry of the scene 
+	/// owner is in. Set by the scene on register, and updated when another
+	/// mesh is swap-removed into it. COMPONENT_MESH_INVALID_REGISTRY_INDEX
+	/// if this is not registered to any scene.
 	/// </summary>
-	math::TriangleArray cached_triangles;
+	unsigned int registry_index;
 
 public:
 	ComponentMesh();
@@ -87,6 +34,11 @@ public:
 	/// Type of this Component, MESH.
 	/// </returns>
 	component_type Type() const override;
+
+	/// <returns> 
+	/// Type of this Component class, MESH.
+	/// </returns>
+	static constexpr component_type StaticType() { return component_type::MESH; }
 	
 	/// <summary>
 	/// Initializes this ComponentMesh along with the provided owner.
@@ -95,30 +47,15 @@ public:
 	void Initialize(Entity* new_owner) override;
 	
 	/// <summary>
-	/// Loads this mesh with provided vertices and indices.
-	/// Also sets is_currently_loaded to true.
-	/// </summary>
-	/// <param name="new_vertices">Vertices array to be copied into vertices.</param>
-	/// <param name="new_indices">Indices array to be copied into indices.</param>
-	/// <param name="new_number_of_vertices">Value to be set as number of vertices.</param>
-	/// <param name="new_number_of_indices">Value to be set as number of indices.</param>
-	/// <param name="new_number_of_triangles">Value to be set as number of triangles.</param>
-	void Load(
-		float* new_vertices, 
-		unsigned int* new_indices, 
-		size_t new_number_of_vertices, 
-		size_t new_number_of_indices, 
-		size_t new_number_of_triangles
-	);
-	
-	/// <summary>
-	/// Called every Update of owner Entity.
+	/// Loads this mesh with the geometry of new_resource, which is 
+	/// acquired from the ResourceMeshCache until Reset.
 	/// </summary>
-	void Update() override;
+	/// <param name="new_resource">Resource created by the ResourceMeshCache of ModuleSceneManager.</param>
+	void Load(ResourceMesh* new_resource);
 	
 	/// <summary>
 	/// Resets this ComponentMesh like it has never been Initialized.
-	/// Also sets is_currently_loaded to false.
+	/// Also releases resource.
 	/// </summary>
 	void Reset();
 	
@@ -127,46 +64,55 @@ public:
 	/// </summary>
 	void DrawGizmo() override;
 
+	/// <returns> 
+	/// Geometry of this ComponentMesh, nullptr if it is not loaded.
+	/// </returns>
+	const ResourceMesh* GetResource() const { return resource; };
+
+	/// <returns> 
+	/// VAO ID of this ComponentMesh, drawn by the render queue of the scene.
+	/// Meshes that share a resource share the VAO.
+	/// </returns>
+	unsigned int GetVertexArrayObject() const { return Resource().GetVertexArrayObject(); };
+
 	/// <returns> 
 	/// Number of vertices this ComponentMesh has.
 	/// </returns>
-	size_t GetNumberOfVertices() const { return number_of_vertices; };
+	size_t GetNumberOfVertices() const { return Resource().GetNumberOfVertices(); };
 	
 	/// <returns> 
 	/// Number of indices this ComponentMesh has.
 	/// </returns>
-	size_t GetNumberOfIndices() const { return number_of_indices; };
+	size_t GetNumberOfIndices() const { return Resource().GetNumberOfIndices(); };
 	
 	/// <returns> 
 	/// Number of triangles this ComponentMesh has.
 	/// </returns>
-	size_t GetNumberOfTriangles() const { return number_of_triangles; };
+	size_t GetNumberOfTriangles() const { return Resource().GetNumberOfTriangles(); };
 	
 	/// <returns> 
 	/// Local AABB that encloses the vertices of this ComponentMesh.
 	/// </returns>
-	const math::AABB& GetAABB() const { return bounding_box; };
+	const math::AABB& GetAABB() const { return Resource().GetAABB(); };
 	
 	/// <returns> 
 	/// Vertices of this ComponentMesh.
 	/// </returns>
-	const float* GetVertices() const { return vertices; };
+	const float* GetVertices() const { return Resource().GetVertices(); };
 	
 	/// <returns> 
 	/// Triangles of this ComponentMesh.
 	/// </returns>
-	const math::TriangleArray& GetTriangles() const { return cached_triangles; }
+	const math::TriangleArray& GetTriangles() const { return Resource().GetTriangles(); }
 
 	/// <summary>
-	/// Sets is_culled flag of this ComponentMesh.
+	/// Finds the closest triangle of this mesh that segment hits, using
+	/// the BVH of resource.
 	/// </summary>
-	/// <param name="new_is_culled">True if this ComponentMesh is meant to be culled, false otherwise.</param>
-	void SetCulled(bool new_is_culled);
-	
-	/// <returns> 
-	/// True if this ComponentMesh is culled by the main camera of the scene, false otherwise.
-	/// </returns>
-	bool IsCulled() const;
+	/// <param name="segment_local">Segment in the local space of this mesh.</param>
+	/// <param name="hit">Closest hit, only changed if a hit closer than hit.distance is found.</param>
+	/// <returns>True if a hit closer than hit.distance is found.</returns>
+	bool Intersects(const math::LineSegment& segment_local, StrawMath::TriangleHit& hit) const;
 
 protected:
 	/// <summary>
@@ -175,11 +121,9 @@ protected:
 	void DrawInspectorContent() override;
 
 private:
-	/// <summary>
-	/// Loads the AABB that encloses this ComponentMesh by traversing
-	/// its vertices array. This is a costly function, use this as less
-	/// as possible.
-	/// </summary>
-	void LoadAABB();
+	/// <returns>
+	/// resource, or an empty resource if this is not loaded, so that the
+	/// getters don't need to check.
+	/// </returns>
+	const ResourceMesh& Resource() const;
 };
-
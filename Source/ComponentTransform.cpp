@@ -4,6 +4,8 @@
 #include "ModuleCamera.h"
 #include "ComponentCamera.h"
 #include "Application.h"
+#include "ModuleSceneManager.h"
+#include "TransformStore.h"
 
 #include "MATH_GEO_LIB/Math/float3x3.h"
 #include "MATH_GEO_LIB/Math/TransformOps.h"
@@ -14,30 +16,39 @@
 
 ComponentTransform::ComponentTransform() :
 	Component(),
+	handle(TRANSFORM_STORE_INVALID_HANDLE),
+	rotation_euler_local(math::float3::zero),
 	position(math::float3::zero),
-	position_local(math::float3::zero),
 	scale(math::float3::one),
-	scale_local(math::float3::one),
 	rotation_euler(math::float3::zero),
-	rotation_euler_local(math::float3::zero),
 	rotation(math::Quat::identity),
-	rotation_local(math::Quat::identity),
-	matrix(math::float4x4::identity),
-	matrix_local(math::float4x4::identity),
 	right(math::float3::unitX),
 	up(math::float3::unitY),
-	front(math::float3::unitZ)
+	front(math::float3::unitZ),
+	matrix(math::float4x4::identity),
+	inverse_matrix(math::float4x4::identity),
+	normal_matrix(math::float3x3::identity),
+	matrix_stamp(0),
+	decomposition_stamp(0),
+	inverse_stamp(0)
 {
 }
 
 ComponentTransform::~ComponentTransform()
 {
+	// Transforms that are never initialized don't have a handle:
+	if (handle != TRANSFORM_STORE_INVALID_HANDLE)
+	{
+		Store()->Destroy(handle);
+	}
 }
 
 void ComponentTransform::Initialize(Entity* new_owner)
 {
 	Component::Initialize(new_owner);
 
+	handle = Store()->Create();
+
 	SetEulerRotation(math::float3::zero);
 
 	owner_hierarchy_changed_event_listener = 
@@ -71,32 +82,38 @@ void ComponentTransform::DrawGizmo()
 
 component_type ComponentTransform::Type() const
 {
-	return component_type::TRANSFORM;
+	return StaticType();
 }
 
 const math::float3& ComponentTransform::GetPosition() const
 {
+	RefreshDecomposition();
+
 	return position;
 }
 
 const math::float3& ComponentTransform::GetScale() const
 {
+	RefreshDecomposition();
+
 	return scale;
 }
 
 const math::float3& ComponentTransform::GetEulerRotation() const
 {
+	RefreshDecomposition();
+
 	return rotation_euler;
 }
 
-const math::float3& ComponentTransform::GetLocalPosition() const
+math::float3 ComponentTransform::GetLocalPosition() const
 {
-	return position_local;
+	return Store()->GetLocalPosition(handle);
 }
 
-const math::float3& ComponentTransform::GetLocalScale() const
+math::float3 ComponentTransform::GetLocalScale() const
 {
-	return scale_local;
+	return Store()->GetLocalScale(handle);
 }
 
 const math::float3& ComponentTransform::GetLocalEulerRotation() const
@@ -106,42 +123,79 @@ const math::float3& ComponentTransform::GetLocalEulerRotation() const
 
 const math::Quat& ComponentTransform::GetRotation() const
 {
+	RefreshDecomposition();
+
 	return rotation;
 }
 
-const math::Quat& ComponentTransform::GetLocalRotation() const
+math::Quat ComponentTransform::GetLocalRotation() const
 {
-	return rotation_local;
+	return Store()->GetLocalRotation(handle);
 }
 
 const math::float4x4& ComponentTransform::GetMatrix() const
 {
+	RefreshMatrix();
+
 	return matrix;
 }
 
+/// <returns>
+/// Inverse of the world matrix, which takes world space to the local
+/// space of this transform.
+/// </returns>
+const math::float4x4& ComponentTransform::GetInverseMatrix() const
+{
+	RefreshInverse();
+
+	return inverse_matrix;
+}
+
+/// <returns>
+/// Inverse transpose of the rotation and scale part of the world matrix,
+/// which takes normals to world space.
+/// </returns>
+const math::float3x3& ComponentTransform::GetNormalMatrix() const
+{
+	RefreshInverse();
+
+	return normal_matrix;
+}
+
 const math::float4x4 ComponentTransform::GetLocalMatrix() const
 {
-	return matrix_local;
+	return Store()->GetLocalMatrix(handle);
 }
 
 const math::float3& ComponentTransform::GetRight() const
 {
+	RefreshMatrix();
+
 	return right;
 }
 
 const math::float3& ComponentTransform::GetUp() const
 {
+	RefreshMatrix();
+
 	return up;
 }
 
 const math::float3& ComponentTransform::GetFront() const
 {
+	RefreshMatrix();
+
 	return front;
 }
 
 const math::float3& ComponentTransform::GetDirection() const
 {
-	return (-front).Normalized();
+	return (-GetFront()).Normalized();
+}
+
+unsigned long long ComponentTransform::GetWorldStamp() const
+{
+	return Store()->GetWorldStamp(handle);
 }
 
 math::Quat ComponentTransform::SimulateLookAt(const math::float3& direction)
@@ -157,73 +211,81 @@ math::Quat ComponentTransform::SimulateLookAt(const math::float3& direction)
 
 void ComponentTransform::SetPosition(const math::float3& new_position)
 {
-	position = new_position;
+	RefreshDecomposition();
 
-	UpdateTransformOfHierarchy(transform_matrix_calculation_mode::LOCAL_FROM_GLOBAL);
+	SetWorldTransform(new_position, rotation, scale, rotation_euler);
 }
 
 void ComponentTransform::SetScale(const math::float3& new_scale)
 {
-	scale = new_scale;
+	RefreshDecomposition();
 
-	UpdateTransformOfHierarchy(transform_matrix_calculation_mode::LOCAL_FROM_GLOBAL);
+	SetWorldTransform(position, rotation, new_scale, rotation_euler);
 }
 
 void ComponentTransform::SetEulerRotation(const math::float3& new_rotation_euler)
 {
+	RefreshDecomposition();
+
 	math::float3 delta = (new_rotation_euler - rotation_euler) * DEG_TO_RAD;
 	math::Quat rotation_amount = math::Quat::FromEulerXYZ(delta.x, delta.y, delta.z).Normalized();
 
-	rotation = rotation_amount * (rotation);
-	rotation_euler = new_rotation_euler;
-
-	UpdateTransformOfHierarchy(transform_matrix_calculation_mode::LOCAL_FROM_GLOBAL);
+	SetWorldTransform(position, rotation_amount * (rotation), scale, new_rotation_euler);
 }
 
 void ComponentTransform::SetRotation(const math::Quat& new_rotation)
 {
-	rotation = new_rotation.Normalized();
-	rotation_euler = rotation.ToEulerXYZ().Mul(RAD_TO_DEG);
+	RefreshDecomposition();
+
+	math::Quat new_rotation_normalized = new_rotation.Normalized();
 
-	UpdateTransformOfHierarchy(transform_matrix_calculation_mode::LOCAL_FROM_GLOBAL);
+	SetWorldTransform(position, new_rotation_normalized, scale, new_rotation_normalized.ToEulerXYZ().Mul(RAD_TO_DEG));
 }
 
 void ComponentTransform::SetLocalPosition(const math::float3& new_position_local)
 {
-	position_local = new_position_local;
+	TransformStore* store = Store();
 
-	UpdateTransformOfHierarchy(transform_matrix_calculation_mode::GLOBAL_FROM_LOCAL);
+	store->SetLocal(handle, new_position_local, store->GetLocalRotation(handle), store->GetLocalScale(handle));
+
+	InvokeTransformChangedEvents();
 }
 
 void ComponentTransform::SetLocalScale(const math::float3& new_scale_local)
 {
-	scale_local = new_scale_local;
+	TransformStore* store = Store();
+
+	store->SetLocal(handle, store->GetLocalPosition(handle), store->GetLocalRotation(handle), new_scale_local);
 
-	UpdateTransformOfHierarchy(transform_matrix_calculation_mode::GLOBAL_FROM_LOCAL);
+	InvokeTransformChangedEvents();
 }
 
 void ComponentTransform::SetLocalEulerRotation(const math::float3& new_rotation_euler_local)
 {
+	TransformStore* store = Store();
+
 	math::float3 delta = (new_rotation_euler_local - rotation_euler_local) * DEG_TO_RAD;
 	math::Quat rotation_amount = math::Quat::FromEulerXYZ(delta.x, delta.y, delta.z);
 
-	rotation_local = rotation_amount * (rotation_local);
+	store->SetLocal(handle, store->GetLocalPosition(handle), rotation_amount * store->GetLocalRotation(handle), store->GetLocalScale(handle));
 	rotation_euler_local = new_rotation_euler_local;
 
-	UpdateTransformOfHierarchy(transform_matrix_calculation_mode::GLOBAL_FROM_LOCAL);
+	InvokeTransformChangedEvents();
 }
 
 void ComponentTransform::SetLocalRotation(const math::Quat& new_rotation_local)
 {
-	rotation_local = new_rotation_local;
-	rotation_euler_local = rotation_local.ToEulerXYZ() * RAD_TO_DEG;
+	TransformStore* store = Store();
+
+	store->SetLocal(handle, store->GetLocalPosition(handle), new_rotation_local, store->GetLocalScale(handle));
+	rotation_euler_local = new_rotation_local.ToEulerXYZ() * RAD_TO_DEG;
 
-	UpdateTransformOfHierarchy(transform_matrix_calculation_mode::GLOBAL_FROM_LOCAL);
+	InvokeTransformChangedEvents();
 }
 
 void ComponentTransform::Rotate(const math::Quat& rotate_by)
 {
-	SetRotation(rotate_by * rotation);
+	SetRotation(rotate_by * GetRotation());
 }
 
 void ComponentTransform::LookAt(const math::float3& direction)
@@ -241,9 +303,9 @@ void ComponentTransform::DrawInspectorContent()
 	// This controls the sensiti vity of sliders inside the transform editor:
 	static float variable_sensitivity = 1.0f;
 
-	math::float3 position_local_editor = position_local;
+	math::float3 position_local_editor = GetLocalPosition();
 	math::float3 rotation_local_editor = rotation_euler_local;
-	math::float3 scale_local_editor = scale_local;
+	math::float3 scale_local_editor = GetLocalScale();
 
 	if (ImGui::DragFloat3("Local Position", position_local_editor.ptr(), variable_sensitivity, -inf, inf)) {
 		SetLocalPosition(position_local_editor);
@@ -257,9 +319,9 @@ void ComponentTransform::DrawInspectorContent()
 
 	ImGui::NewLine();
 
-	math::float3 position_editor = position;
-	math::float3 rotation_editor = rotation_euler;
-	math::float3 scale_editor = scale;
+	math::float3 position_editor = GetPosition();
+	math::float3 rotation_editor = GetEulerRotation();
+	math::float3 scale_editor = GetScale();
 
 	if (ImGui::DragFloat3("Position", position_editor.ptr(), variable_sensitivity, -inf, inf)) {
 		SetPosition(position_editor);
@@ -275,7 +337,7 @@ void ComponentTransform::DrawInspectorContent()
 
 	if (ImGui::Button("LookAt 0,0,0"))
 	{
-		LookAt((position - float3::zero).Normalized());
+		LookAt((GetPosition() - float3::zero).Normalized());
 	}
 
 	ImGui::NewLine();
@@ -290,62 +352,98 @@ void ComponentTransform::HandleOwnerHierarchyChanged(entity_operation operation)
 		return;
 	} 
 
-	UpdateTransformOfHierarchy(transform_matrix_calculation_mode::LOCAL_FROM_GLOBAL);
+	Entity* owners_parent = owner->Parent();
+
+	// Store keeps the world matrix and recalculates local values
+	// relative to the new parent:
+	Store()->SetParent(handle, owners_parent == nullptr ? 
+		TRANSFORM_STORE_INVALID_HANDLE : 
+		owners_parent->Transform()->handle);
+
+	rotation_euler_local = Store()->GetLocalRotation(handle).ToEulerXYZ() * RAD_TO_DEG;
+
+	InvokeTransformChangedEvents();
 }
 
-void ComponentTransform::CalculateTransform(transform_matrix_calculation_mode mode)
+void ComponentTransform::SetWorldTransform(const math::float3& new_position, const math::Quat& new_rotation, const math::float3& new_scale, const math::float3& new_rotation_euler)
 {
-	Entity* owners_parent = owner->Parent();
+	TransformStore* store = Store();
 
-	switch (mode)
-	{
-		case transform_matrix_calculation_mode::LOCAL_FROM_GLOBAL:
-		{
-			matrix = float4x4::FromTRS(position, rotation, scale);
+	store->SetWorld(handle, new_position, new_rotation, new_scale);
 
-			matrix_local = owners_parent == nullptr ? 
-				matrix : 
-				owners_parent->Transform()->GetMatrix().Inverted() * matrix;
+	rotation_euler_local = store->GetLocalRotation(handle).ToEulerXYZ() * RAD_TO_DEG;
 
-			matrix_local.Decompose(position_local, rotation_local, scale_local);
+	// Keep the exact values that are set instead of decomposing
+	// them back from the new world matrix, so that euler angles 
+	// set from the editor stay as they are:
+	RefreshMatrix();
 
-			rotation_euler_local = rotation_local.ToEulerXYZ() * RAD_TO_DEG;
-		}
-		break;
+	position = new_position;
+	rotation = new_rotation;
+	scale = new_scale;
+	rotation_euler = new_rotation_euler;
+	decomposition_stamp = matrix_stamp;
 
-		case transform_matrix_calculation_mode::GLOBAL_FROM_LOCAL:
-		{
-			matrix_local = float4x4::FromTRS(position_local, rotation_local, scale_local);
+	InvokeTransformChangedEvents();
+}
 
-			matrix = owners_parent == nullptr ? 
-				matrix_local : 
-				owners_parent->Transform()->GetMatrix() * matrix_local;
+void ComponentTransform::RefreshMatrix() const
+{
+	TransformStore* store = Store();
 
-			matrix.Decompose(position, rotation, scale);
+	const unsigned long long world_stamp = store->GetWorldStamp(handle);
 
-			rotation_euler = rotation.ToEulerXYZ() * RAD_TO_DEG;
-		}
-		break;
+	if (world_stamp == matrix_stamp)
+	{
+		return;
 	}
 
+	matrix = store->GetWorldMatrix(handle);
+	matrix_stamp = world_stamp;
+
 	right = matrix.WorldX();
 	up = matrix.WorldY();
 	front = matrix.WorldZ();
 }
 
-void ComponentTransform::UpdateTransformOfHierarchy(transform_matrix_calculation_mode mode)
+void ComponentTransform::RefreshDecomposition() const
 {
-	CalculateTransform(mode);
+	RefreshMatrix();
 
-	// NOTE(Baran): This event must be invoked after new matrix is calculated.
-	owner->InvokeComponentsChangedEvents(Type());
+	if (decomposition_stamp == matrix_stamp)
+	{
+		return;
+	}
+
+	matrix.Decompose(position, rotation, scale);
+	rotation_euler = rotation.ToEulerXYZ() * RAD_TO_DEG;
+	decomposition_stamp = matrix_stamp;
+}
 
-	const std::vector<Entity*>& owner_children = owner->GetChildren();
+void ComponentTransform::RefreshInverse() const
+{
+	RefreshMatrix();
 
-	// As their parent transform is changed only, only updating
-	// the global transform matrix of children will suffice.
-	for (Entity* owner_child : owner_children)
+	if (inverse_stamp == matrix_stamp)
 	{
-		owner_child->Transform()->UpdateTransformOfHierarchy(transform_matrix_calculation_mode::GLOBAL_FROM_LOCAL);
+		return;
 	}
-}
\ No newline at end of file
+
+	inverse_matrix = matrix.Inverted();
+	normal_matrix = inverse_matrix.Float3x3Part().Transposed();
+	inverse_stamp = matrix_stamp;
+}
+
+void ComponentTransform::InvokeTransformChangedEvents()
+{
+	// NOTE(Baran): Only the owner is notified. World matrices of the 
+	// descendants are recalculated lazily by TransformStore, and the ones 
+	// that depend on them compare world stamps instead of listening to
+	// the events of every descendant.
+	owner->InvokeComponentsChangedEvents(Type());
+}
+
+TransformStore* const ComponentTransform::Store() const
+{
+	return App->scene_manager->GetTransformStore();
+}
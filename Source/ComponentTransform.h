@@ -7,30 +7,35 @@
 
 #include "MATH_GEO_LIB/Math/float3.h"
 #include "MATH_GEO_LIB/Math/Quat.h"
+#include "MATH_GEO_LIB/Math/float3x3.h"
 #include "MATH_GEO_LIB/Math/float4x4.h"
 
-enum class transform_matrix_calculation_mode
-{
-	LOCAL_FROM_GLOBAL,
-	GLOBAL_FROM_LOCAL
-};
+class TransformStore;
 
 class ComponentTransform : public Component
 {
 private:
-	math::float3					position;
-	math::float3					position_local;
-	math::float3					scale;
-	math::float3					scale_local;
-	math::float3					rotation_euler;
+	// Handle of this transform inside the TransformStore of ModuleSceneManager,
+	// local values and world matrix live there:
+	unsigned int					handle;
 	math::float3					rotation_euler_local;
-	math::Quat						rotation;
-	math::Quat						rotation_local;
-	math::float3					right;
-	math::float3					up;
-	math::float3					front;
-	math::float4x4					matrix;
-	math::float4x4					matrix_local;
+
+	// NOTE(Baran): World values below are caches of the world matrix in 
+	// TransformStore, they are refreshed lazily when the stamp of the
+	// world matrix changes.
+	mutable math::float3			position;
+	mutable math::float3			scale;
+	mutable math::float3			rotation_euler;
+	mutable math::Quat				rotation;
+	mutable math::float3			right;
+	mutable math::float3			up;
+	mutable math::float3			front;
+	mutable math::float4x4			matrix;
+	mutable math::float4x4			inverse_matrix;
+	mutable math::float3x3			normal_matrix;
+	mutable unsigned long long		matrix_stamp;
+	mutable unsigned long long		decomposition_stamp;
+	mutable unsigned long long		inverse_stamp;
 	EventListener<entity_operation> owner_hierarchy_changed_event_listener;
 
 public:
@@ -42,21 +47,25 @@ public:
 	void DrawGizmo() override;
 	
 	component_type Type() const override;
+	static constexpr component_type StaticType() { return component_type::TRANSFORM; }
 	
 	const math::float3& GetPosition() const;
 	const math::float3& GetScale() const;
 	const math::float3& GetEulerRotation() const;
-	const math::float3& GetLocalPosition() const;
-	const math::float3& GetLocalScale() const;
+	math::float3 GetLocalPosition() const;
+	math::float3 GetLocalScale() const;
 	const math::float3& GetLocalEulerRotation() const;
 	const math::Quat& GetRotation() const;
-	const math::Quat& GetLocalRotation() const;
+	math::Quat GetLocalRotation() const;
 	const math::float4x4& GetMatrix() const;
+	const math::float4x4& GetInverseMatrix() const;
+	const math::float3x3& GetNormalMatrix() const;
 	const math::float4x4 GetLocalMatrix() const;
 	const math::float3& GetRight() const;
 	const math::float3& GetUp() const;
 	const math::float3& GetFront() const;
 	const math::float3& GetDirection() const;
+	unsigned long long GetWorldStamp() const;
   static math::Quat SimulateLookAt(const math::float3& direction);
 
 	void SetPosition(const math::float3& new_position);
@@ -75,6 +84,10 @@ protected:
 
 private: 
 	void HandleOwnerHierarchyChanged(entity_operation operation);
-	void CalculateTransform(transform_matrix_calculation_mode mode);
-	void UpdateTransformOfHierarchy(transform_matrix_calculation_mode mode);
-};
\ No newline at end of file
+	void SetWorldTransform(const math::float3& new_position, const math::Quat& new_rotation, const math::float3& new_scale, const math::float3& new_rotation_euler);
+	void RefreshMatrix() const;
+	void RefreshDecomposition() const;
+	void RefreshInverse() const;
+	void InvokeTransformChangedEvents();
+	TransformStore* const Store() const;
+};
@@ -9,6 +9,7 @@ enum class component_type
 	BOUNDING_BOX,
 	MATERIAL,
 	LIGHT,
+	COUNT // Not a component type, keep it last.
 };
 
 inline const char* component_type_to_string(component_type type)
@@ -12,18 +12,35 @@
 Entity::Entity() : 
 	name(""), 
 	active(false), 
+	is_static(false),
+	is_batch_building(false),
+	is_batch_build_root(false),
+	component_types_mask(0),
 	id(0), 
 	parent(nullptr), 
+	scene(nullptr),
+	depth(0),
 	components_changed(nullptr),
 	components_changed_in_descendants(nullptr),
 	hierarchy_changed(nullptr),
 	transform(nullptr),
 	bounding_box(nullptr)
 {
+	for (size_t i = 0; i < (size_t)component_type::COUNT; ++i)
+	{
+		components_of_types[i] = nullptr;
+	}
 }
 
 Entity::~Entity()
 {
+	// Remove this and its components from the index of the scene, 
+	// children do the same for themselves when they are deleted below:
+	if (scene != nullptr)
+	{
+		scene->UnregisterEntity(this);
+	}
+
 	for (Component* component : components)
 	{
 		delete component;
@@ -53,8 +70,12 @@ void Entity::Initialize(std::string new_name)
 	active = true;
 	id = GetCurrentId();
 
-	components_changed = new Event<component_type>();
-	components_changed_in_descendants = new Event<component_type>();
+	// NOTE(Baran): Component changed events are deferred, a transform may be
+	// changed many times in a frame, and each invoke makes listeners such as
+	// bounding boxes and scene recalculate their data. This way they are 
+	// notified once per frame for each distinct component type.
+	components_changed = new Event<component_type>(event_invoke_mode::DEFERRED);
+	components_changed_in_descendants = new Event<component_type>(event_invoke_mode::DEFERRED);
 	hierarchy_changed = new Event<entity_operation>();
 
 	// Initialize and add transform component:
@@ -178,6 +199,13 @@ bool Entity::AddComponent(Component* component)
 
 	components.push_back(component);
 
+	UpdateComponentOfType(component->Type());
+
+	if (scene != nullptr)
+	{
+		scene->RegisterComponent(this, component);
+	}
+
 	// Trigger components changed events:
 	InvokeComponentsChangedEvents(component->Type());
 
@@ -210,10 +238,19 @@ void Entity::RemoveComponent(Component* component)
 
 	if (founded_component)
 	{
-		InvokeComponentsChangedEvents(component->Type());
+		component_type type = component->Type();
+
+		if (scene != nullptr)
+		{
+			scene->UnregisterComponent(this, component);
+		}
+
+		InvokeComponentsChangedEvents(type);
 
 		delete component;
 		components.erase(component_index);
+
+		UpdateComponentOfType(type);
 	}
 }
 
@@ -241,17 +278,16 @@ Component* Entity::CreateComponent(component_type type) const
 /// </summary>
 /// <param name="type">Type of component</param>
 /// <returns>First Component found in given type if it exists, nullptr if not.</returns>
-Component* const Entity::GetComponent(component_type type)
+Component* const Entity::GetComponent(component_type type) const
 {
-	for (Component* component : components)
-	{
-		if (component->Type() == type)
-		{
-			return component;
-		}
-	}
+	return components_of_types[(size_t)type];
+}
 
-	return nullptr;
+/// <param name="type">Type of component</param>
+/// <returns>True if this Entity has at least one Component of given type.</returns>
+bool Entity::HasComponent(component_type type) const
+{
+	return (component_types_mask & (1u << (unsigned int)type)) != 0;
 }
 
 const std::vector<Entity*>& Entity::GetChildren() const
@@ -296,11 +332,42 @@ Entity* const Entity::Parent() const
 	return parent;
 }
 
+Scene* const Entity::GetScene() const
+{
+	return scene;
+}
+
+/// <returns>Number of ancestors of this Entity, 0 for entities without parents.</returns>
+unsigned int Entity::Depth() const
+{
+	return depth;
+}
+
 bool Entity::IsActive() const
 {
 	return active;
 }
 
+/// <returns>True if this Entity and all of its ancestors are active.</returns>
+bool Entity::IsActiveInHierarchy() const
+{
+	for (const Entity* current = this; current != nullptr; current = current->parent)
+	{
+		if (!current->active)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// <returns>True if this Entity is static, i.e. it is not expected to move.</returns>
+bool Entity::IsStatic() const
+{
+	return is_static;
+}
+
 /// <summary>
 /// Sets this Entity's parent to new_parent. It also removes this entity from it's previous parent if 
 /// it's not nullptr, and adds this entity to the new_parent's children if new_parent is not nullptr.
@@ -315,6 +382,15 @@ void Entity::SetParent(Entity* new_parent)
 
 	parent = new_parent;
 
+	// Keep cached depths and the scene of the hierarchy in sync 
+	// with the new parent:
+	UpdateDepthOfHierarchy();
+	SetScene(parent == nullptr ? nullptr : parent->scene);
+
+	// Entities added to a subtree that is being batch built are part of
+	// the batch build as well, and the ones moved out of it are not:
+	UpdateBatchBuildingOfHierarchy();
+
 	if (parent == nullptr)
 	{
 		return;
@@ -326,6 +402,38 @@ void Entity::SetParent(Entity* new_parent)
 }
 
 
+/// <summary>
+/// Sets the scene of this Entity and all its descendants, and moves them 
+/// from the index of the previous scene to the index of new_scene. Called 
+/// by SetParent, call this directly only for the root entities of scenes.
+/// </summary>
+/// <param name="new_scene">Scene to be set, nullptr if not in any scene.</param>
+void Entity::SetScene(Scene* new_scene)
+{
+	// All the descendants are in the same scene with this:
+	if (new_scene == scene)
+	{
+		return;
+	}
+
+	if (scene != nullptr)
+	{
+		scene->UnregisterEntity(this);
+	}
+
+	scene = new_scene;
+
+	if (scene != nullptr)
+	{
+		scene->RegisterEntity(this);
+	}
+
+	for (Entity* child : children)
+	{
+		child->SetScene(new_scene);
+	}
+}
+
 /// <summary>
 /// Defines if this Entity is active or not.
 /// </summary>
@@ -335,6 +443,30 @@ void Entity::SetActive(bool activeness)
 	active = activeness;
 }
 
+/// <summary>
+/// Marks this Entity and all its descendants as static or dynamic. Static entities
+/// are kept in the spatial index of their scene and are culled hierarchically, so
+/// they should rarely move.
+/// </summary>
+/// <param name="staticness">True if Entity should be set as static, false if it should be set as dynamic.</param>
+void Entity::SetStatic(bool staticness)
+{
+	if (is_static != staticness)
+	{
+		is_static = staticness;
+
+		if (scene != nullptr)
+		{
+			scene->HandleStaticnessChanged(this);
+		}
+	}
+
+	for (Entity* child : children)
+	{
+		child->SetStatic(staticness);
+	}
+}
+
 /// <summary>
 /// Adds given child to this Entity if such child with same id is not in children already.
 /// As this only adds child to the Entity and does not set it's parent and SetParent already
@@ -350,6 +482,11 @@ void Entity::AddChild(Entity* child)
 
 	children.push_back(child);
 
+	if (is_batch_building)
+	{
+		return;
+	}
+
 	hierarchy_changed->Invoke(entity_operation::CHILDREN_CHANGED);
 }
 
@@ -381,6 +518,11 @@ void Entity::RemoveChild(Entity* child)
 		children.erase(child_index);
 	}
 
+	if (is_batch_building)
+	{
+		return;
+	}
+
 	InvokeChildHierarchyChangedEventRecursively();
 }
 
@@ -411,8 +553,39 @@ bool Entity::HasDescendant(unsigned int descendant_entity_id) const
 	return FindDescendant(descendant_entity_id) != nullptr;
 }
 
+/// <summary>
+/// Walks up from this Entity until the depth of ancestor is reached, O(depth).
+/// </summary>
+/// <param name="ancestor">Entity that is checked to be an ancestor of this.</param>
+/// <returns>True if ancestor is an ancestor of this Entity.</returns>
+bool Entity::IsDescendantOf(const Entity* ancestor) const
+{
+	if (ancestor == nullptr || ancestor->depth >= depth)
+	{
+		return false;
+	}
+
+	const Entity* current = this;
+
+	while (current->depth > ancestor->depth)
+	{
+		current = current->parent;
+	}
+
+	return current == ancestor;
+}
+
 Entity* Entity::FindDescendant(unsigned int descendant_entity_id) const
 {
+	// If this is in a scene, look the entity up from the index 
+	// of the scene instead of searching the whole hierarchy:
+	if (scene != nullptr)
+	{
+		Entity* entity = scene->FindEntity(descendant_entity_id);
+
+		return entity != nullptr && entity->IsDescendantOf(this) ? entity : nullptr;
+	}
+
 	if (children.size() > 0)
 	{
 		for (Entity* child : children)
@@ -436,7 +609,23 @@ Entity* Entity::FindDescendant(unsigned int descendant_entity_id) const
 
 std::vector<Entity*> Entity::GetAllDescendants() const
 {
-	return std::vector<Entity*>();
+	std::vector<Entity*> descendants;
+
+	GetAllDescendants(descendants);
+
+	return descendants;
+}
+
+/// <summary>
+/// Appends all the descendants of this Entity to output, parents come before their children.
+/// </summary>
+/// <param name="output">Vector to append the descendants to.</param>
+void Entity::GetAllDescendants(std::vector<Entity*>& output) const
+{
+	ForEachDescendant([&output](Entity* descendant)
+	{
+		output.push_back(descendant);
+	});
 }
 
 void Entity::InvokeChildHierarchyChangedEventRecursively() const
@@ -449,8 +638,70 @@ void Entity::InvokeChildHierarchyChangedEventRecursively() const
 	}
 }
 
+/// <summary>
+/// Starts batch building this Entity. Until EndBatchBuild is called, this Entity
+/// and the entities parented under it don't invoke their components changed and 
+/// children changed events, so that building a big subtree off-scene doesn't notify 
+/// the listeners once per each entity and component. PARENT_CHANGED is still invoked
+/// since the components of the entity itself depend on it (e.g ComponentTransform).
+/// </summary>
+void Entity::BeginBatchBuild()
+{
+	is_batch_building = true;
+	is_batch_build_root = true;
+}
+
+/// <summary>
+/// Ends batch building of this Entity and all its descendants, and sends a single
+/// consolidated notification for the built subtree.
+/// </summary>
+void Entity::EndBatchBuild()
+{
+	std::vector<Entity*> entities_to_visit;
+	entities_to_visit.push_back(this);
+
+	while (!entities_to_visit.empty())
+	{
+		Entity* entity = entities_to_visit.back();
+		entities_to_visit.pop_back();
+
+		entity->is_batch_building = false;
+		entity->is_batch_build_root = false;
+
+		// Components changed events were not invoked, so bounding 
+		// boxes are not aware of the meshes added:
+		entity->bounding_box->MarkDirty();
+
+		for (Entity* child : entity->children)
+		{
+			entities_to_visit.push_back(child);
+		}
+	}
+
+	InvokeChildHierarchyChangedEventRecursively();
+}
+
+bool Entity::IsBatchBuilding() const
+{
+	return is_batch_building;
+}
+
 void Entity::InvokeComponentsChangedEvents(component_type type) const
 {
+	if (is_batch_building)
+	{
+		return;
+	}
+
+	// Scene is told immediately which entity has changed, since the 
+	// deferred events below only carry the type of the change. Transform
+	// changes of dynamic entities are told as well, as they move the 
+	// static descendants along:
+	if (scene != nullptr && (is_static || type == component_type::TRANSFORM))
+	{
+		scene->HandleEntityChanged(this, type);
+	}
+
 	components_changed->Invoke(type);
 
 	if (parent != nullptr)
@@ -511,4 +762,79 @@ Component* Entity::FindComponentById(unsigned int id) const
 	}
 
 	return nullptr;
+}
+
+/// <summary>
+/// Updates the first component of given type and the type mask,
+/// called whenever a Component of given type is added or removed.
+/// </summary>
+/// <param name="type">Type of the added/removed Component.</param>
+void Entity::UpdateComponentOfType(component_type type)
+{
+	Component* first_component_of_type = nullptr;
+
+	for (Component* component : components)
+	{
+		if (component->Type() == type)
+		{
+			first_component_of_type = component;
+			break;
+		}
+	}
+
+	components_of_types[(size_t)type] = first_component_of_type;
+
+	if (first_component_of_type != nullptr)
+	{
+		component_types_mask |= (1u << (unsigned int)type);
+	}
+	else
+	{
+		component_types_mask &= ~(1u << (unsigned int)type);
+	}
+}
+
+/// <summary>
+/// Recalculates the cached depth of this Entity and all its descendants
+/// from their parents, called when the parent is changed.
+/// </summary>
+void Entity::UpdateDepthOfHierarchy()
+{
+	depth = parent == nullptr ? 0 : parent->depth + 1;
+
+	// Parents are visited before their children:
+	ForEachDescendant([](Entity* descendant)
+	{
+		descendant->depth = descendant->parent->depth + 1;
+	});
+}
+
+/// <summary>
+/// Recalculates is_batch_building of this Entity and its descendants from
+/// their parents, called when the parent is changed. Entities that leave a
+/// batch build have their bounding boxes marked dirty like EndBatchBuild 
+/// does, since the changes made during the batch build were not notified.
+/// </summary>
+void Entity::UpdateBatchBuildingOfHierarchy()
+{
+	const bool should_batch_build = is_batch_build_root || 
+		(parent != nullptr && parent->is_batch_building);
+
+	// Descendants are already in sync with this:
+	if (should_batch_build == is_batch_building)
+	{
+		return;
+	}
+
+	is_batch_building = should_batch_build;
+
+	if (!is_batch_building)
+	{
+		bounding_box->MarkDirty();
+	}
+
+	for (Entity* child : children)
+	{
+		child->UpdateBatchBuildingOfHierarchy();
+	}
 }
\ No newline at end of file
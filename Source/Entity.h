@@ -12,7 +12,9 @@
 #define COMPONENT_VOID template <class COMPONENT_TYPE> TYPE_IF_DERIVED_CLASS(Component, COMPONENT_TYPE, void)
 #define COMPONENT_PTR_CONST template <class COMPONENT_TYPE> TYPE_IF_DERIVED_CLASS(Component, COMPONENT_TYPE, COMPONENT_TYPE* const)
 #define COMPONENT_VECTOR template <class COMPONENT_TYPE> TYPE_IF_DERIVED_CLASS(Component, COMPONENT_TYPE, std::vector<COMPONENT_TYPE*>)
+#define COMPONENT_VISITOR_VOID template <class COMPONENT_TYPE, typename VISITOR> TYPE_IF_DERIVED_CLASS(Component, COMPONENT_TYPE, void)
 
+class Scene;
 class Component;
 class ComponentTransform;
 class ComponentBoundingBox;
@@ -23,14 +25,23 @@ private:
 	ComponentTransform* transform;
 	ComponentBoundingBox* bounding_box;
 	std::vector<Component*> components;
+	// First component of each type, indexed by component_type:
+	Component* components_of_types[(size_t)component_type::COUNT];
+	// Bit i is set if this has a component of type i:
+	unsigned int component_types_mask;
 	std::vector<Entity*> children;
 	Event<component_type>* components_changed;
 	Event<component_type>* components_changed_in_descendants;
 	Event<entity_operation>* hierarchy_changed;
 	Entity* parent;
+	Scene* scene; // Scene this Entity is in, nullptr if it's not in any scene.
 	std::string name;
 	unsigned int id;
+	unsigned int depth; // Number of ancestors of this Entity.
 	bool active;
+	bool is_static; // Static entities are kept in the spatial index of the scene.
+	bool is_batch_building;
+	bool is_batch_build_root; // True from BeginBatchBuild until EndBatchBuild of this Entity.
 
 public:
 	Entity();
@@ -55,7 +66,21 @@ public:
 	COMPONENT_VECTOR GetComponentsIncludingChildren() const;
 	COMPONENT_VECTOR GetComponentsInDescendants() const;
 
-	Component* const GetComponent(component_type type);
+	// NOTE: Overloads below append to a vector owned by the caller instead of
+	// returning a new one, so the same vector can be reused between calls:
+	COMPONENT_VOID GetComponents(std::vector<COMPONENT_TYPE*>& output) const;
+	COMPONENT_VOID GetComponentsInChildren(std::vector<COMPONENT_TYPE*>& output) const;
+	COMPONENT_VOID GetComponentsIncludingChildren(std::vector<COMPONENT_TYPE*>& output) const;
+	COMPONENT_VOID GetComponentsInDescendants(std::vector<COMPONENT_TYPE*>& output) const;
+
+	// NOTE: Visitors are called with COMPONENT_TYPE* for each component found,
+	// nothing is allocated while traversing:
+	COMPONENT_VISITOR_VOID ForEachComponent(VISITOR&& visitor) const;
+	COMPONENT_VISITOR_VOID ForEachComponentInDescendants(VISITOR&& visitor) const;
+	template <typename VISITOR> void ForEachDescendant(VISITOR&& visitor) const;
+
+	Component* const GetComponent(component_type type) const;
+	bool HasComponent(component_type type) const;
 
 	const std::vector<Component*>& Components() const;
 
@@ -63,16 +88,28 @@ public:
 	const std::string& Name() const;
 	unsigned int Id() const;
 	Entity* const Parent() const;
+	Scene* const GetScene() const;
+	unsigned int Depth() const;
 	bool IsActive() const;
+	bool IsActiveInHierarchy() const;
+	bool IsStatic() const;
 	void SetParent(Entity* new_parent);
+	void SetScene(Scene* new_scene);
 	void SetActive(bool activeness);
+	void SetStatic(bool staticness);
 
 	void AddChild(Entity* child);
 	void RemoveChild(Entity* child);
 	Entity* FindChild(unsigned int child_entity_id) const;
 	bool HasDescendant(unsigned int descendant_entity_id) const;
+	bool IsDescendantOf(const Entity* ancestor) const;
 	Entity* FindDescendant(unsigned int descendant_entity_id) const;
 	std::vector<Entity*> GetAllDescendants() const;
+	void GetAllDescendants(std::vector<Entity*>& output) const;
+
+	void BeginBatchBuild();
+	void EndBatchBuild();
+	bool IsBatchBuilding() const;
 
 	void InvokeChildHierarchyChangedEventRecursively() const;
 	void InvokeComponentsChangedEvents(component_type type) const;
@@ -84,6 +121,9 @@ public:
 
 private:
 	Component* FindComponentById(unsigned int id) const;
+	void UpdateComponentOfType(component_type type);
+	void UpdateDepthOfHierarchy();
+	void UpdateBatchBuildingOfHierarchy();
 	unsigned int GetCurrentId();
 };
 
@@ -110,43 +150,14 @@ COMPONENT_VOID Entity::AddComponent()
 
 COMPONENT_PTR_CONST Entity::GetComponent() const
 {
-	component_type type = COMPONENT_TYPE().Type();
-
-	for (Component* component : components)
-	{
-		if (component->Type() == type)
-		{
-			return (COMPONENT_TYPE*)component;
-		}
-	}
-
-	return nullptr;
+	return (COMPONENT_TYPE*)components_of_types[(size_t)COMPONENT_TYPE::StaticType()];
 }
 
 COMPONENT_VECTOR Entity::GetComponents() const
 {
-	component_type type = COMPONENT_TYPE().Type();
-
 	std::vector<COMPONENT_TYPE*> components_of_type;
 
-	components_of_type.reserve(components.size());
-
-	for (Component* component : components)
-	{
-		if (component->Type() == type)
-		{
-			components_of_type.push_back((COMPONENT_TYPE*) component);
-
-			// If there is meant to be only one Component of this type
-			// in the Entity, break out of the loop once a Component of
-			// this type is found:
-			if (!Component::CanBeMoreThanOne(type))
-			{
-				break;
-			}
-
-		}
-	}
+	GetComponents<COMPONENT_TYPE>(components_of_type);
 
 	return components_of_type;
 }
@@ -155,32 +166,16 @@ COMPONENT_VECTOR Entity::GetComponentsInChildren() const
 {
 	std::vector<COMPONENT_TYPE*> components_in_children;
 
-	for (Entity* child : children)
-	{
-		std::vector<COMPONENT_TYPE*> components_in_child = child->GetComponents<COMPONENT_TYPE>();
-
-		for (COMPONENT_TYPE* component : components_in_child)
-		{
-			components_in_children.push_back(component);
-		}
-	}
+	GetComponentsInChildren<COMPONENT_TYPE>(components_in_children);
 
 	return components_in_children;
 }
 
 COMPONENT_VECTOR Entity::GetComponentsIncludingChildren() const
 {
-	std::vector<COMPONENT_TYPE*> components_including_children = GetComponents<COMPONENT_TYPE>();
+	std::vector<COMPONENT_TYPE*> components_including_children;
 
-	for (Entity* child : children)
-	{
-		std::vector<COMPONENT_TYPE*> components_in_child = child->GetComponents<COMPONENT_TYPE>();
-
-		for (COMPONENT_TYPE* component : components_in_child)
-		{
-			components_including_children.push_back(component);
-		}
-	}
+	GetComponentsIncludingChildren<COMPONENT_TYPE>(components_including_children);
 
 	return components_including_children;
 }
@@ -189,24 +184,89 @@ COMPONENT_VECTOR Entity::GetComponentsInDescendants() const
 {
 	std::vector<COMPONENT_TYPE*> components_in_descendants;
 
+	GetComponentsInDescendants<COMPONENT_TYPE>(components_in_descendants);
+
+	return components_in_descendants;
+}
+
+COMPONENT_VOID Entity::GetComponents(std::vector<COMPONENT_TYPE*>& output) const
+{
+	ForEachComponent<COMPONENT_TYPE>([&output](COMPONENT_TYPE* component)
+	{
+		output.push_back(component);
+	});
+}
+
+COMPONENT_VOID Entity::GetComponentsInChildren(std::vector<COMPONENT_TYPE*>& output) const
+{
 	for (Entity* child : children)
 	{
-		std::vector<COMPONENT_TYPE*> components_in_child = child->GetComponents<COMPONENT_TYPE>();
+		child->GetComponents<COMPONENT_TYPE>(output);
+	}
+}
 
-		for (COMPONENT_TYPE* component_in_child : components_in_child)
-		{
-			components_in_descendants.push_back(component_in_child);
+COMPONENT_VOID Entity::GetComponentsIncludingChildren(std::vector<COMPONENT_TYPE*>& output) const
+{
+	GetComponents<COMPONENT_TYPE>(output);
 
-		}
+	GetComponentsInChildren<COMPONENT_TYPE>(output);
+}
 
-		std::vector<COMPONENT_TYPE*> components_in_childs_descendants = child->GetComponentsInDescendants<COMPONENT_TYPE>();
+COMPONENT_VOID Entity::GetComponentsInDescendants(std::vector<COMPONENT_TYPE*>& output) const
+{
+	ForEachComponentInDescendants<COMPONENT_TYPE>([&output](COMPONENT_TYPE* component)
+	{
+		output.push_back(component);
+	});
+}
 
-		for (COMPONENT_TYPE* component_in_childs_descendants : components_in_childs_descendants)
-		{
-			components_in_descendants.push_back(component_in_childs_descendants);
+COMPONENT_VISITOR_VOID Entity::ForEachComponent(VISITOR&& visitor) const
+{
+	component_type type = COMPONENT_TYPE::StaticType();
+
+	if (!HasComponent(type))
+	{
+		return;
+	}
+
+	// If there is meant to be only one Component of this type
+	// in the Entity, no need to search for it:
+	if (!Component::CanBeMoreThanOne(type))
+	{
+		visitor((COMPONENT_TYPE*)components_of_types[(size_t)type]);
 
+		return;
+	}
+
+	for (Component* component : components)
+	{
+		if (component->Type() == type)
+		{
+			visitor((COMPONENT_TYPE*)component);
 		}
 	}
+}
 
-	return components_in_descendants;
+COMPONENT_VISITOR_VOID Entity::ForEachComponentInDescendants(VISITOR&& visitor) const
+{
+	ForEachDescendant([&visitor](Entity* descendant)
+	{
+		descendant->ForEachComponent<COMPONENT_TYPE>(visitor);
+	});
+}
+
+/// <summary>
+/// Calls visitor with each descendant of this Entity, in depth first order 
+/// where a parent is visited before its children.
+/// </summary>
+/// <param name="visitor">Callable that takes Entity*.</param>
+template <typename VISITOR>
+inline void Entity::ForEachDescendant(VISITOR&& visitor) const
+{
+	for (Entity* child : children)
+	{
+		visitor(child);
+
+		child->ForEachDescendant(visitor);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "Event.h"
+
+std::vector<EventBase*> DeferredEventQueue::events;
+
+EventBase::EventBase() : 
+	is_queued(false)
+{
+}
+
+EventBase::~EventBase()
+{
+	// Make sure a deleted event is never flushed:
+	if (is_queued)
+	{
+		DeferredEventQueue::Remove(this);
+	}
+}
+
+void EventBase::Enqueue()
+{
+	if (is_queued)
+	{
+		return;
+	}
+
+	DeferredEventQueue::Add(this);
+}
+
+void DeferredEventQueue::Flush()
+{
+	// NOTE: events may grow while flushing since listeners can invoke 
+	// other deferred events, and removed events are set to nullptr 
+	// instead of being erased, so iterate by index:
+	for (size_t i = 0; i < events.size(); ++i)
+	{
+		EventBase* event = events[i];
+
+		if (event == nullptr)
+		{
+			continue;
+		}
+
+		// Mark it as not queued before invoking, so that if it's invoked 
+		// by one of the listeners, it's added to the end again:
+		event->is_queued = false;
+		events[i] = nullptr;
+
+		event->InvokeQueued();
+	}
+
+	events.clear();
+}
+
+void DeferredEventQueue::Add(EventBase* event)
+{
+	event->is_queued = true;
+
+	events.push_back(event);
+}
+
+void DeferredEventQueue::Remove(EventBase* event)
+{
+	std::vector<EventBase*>::iterator event_index = std::find(events.begin(), events.end(), event);
+
+	if (event_index != events.end())
+	{
+		*event_index = nullptr;
+	}
+
+	event->is_queued = false;
+}
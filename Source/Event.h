@@ -1,6 +1,9 @@
 #pragma once
 
 #include <vector>
+#include <tuple>
+#include <algorithm>
+#include <utility>
 #include <functional>
 
 #include "Globals.h"
@@ -32,22 +35,103 @@ inline EventListener<ARGS...>::EventListener(std::function<void(ARGS... args)> n
 	callback = new_callback;
 }
 
+enum class event_invoke_mode
+{
+	IMMEDIATE,	// Listeners are called inside Invoke.
+	DEFERRED	// Invokes are queued, deduplicated and the listeners are 
+				// called once per distinct arguments on DeferredEventQueue::Flush.
+};
+
+/// <summary>
+/// Non template base of Event, so that DeferredEventQueue can hold 
+/// events of any argument types.
+/// </summary>
+class EventBase
+{
+	friend class DeferredEventQueue;
+
+private:
+	/// <summary>
+	/// True if this is inside DeferredEventQueue waiting to be flushed.
+	/// </summary>
+	bool is_queued;
+
+public:
+	EventBase();
+	virtual ~EventBase();
+
+protected:
+	/// <summary>
+	/// Adds this to DeferredEventQueue if it's not already in it.
+	/// </summary>
+	void Enqueue();
+
+	/// <summary>
+	/// Calls the listeners with the queued arguments. Called by
+	/// DeferredEventQueue::Flush.
+	/// </summary>
+	virtual void InvokeQueued() = 0;
+};
+
+/// <summary>
+/// Holds the deferred events that are invoked since the last Flush.
+/// </summary>
+class DeferredEventQueue
+{
+	friend class EventBase;
+
+private:
+	static std::vector<EventBase*> events;
+
+public:
+	/// <summary>
+	/// Calls the listeners of every queued event. Events invoked by the
+	/// listeners while flushing are flushed as well. Called once per frame
+	/// by Application::Update.
+	/// </summary>
+	static void Flush();
+
+private:
+	static void Add(EventBase* event);
+	static void Remove(EventBase* event);
+};
+
 // NOTE: Right now this Event template class only accepts functions with 
 // any type/number of parameters but only with return type of void.
 // Support for other return types may be added in the future.
 
-template<typename... ARGS> class Event
+template<typename... ARGS> class Event : public EventBase
 {
 private:
 	std::vector<EventListener<ARGS...>*> listeners;
+	std::vector<std::tuple<ARGS...>> queued_arguments;
+	event_invoke_mode mode;
 
 public:
+	Event(event_invoke_mode new_mode = event_invoke_mode::IMMEDIATE);
+
 	void AddListener(EventListener<ARGS...>* listener);
 	void RemoveListener(EventListener<ARGS...>* listener);
 	void RemoveAllListeners();
 	void Invoke(ARGS... args);
+
+protected:
+	void InvokeQueued() override;
+
+private:
+	void InvokeListeners(ARGS... args);
+
+	template<size_t... INDICES>
+	void InvokeListeners(const std::tuple<ARGS...>& arguments, std::index_sequence<INDICES...>);
 };
 
+template<typename... ARGS>
+inline Event<ARGS...>::Event(event_invoke_mode new_mode) :
+	EventBase(),
+	mode(new_mode)
+{
+}
+
 template<typename... ARGS>
 inline void Event<ARGS...>::AddListener(EventListener<ARGS...>* listener)
 {
@@ -88,9 +172,55 @@ inline void Event<ARGS...>::RemoveAllListeners()
 
 template<typename... ARGS>
 inline void Event<ARGS...>::Invoke(ARGS... args)
+{
+	if (mode == event_invoke_mode::IMMEDIATE)
+	{
+		InvokeListeners(args...);
+
+		return;
+	}
+
+	// Queue arguments only if the same arguments are not queued already,
+	// so that listeners are called once no matter how many times the
+	// event is invoked until the next flush:
+	std::tuple<ARGS...> arguments(args...);
+
+	if (std::find(queued_arguments.begin(), queued_arguments.end(), arguments) != queued_arguments.end())
+	{
+		return;
+	}
+
+	queued_arguments.push_back(arguments);
+
+	Enqueue();
+}
+
+template<typename... ARGS>
+inline void Event<ARGS...>::InvokeQueued()
+{
+	// Swap the queue with an empty one, as listeners may invoke
+	// this event again while we are iterating:
+	std::vector<std::tuple<ARGS...>> arguments_to_invoke;
+	arguments_to_invoke.swap(queued_arguments);
+
+	for (const std::tuple<ARGS...>& arguments : arguments_to_invoke)
+	{
+		InvokeListeners(arguments, std::index_sequence_for<ARGS...>());
+	}
+}
+
+template<typename... ARGS>
+inline void Event<ARGS...>::InvokeListeners(ARGS... args)
 {
 	for (EventListener<ARGS...>* listener : listeners)
 	{
 		(*listener)(args...);
 	}
+}
+
+template<typename... ARGS>
+template<size_t... INDICES>
+inline void Event<ARGS...>::InvokeListeners(const std::tuple<ARGS...>& arguments, std::index_sequence<INDICES...>)
+{
+	InvokeListeners(std::get<INDICES>(arguments)...);
 }
\ No newline at end of file
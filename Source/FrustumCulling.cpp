@@ -0,0 +1,262 @@
+#include "FrustumCulling.h"
+
+#include "MATH_GEO_LIB/MathBuildConfig.h"
+#include "MATH_GEO_LIB/Geometry/Plane.h"
+#include "MATH_GEO_LIB/Math/MathFunc.h"
+
+#include <cfloat>
+
+// SSE is part of the x64 baseline, so it doesn't depend on MathGeoLib
+// being built with MATH_SSE:
+#if defined(MATH_SSE) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define FRUSTUM_CULLING_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace StrawMath
+{
+	void CullingVolumes::Add(const math::AABB& bounding_box, float sphere_radius)
+	{
+		math::float3 center = bounding_box.CenterPoint();
+		math::float3 half_size = bounding_box.HalfSize();
+
+		center_x.push_back(center.x);
+		center_y.push_back(center.y);
+		center_z.push_back(center.z);
+		half_size_x.push_back(half_size.x);
+		half_size_y.push_back(half_size.y);
+		half_size_z.push_back(half_size.z);
+		radius.push_back(sphere_radius);
+	}
+
+	void CullingVolumes::Set(size_t index, const math::AABB& bounding_box, float sphere_radius)
+	{
+		math::float3 center = bounding_box.CenterPoint();
+		math::float3 half_size = bounding_box.HalfSize();
+
+		center_x[index] = center.x;
+		center_y[index] = center.y;
+		center_z[index] = center.z;
+		half_size_x[index] = half_size.x;
+		half_size_y[index] = half_size.y;
+		half_size_z[index] = half_size.z;
+		radius[index] = sphere_radius;
+	}
+
+	/// <summary>
+	/// Makes volume at index pass every plane test. FLT_MAX is used instead
+	/// of infinity, as infinity times a zero normal component would be NaN.
+	/// </summary>
+	void CullingVolumes::SetAlwaysVisible(size_t index)
+	{
+		center_x[index] = 0.0f;
+		center_y[index] = 0.0f;
+		center_z[index] = 0.0f;
+		half_size_x[index] = FLT_MAX;
+		half_size_y[index] = FLT_MAX;
+		half_size_z[index] = FLT_MAX;
+		radius[index] = FLT_MAX;
+	}
+
+	/// <summary>
+	/// Makes volume at index fail the sphere test of every plane.
+	/// </summary>
+	void CullingVolumes::SetNeverVisible(size_t index)
+	{
+		center_x[index] = 0.0f;
+		center_y[index] = 0.0f;
+		center_z[index] = 0.0f;
+		half_size_x[index] = 0.0f;
+		half_size_y[index] = 0.0f;
+		half_size_z[index] = 0.0f;
+		radius[index] = -FLT_MAX;
+	}
+
+	void CullingVolumes::Resize(size_t new_size)
+	{
+		center_x.resize(new_size);
+		center_y.resize(new_size);
+		center_z.resize(new_size);
+		half_size_x.resize(new_size);
+		half_size_y.resize(new_size);
+		half_size_z.resize(new_size);
+		radius.resize(new_size);
+	}
+
+	void CullingVolumes::Clear()
+	{
+		center_x.clear();
+		center_y.clear();
+		center_z.clear();
+		half_size_x.clear();
+		half_size_y.clear();
+		half_size_z.clear();
+		radius.clear();
+	}
+
+	size_t CullingVolumes::Size() const
+	{
+		return center_x.size();
+	}
+
+	/// <summary>
+	/// Tests volumes in [begin, end) one by one and sets their bits.
+	/// </summary>
+	static void CullVolumesScalar(const math::Plane* planes, const CullingVolumes& volumes, size_t begin, size_t end, std::vector<unsigned int>& visibility)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			bool is_visible = true;
+
+			for (size_t p = 0; p < 6 && is_visible; ++p)
+			{
+				const math::Plane& plane = planes[p];
+
+				// Normals of the planes point outwards, so positive
+				// distances are outside the frustum:
+				float distance =
+					plane.normal.x * volumes.center_x[i] +
+					plane.normal.y * volumes.center_y[i] +
+					plane.normal.z * volumes.center_z[i] - plane.d;
+
+				// Projection of the AABB's half size on the normal:
+				float extent =
+					math::Abs(plane.normal.x) * volumes.half_size_x[i] +
+					math::Abs(plane.normal.y) * volumes.half_size_y[i] +
+					math::Abs(plane.normal.z) * volumes.half_size_z[i];
+
+				is_visible = distance <= volumes.radius[i] && distance <= extent;
+			}
+
+			if (is_visible)
+			{
+				visibility[i / 32] |= 1u << (i % 32);
+			}
+		}
+	}
+
+	static void ResetVisibility(const CullingVolumes& volumes, std::vector<unsigned int>& visibility)
+	{
+		visibility.assign((volumes.Size() + 31) / 32, 0u);
+	}
+
+	void CullVolumesScalar(const math::Frustum& frustum, const CullingVolumes& volumes, std::vector<unsigned int>& visibility)
+	{
+		math::Plane planes[6];
+		frustum.GetPlanes(planes);
+
+		ResetVisibility(volumes, visibility);
+
+		CullVolumesScalar(planes, volumes, 0, volumes.Size(), visibility);
+	}
+
+#ifdef FRUSTUM_CULLING_SSE
+	/// <summary>
+	/// Tests volumes in [begin, end) 4 at a time and sets their bits, begin
+	/// must be a multiple of 4. Remaining volumes are tested one by one.
+	/// </summary>
+	static void CullVolumesSSE(const math::Plane* planes, const CullingVolumes& volumes, size_t begin, size_t end, std::vector<unsigned int>& visibility)
+	{
+		// Broadcast each plane component to all 4 lanes once:
+		__m128 normal_x[6];
+		__m128 normal_y[6];
+		__m128 normal_z[6];
+		__m128 absolute_normal_x[6];
+		__m128 absolute_normal_y[6];
+		__m128 absolute_normal_z[6];
+		__m128 plane_d[6];
+
+		for (size_t p = 0; p < 6; ++p)
+		{
+			normal_x[p] = _mm_set1_ps(planes[p].normal.x);
+			normal_y[p] = _mm_set1_ps(planes[p].normal.y);
+			normal_z[p] = _mm_set1_ps(planes[p].normal.z);
+			absolute_normal_x[p] = _mm_set1_ps(math::Abs(planes[p].normal.x));
+			absolute_normal_y[p] = _mm_set1_ps(math::Abs(planes[p].normal.y));
+			absolute_normal_z[p] = _mm_set1_ps(math::Abs(planes[p].normal.z));
+			plane_d[p] = _mm_set1_ps(planes[p].d);
+		}
+
+		const size_t simd_end = end - (end - begin) % 4;
+
+		for (size_t i = begin; i < simd_end; i += 4)
+		{
+			__m128 center_x = _mm_loadu_ps(&volumes.center_x[i]);
+			__m128 center_y = _mm_loadu_ps(&volumes.center_y[i]);
+			__m128 center_z = _mm_loadu_ps(&volumes.center_z[i]);
+			__m128 radius = _mm_loadu_ps(&volumes.radius[i]);
+
+			// Sphere pre-pass, distances are kept for the AABB test:
+			__m128 distances[6];
+			__m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+
+			for (size_t p = 0; p < 6; ++p)
+			{
+				distances[p] = _mm_sub_ps(
+					_mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(normal_x[p], center_x), _mm_mul_ps(normal_y[p], center_y)),
+						_mm_mul_ps(normal_z[p], center_z)),
+					plane_d[p]);
+
+				inside = _mm_and_ps(inside, _mm_cmple_ps(distances[p], radius));
+			}
+
+			// All 4 spheres are outside, no need to test the AABBs:
+			if (_mm_movemask_ps(inside) == 0)
+			{
+				continue;
+			}
+
+			__m128 half_size_x = _mm_loadu_ps(&volumes.half_size_x[i]);
+			__m128 half_size_y = _mm_loadu_ps(&volumes.half_size_y[i]);
+			__m128 half_size_z = _mm_loadu_ps(&volumes.half_size_z[i]);
+
+			for (size_t p = 0; p < 6; ++p)
+			{
+				__m128 extent = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(absolute_normal_x[p], half_size_x), _mm_mul_ps(absolute_normal_y[p], half_size_y)),
+					_mm_mul_ps(absolute_normal_z[p], half_size_z));
+
+				inside = _mm_and_ps(inside, _mm_cmple_ps(distances[p], extent));
+			}
+
+			// i is a multiple of 4, so the 4 bits never cross an element:
+			visibility[i / 32] |= (unsigned int)_mm_movemask_ps(inside) << (i % 32);
+		}
+
+		// Remaining volumes that don't fill 4 lanes:
+		CullVolumesScalar(planes, volumes, simd_end, end, visibility);
+	}
+#endif
+
+	void CullVolumes(const math::Frustum& frustum, const CullingVolumes& volumes, std::vector<unsigned int>& visibility)
+	{
+		ResetVisibility(volumes, visibility);
+
+		CullVolumes(frustum, volumes, 0, volumes.Size(), visibility);
+	}
+
+	void CullVolumes(const math::Frustum& frustum, const CullingVolumes& volumes, size_t begin, size_t end, std::vector<unsigned int>& visibility)
+	{
+		if (begin >= end)
+		{
+			return;
+		}
+
+		// begin is a multiple of 32, so the elements in this range only hold
+		// bits of volumes in this range:
+		for (size_t i = begin / 32; i < (end + 31) / 32; ++i)
+		{
+			visibility[i] = 0u;
+		}
+
+		math::Plane planes[6];
+		frustum.GetPlanes(planes);
+
+#ifdef FRUSTUM_CULLING_SSE
+		CullVolumesSSE(planes, volumes, begin, end, visibility);
+#else
+		CullVolumesScalar(planes, volumes, begin, end, visibility);
+#endif
+	}
+}
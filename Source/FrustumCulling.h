@@ -0,0 +1,71 @@
+#pragma once
+
+#include "MATH_GEO_LIB/Geometry/AABB.h"
+#include "MATH_GEO_LIB/Geometry/Frustum.h"
+#include "MATH_GEO_LIB/Math/float3.h"
+
+#include <vector>
+
+namespace StrawMath
+{
+	/// <summary>
+	/// Bounding volumes to be culled, stored as structure of arrays so that
+	/// the culling kernel can load the same component of 4 volumes at once.
+	/// Each volume is an AABB given by its center and half size, and a
+	/// sphere with the same center. Volumes can also be set to be always or
+	/// never visible, so that items that must not be tested keep their index.
+	/// </summary>
+	class CullingVolumes
+	{
+	public:
+		std::vector<float> center_x;
+		std::vector<float> center_y;
+		std::vector<float> center_z;
+		std::vector<float> half_size_x;
+		std::vector<float> half_size_y;
+		std::vector<float> half_size_z;
+		std::vector<float> radius;
+
+	public:
+		void Add(const math::AABB& bounding_box, float sphere_radius);
+		void Set(size_t index, const math::AABB& bounding_box, float sphere_radius);
+		void SetAlwaysVisible(size_t index);
+		void SetNeverVisible(size_t index);
+		void Resize(size_t new_size);
+		void Clear();
+		size_t Size() const;
+	};
+
+	/// <summary>
+	/// Tests each volume against the six planes of frustum, and sets bit i of
+	/// visibility if volume i may be inside frustum. Volumes that are outside
+	/// either their sphere or their AABB are culled. Uses SSE when the target
+	/// supports it, processing 4 volumes at a time.
+	/// </summary>
+	/// <param name="frustum">Frustum to cull against.</param>
+	/// <param name="volumes">Volumes to be culled.</param>
+	/// <param name="visibility">Bitset with 32 volumes per element, resized to fit all the volumes.</param>
+	void CullVolumes(const math::Frustum& frustum, const CullingVolumes& volumes, std::vector<unsigned int>& visibility);
+
+	/// <summary>
+	/// Same as CullVolumes, but only tests the volumes in [begin, end) and
+	/// only writes to the elements of visibility that hold their bits. As
+	/// long as begin is a multiple of 32, different ranges can be culled on
+	/// different threads at the same time.
+	/// </summary>
+	/// <param name="begin">Index of the first volume, must be a multiple of 32.</param>
+	/// <param name="end">Index after the last volume, must be a multiple of 32 or the number of volumes.</param>
+	/// <param name="visibility">Bitset with 32 volumes per element, must already fit all the volumes.</param>
+	void CullVolumes(const math::Frustum& frustum, const CullingVolumes& volumes, size_t begin, size_t end, std::vector<unsigned int>& visibility);
+
+	/// <summary>
+	/// Scalar version of CullVolumes, tests one volume at a time.
+	/// </summary>
+	void CullVolumesScalar(const math::Frustum& frustum, const CullingVolumes& volumes, std::vector<unsigned int>& visibility);
+
+	/// <returns>True if bit index of visibility is set.</returns>
+	inline bool IsVisible(const std::vector<unsigned int>& visibility, size_t index)
+	{
+		return (visibility[index / 32] & (1u << (index % 32))) != 0;
+	}
+}
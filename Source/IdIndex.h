@@ -0,0 +1,231 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#define ID_INDEX_MINIMUM_CAPACITY 16
+
+/// <summary>
+/// Open addressing hash index that maps unique runtime ids (e.g Entity::Id,
+/// Component::Id) to pointers. Collisions are resolved with linear probing,
+/// removed slots are marked instead of emptied so that probing sequences are
+/// not broken, and capacity is kept as a power of two so that slots can be
+/// found with a mask instead of a modulo.
+/// </summary>
+template<typename VALUE> class IdIndex
+{
+private:
+	enum class slot_state : unsigned char
+	{
+		EMPTY,
+		OCCUPIED,
+		REMOVED
+	};
+
+	struct Slot
+	{
+		unsigned int id;
+		VALUE* value;
+		slot_state state;
+	};
+
+	std::vector<Slot> slots;
+	size_t count;
+	size_t removed_count;
+
+public:
+	IdIndex();
+
+	/// <summary>
+	/// Maps id to value, if id is already in the index, its value is replaced.
+	/// </summary>
+	void Insert(unsigned int id, VALUE* value);
+
+	/// <summary>
+	/// Removes id from the index if it exists.
+	/// </summary>
+	void Remove(unsigned int id);
+
+	/// <returns>
+	/// Value mapped to id, nullptr if id is not in the index.
+	/// </returns>
+	VALUE* Find(unsigned int id) const;
+
+	/// <returns>
+	/// Number of ids in the index.
+	/// </returns>
+	size_t Size() const;
+
+	void Clear();
+
+private:
+	static size_t Hash(unsigned int id);
+	size_t FindSlot(unsigned int id) const;
+	void Rehash(size_t new_capacity);
+};
+
+template<typename VALUE>
+inline IdIndex<VALUE>::IdIndex() :
+	count(0),
+	removed_count(0)
+{
+}
+
+template<typename VALUE>
+inline void IdIndex<VALUE>::Insert(unsigned int id, VALUE* value)
+{
+	// Keep the load factor including removed slots below 0.7,
+	// otherwise probe sequences get too long:
+	if ((count + removed_count + 1) * 10 > slots.size() * 7)
+	{
+		size_t new_capacity = slots.size() < ID_INDEX_MINIMUM_CAPACITY ? ID_INDEX_MINIMUM_CAPACITY : slots.size();
+
+		// If most of the load is removed slots, rehashing with
+		// the same capacity will suffice:
+		while ((count + 1) * 2 > new_capacity)
+		{
+			new_capacity *= 2;
+		}
+
+		Rehash(new_capacity);
+	}
+
+	const size_t mask = slots.size() - 1;
+	size_t first_removed_slot = slots.size();
+
+	for (size_t i = Hash(id) & mask; ; i = (i + 1) & mask)
+	{
+		Slot& slot = slots[i];
+
+		if (slot.state == slot_state::OCCUPIED && slot.id == id)
+		{
+			slot.value = value;
+
+			return;
+		}
+
+		if (slot.state == slot_state::REMOVED && first_removed_slot == slots.size())
+		{
+			first_removed_slot = i;
+		}
+
+		if (slot.state == slot_state::EMPTY)
+		{
+			// Reuse the first removed slot on the probe sequence if there is one:
+			if (first_removed_slot != slots.size())
+			{
+				i = first_removed_slot;
+				--removed_count;
+			}
+
+			slots[i].id = id;
+			slots[i].value = value;
+			slots[i].state = slot_state::OCCUPIED;
+
+			++count;
+
+			return;
+		}
+	}
+}
+
+template<typename VALUE>
+inline void IdIndex<VALUE>::Remove(unsigned int id)
+{
+	const size_t slot_index = FindSlot(id);
+
+	if (slot_index == slots.size())
+	{
+		return;
+	}
+
+	slots[slot_index].state = slot_state::REMOVED;
+	slots[slot_index].value = nullptr;
+
+	--count;
+	++removed_count;
+}
+
+template<typename VALUE>
+inline VALUE* IdIndex<VALUE>::Find(unsigned int id) const
+{
+	const size_t slot_index = FindSlot(id);
+
+	return slot_index == slots.size() ? nullptr : slots[slot_index].value;
+}
+
+template<typename VALUE>
+inline size_t IdIndex<VALUE>::Size() const
+{
+	return count;
+}
+
+template<typename VALUE>
+inline void IdIndex<VALUE>::Clear()
+{
+	slots.clear();
+	count = 0;
+	removed_count = 0;
+}
+
+template<typename VALUE>
+inline size_t IdIndex<VALUE>::Hash(unsigned int id)
+{
+	// NOTE: Ids are given sequentially, mix the bits so that
+	// consecutive ids don't form long clusters:
+	id ^= id >> 16;
+	id *= 0x45d9f3bu;
+	id ^= id >> 16;
+
+	return (size_t)id;
+}
+
+template<typename VALUE>
+inline size_t IdIndex<VALUE>::FindSlot(unsigned int id) const
+{
+	if (count == 0)
+	{
+		return slots.size();
+	}
+
+	const size_t mask = slots.size() - 1;
+
+	for (size_t i = Hash(id) & mask; ; i = (i + 1) & mask)
+	{
+		const Slot& slot = slots[i];
+
+		if (slot.state == slot_state::EMPTY)
+		{
+			return slots.size();
+		}
+
+		if (slot.state == slot_state::OCCUPIED && slot.id == id)
+		{
+			return i;
+		}
+	}
+}
+
+template<typename VALUE>
+inline void IdIndex<VALUE>::Rehash(size_t new_capacity)
+{
+	std::vector<Slot> old_slots;
+	old_slots.swap(slots);
+
+	Slot empty_slot;
+	empty_slot.id = 0;
+	empty_slot.value = nullptr;
+	empty_slot.state = slot_state::EMPTY;
+
+	slots.assign(new_capacity, empty_slot);
+	count = 0;
+	removed_count = 0;
+
+	for (const Slot& slot : old_slots)
+	{
+		if (slot.state == slot_state::OCCUPIED)
+		{
+			Insert(slot.id, slot.value);
+		}
+	}
+}
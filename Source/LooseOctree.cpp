@@ -0,0 +1,317 @@
+#include "LooseOctree.h"
+
+#include "Entity.h"
+#include "ComponentBoundingBox.h"
+
+namespace StrawMath
+{
+	LooseOctree::LooseOctree()
+	{
+
+	}
+
+	LooseOctree::~LooseOctree()
+	{
+		CleanUp();
+	}
+
+	void LooseOctree::SetContainer(const math::AABB& new_container)
+	{
+		CleanUp();
+
+		CreateNode(LOOSE_OCTREE_INVALID_HANDLE, new_container);
+	}
+
+	/// <summary>
+	/// Inserts entity to the deepest node that its bounding box fits in. If
+	/// it's already in the tree, this is the same as Update.
+	/// </summary>
+	/// <returns>False if the bounding box of entity does not fit in the root node.</returns>
+	bool LooseOctree::Insert(Entity* const entity)
+	{
+		if (nodes.empty())
+		{
+			return false;
+		}
+
+		if (Contains(entity))
+		{
+			return Update(entity);
+		}
+
+		math::AABB entity_aabb = entity->BoundingBox()->GetBoundingBox().MinimalEnclosingAABB();
+
+		if (!FitsInNode(entity_aabb, 0))
+		{
+			return false;
+		}
+
+		unsigned int node_handle = FindNode(entity_aabb);
+
+		LooseOctreeItem item;
+		item.bounding_box = entity_aabb;
+		item.entity = entity;
+
+		nodes[node_handle].items.push_back(item);
+		entity_nodes[entity] = node_handle;
+
+		ChangeSubtreeItemCount(node_handle, 1);
+
+		return true;
+	}
+
+	/// <summary>
+	/// Removes entity from the node that holds it, and frees the children
+	/// of the nodes that have no items left below them.
+	/// </summary>
+	void LooseOctree::Remove(Entity* const entity)
+	{
+		std::unordered_map<const Entity*, unsigned int>::iterator entity_node = entity_nodes.find(entity);
+
+		if (entity_node == entity_nodes.end())
+		{
+			return;
+		}
+
+		unsigned int node_handle = entity_node->second;
+		entity_nodes.erase(entity_node);
+
+		std::vector<LooseOctreeItem>& items = nodes[node_handle].items;
+
+		for (size_t i = 0; i < items.size(); ++i)
+		{
+			if (items[i].entity == entity)
+			{
+				items[i] = items.back();
+				items.pop_back();
+				break;
+			}
+		}
+
+		ChangeSubtreeItemCount(node_handle, -1);
+
+		// Children of a node are empty if all the items below
+		// it are in the node itself:
+		for (unsigned int current = node_handle; current != LOOSE_OCTREE_INVALID_HANDLE; current = nodes[current].parent)
+		{
+			const LooseOctreeNode& node = nodes[current];
+
+			if (!node.IsLeaf() && node.subtree_item_count == node.items.size())
+			{
+				FreeChildren(current);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Moves entity to the node that matches its current bounding box.
+	/// Inserts it if it's not in the tree.
+	/// </summary>
+	/// <returns>False if the bounding box of entity does not fit in the root node.</returns>
+	bool LooseOctree::Update(Entity* const entity)
+	{
+		std::unordered_map<const Entity*, unsigned int>::iterator entity_node = entity_nodes.find(entity);
+
+		if (entity_node == entity_nodes.end())
+		{
+			return Insert(entity);
+		}
+
+		unsigned int node_handle = entity_node->second;
+
+		math::AABB entity_aabb = entity->BoundingBox()->GetBoundingBox().MinimalEnclosingAABB();
+
+		// If it would be inserted to the same node, only update the
+		// bounding box of its item:
+		if (FitsInNode(entity_aabb, node_handle) && !FitsInChildOfNode(entity_aabb, node_handle))
+		{
+			for (LooseOctreeItem& item : nodes[node_handle].items)
+			{
+				if (item.entity == entity)
+				{
+					item.bounding_box = entity_aabb;
+					break;
+				}
+			}
+
+			return true;
+		}
+
+		Remove(entity);
+
+		return Insert(entity);
+	}
+
+	/// <returns>True if entity is inside this tree.</returns>
+	bool LooseOctree::Contains(const Entity* entity) const
+	{
+		return entity_nodes.find(entity) != entity_nodes.end();
+	}
+
+	/// <summary>
+	/// Removes all the nodes and entities. Memory of the node pool is kept
+	/// so that the tree can be rebuilt without allocating.
+	/// </summary>
+	void LooseOctree::CleanUp()
+	{
+		nodes.clear();
+		free_children.clear();
+		entity_nodes.clear();
+	}
+
+	unsigned int LooseOctree::CreateNode(unsigned int parent, const math::AABB& container)
+	{
+		nodes.emplace_back();
+
+		LooseOctreeNode& node = nodes.back();
+		node.container = container;
+		node.loose_container = math::AABB::FromCenterAndSize(container.CenterPoint(), container.Size() * 2.0f);
+		node.parent = parent;
+		node.first_child = LOOSE_OCTREE_INVALID_HANDLE;
+		node.depth = parent == LOOSE_OCTREE_INVALID_HANDLE ? 0 : nodes[parent].depth + 1;
+		node.subtree_item_count = 0;
+
+		return (unsigned int)nodes.size() - 1;
+	}
+
+	void LooseOctree::CreateChildren(unsigned int node_handle)
+	{
+		math::float3 center = nodes[node_handle].container.CenterPoint();
+		math::float3 quarter_size = nodes[node_handle].container.Size() * 0.25f;
+		math::float3 new_size = quarter_size * 2.0f;
+
+		// Bit 0 of the child index is set if the child is on the positive x
+		// side of the center, bit 1 for y and bit 2 for z, see FindNode:
+		math::AABB containers[8];
+		for (unsigned int i = 0; i < 8; ++i)
+		{
+			math::float3 new_center(
+				center.x + ((i & 1) ? quarter_size.x : -quarter_size.x),
+				center.y + ((i & 2) ? quarter_size.y : -quarter_size.y),
+				center.z + ((i & 4) ? quarter_size.z : -quarter_size.z)
+			);
+
+			containers[i] = math::AABB::FromCenterAndSize(new_center, new_size);
+		}
+
+		// Children are always created as 8 consecutive nodes, reuse a
+		// group freed before if there is any:
+		unsigned int first_child;
+
+		if (!free_children.empty())
+		{
+			first_child = free_children.back();
+			free_children.pop_back();
+
+			for (unsigned int i = 0; i < 8; ++i)
+			{
+				LooseOctreeNode& child = nodes[first_child + i];
+				child.container = containers[i];
+				child.loose_container = math::AABB::FromCenterAndSize(containers[i].CenterPoint(), new_size * 2.0f);
+				child.parent = node_handle;
+				child.first_child = LOOSE_OCTREE_INVALID_HANDLE;
+				child.depth = nodes[node_handle].depth + 1;
+				child.subtree_item_count = 0;
+				child.items.clear();
+			}
+		}
+		else
+		{
+			first_child = (unsigned int)nodes.size();
+
+			for (unsigned int i = 0; i < 8; ++i)
+			{
+				CreateNode(node_handle, containers[i]);
+			}
+		}
+
+		nodes[node_handle].first_child = first_child;
+	}
+
+	void LooseOctree::FreeChildren(unsigned int node_handle)
+	{
+		unsigned int first_child = nodes[node_handle].first_child;
+
+		if (first_child == LOOSE_OCTREE_INVALID_HANDLE)
+		{
+			return;
+		}
+
+		for (unsigned int i = 0; i < 8; ++i)
+		{
+			FreeChildren(first_child + i);
+		}
+
+		nodes[node_handle].first_child = LOOSE_OCTREE_INVALID_HANDLE;
+		free_children.push_back(first_child);
+	}
+
+	/// <returns>Handle of the deepest node bounding_box fits in, creating the nodes on the way.</returns>
+	unsigned int LooseOctree::FindNode(const math::AABB& bounding_box)
+	{
+		math::float3 center = bounding_box.CenterPoint();
+
+		unsigned int node_handle = 0;
+
+		while (FitsInChildOfNode(bounding_box, node_handle))
+		{
+			if (nodes[node_handle].IsLeaf())
+			{
+				CreateChildren(node_handle);
+			}
+
+			math::float3 node_center = nodes[node_handle].container.CenterPoint();
+
+			unsigned int child_index =
+				(center.x >= node_center.x ? 1 : 0) |
+				(center.y >= node_center.y ? 2 : 0) |
+				(center.z >= node_center.z ? 4 : 0);
+
+			node_handle = nodes[node_handle].first_child + child_index;
+		}
+
+		return node_handle;
+	}
+
+	/// <returns>True if center of bounding_box is inside the node, and it's not bigger than the node.</returns>
+	bool LooseOctree::FitsInNode(const math::AABB& bounding_box, unsigned int node_handle) const
+	{
+		const math::AABB& container = nodes[node_handle].container;
+
+		if (!container.Contains(bounding_box.CenterPoint()))
+		{
+			return false;
+		}
+
+		math::float3 half_size = bounding_box.HalfSize();
+		math::float3 container_half_size = container.HalfSize();
+
+		return half_size.x <= container_half_size.x &&
+			half_size.y <= container_half_size.y &&
+			half_size.z <= container_half_size.z;
+	}
+
+	/// <returns>True if bounding_box is small enough to fit in a child of the node.</returns>
+	bool LooseOctree::FitsInChildOfNode(const math::AABB& bounding_box, unsigned int node_handle) const
+	{
+		if (nodes[node_handle].depth + 1 > LOOSE_OCTREE_MAX_DEPTH)
+		{
+			return false;
+		}
+
+		math::float3 half_size = bounding_box.HalfSize();
+		math::float3 child_half_size = nodes[node_handle].container.HalfSize() * 0.5f;
+
+		return half_size.x <= child_half_size.x &&
+			half_size.y <= child_half_size.y &&
+			half_size.z <= child_half_size.z;
+	}
+
+	void LooseOctree::ChangeSubtreeItemCount(unsigned int node_handle, int amount)
+	{
+		for (unsigned int current = node_handle; current != LOOSE_OCTREE_INVALID_HANDLE; current = nodes[current].parent)
+		{
+			nodes[current].subtree_item_count += amount;
+		}
+	}
+}
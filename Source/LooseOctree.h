@@ -0,0 +1,279 @@
+#pragma once
+
+#include "MATH_GEO_LIB/Geometry/AABB.h"
+#include "MATH_GEO_LIB/Math/float3.h"
+
+#include "RayQueryBuffer.h"
+#include "BatchQueryBuffer.h"
+
+#include <vector>
+#include <unordered_map>
+
+#define LOOSE_OCTREE_MAX_DEPTH 8
+#define LOOSE_OCTREE_INVALID_HANDLE 0xFFFFFFFF
+
+class Entity;
+
+namespace StrawMath
+{
+	/// <summary>
+	/// An entity inside a LooseOctreeNode, along with the AABB that
+	/// encloses its OBB.
+	/// </summary>
+	struct LooseOctreeItem
+	{
+		math::AABB bounding_box;
+		Entity* entity;
+	};
+
+	/// <summary>
+	/// Node of a LooseOctree. Nodes live inside the node pool of the tree
+	/// and refer to each other with handles, which are indices into that pool.
+	/// </summary>
+	struct LooseOctreeNode
+	{
+		/// <summary>
+		/// Area this node covers, centers of the items are inside this.
+		/// </summary>
+		math::AABB container;
+
+		/// <summary>
+		/// container grown by its half size on each side, items are inside
+		/// this. Queries are tested against this.
+		/// </summary>
+		math::AABB loose_container;
+
+		/// <summary>
+		/// Handle of the parent node, LOOSE_OCTREE_INVALID_HANDLE for the root.
+		/// </summary>
+		unsigned int parent;
+
+		/// <summary>
+		/// Handle of the first of the 8 consecutive children nodes,
+		/// LOOSE_OCTREE_INVALID_HANDLE if this is a leaf.
+		/// </summary>
+		unsigned int first_child;
+
+		/// <summary>
+		/// Number of ancestors of this node.
+		/// </summary>
+		unsigned int depth;
+
+		/// <summary>
+		/// Number of items in this node and its descendants, so that
+		/// queries can skip the empty branches.
+		/// </summary>
+		unsigned int subtree_item_count;
+
+		/// <summary>
+		/// Items of this node. Each entity is in exactly one node.
+		/// </summary>
+		std::vector<LooseOctreeItem> items;
+
+		bool IsLeaf() const { return first_child == LOOSE_OCTREE_INVALID_HANDLE; }
+	};
+
+	/// <summary>
+	/// Octree where each node accepts items whose centers are inside its
+	/// container and whose sizes are at most the size of the container.
+	/// This way every entity is in exactly one node, picked only by its size
+	/// and center, so remove and update don't need to split or search.
+	/// </summary>
+	class LooseOctree
+	{
+	private:
+		std::vector<LooseOctreeNode> nodes;
+		std::vector<unsigned int> free_children;
+		std::unordered_map<const Entity*, unsigned int> entity_nodes;
+
+	public:
+		LooseOctree();
+		~LooseOctree();
+
+		void SetContainer(const math::AABB& new_container);
+		bool Insert(Entity* const entity);
+		void Remove(Entity* const entity);
+		bool Update(Entity* const entity);
+		bool Contains(const Entity* entity) const;
+		void CleanUp();
+
+		template<typename INTERSECTABLE_T>
+		void FillWithIntersections(std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const;
+		template<typename INTERSECTABLE_T, typename CANDIDATE_FUNCTION_T>
+		void RaycastNearestFirst(const INTERSECTABLE_T& intersectable, float max_distance, RayQueryBuffer& buffer, const CANDIDATE_FUNCTION_T& test_candidate) const;
+		template<typename INTERSECTABLE_T>
+		void FillWithBatchIntersections(const INTERSECTABLE_T* intersectables, size_t count, BatchQueryBuffer& buffer) const;
+
+	private:
+		template<typename INTERSECTABLE_T>
+		void FillWithIntersections(unsigned int node_handle, std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const;
+		template<typename INTERSECTABLE_T>
+		void FillWithBatchIntersections(unsigned int node_handle, const BatchQueryRange& parent_queries, const INTERSECTABLE_T* intersectables, BatchQueryBuffer& buffer) const;
+
+		unsigned int CreateNode(unsigned int parent, const math::AABB& container);
+		void CreateChildren(unsigned int node_handle);
+		void FreeChildren(unsigned int node_handle);
+		unsigned int FindNode(const math::AABB& bounding_box);
+		bool FitsInNode(const math::AABB& bounding_box, unsigned int node_handle) const;
+		bool FitsInChildOfNode(const math::AABB& bounding_box, unsigned int node_handle) const;
+		void ChangeSubtreeItemCount(unsigned int node_handle, int amount);
+	};
+
+	template<typename INTERSECTABLE_T>
+	inline void LooseOctree::FillWithIntersections(std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const
+	{
+		if (nodes.empty())
+		{
+			return;
+		}
+
+		FillWithIntersections(0, intersecting_entities, intersectable);
+	}
+
+	template<typename INTERSECTABLE_T>
+	inline void LooseOctree::FillWithIntersections(unsigned int node_handle, std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const
+	{
+		const LooseOctreeNode& node = nodes[node_handle];
+
+		// Skip empty branches and the ones that are not intersecting
+		// with intersectable:
+		if (node.subtree_item_count == 0 || !intersectable.Intersects(node.loose_container))
+		{
+			return;
+		}
+
+		for (const LooseOctreeItem& item : node.items)
+		{
+			if (intersectable.Intersects(item.bounding_box))
+			{
+				intersecting_entities.push_back(item.entity);
+			}
+		}
+
+		if (node.IsLeaf())
+		{
+			return;
+		}
+
+		for (unsigned int i = 0; i < 8; ++i)
+		{
+			FillWithIntersections(node.first_child + i, intersecting_entities, intersectable);
+		}
+	}
+
+	/// <summary>
+	/// See SpatialIndex::RaycastNearestFirst. Children are pushed by the
+	/// distance to their loose containers, and empty subtrees are skipped.
+	/// </summary>
+	template<typename INTERSECTABLE_T, typename CANDIDATE_FUNCTION_T>
+	inline void LooseOctree::RaycastNearestFirst(const INTERSECTABLE_T& intersectable, float max_distance, RayQueryBuffer& buffer, const CANDIDATE_FUNCTION_T& test_candidate) const
+	{
+		buffer.Clear();
+
+		float hit_near = 0.0f;
+		float hit_far = 0.0f;
+
+		if (nodes.empty() || nodes[0].subtree_item_count == 0 || !intersectable.Intersects(nodes[0].loose_container, hit_near, hit_far))
+		{
+			return;
+		}
+
+		buffer.PushNode(hit_near, 0);
+
+		while (!buffer.IsEmpty())
+		{
+			RayQueryEntry entry = buffer.PopNearest();
+
+			// Everything left starts after the closest hit:
+			if (entry.distance > max_distance)
+			{
+				break;
+			}
+
+			if (entry.entity != nullptr)
+			{
+				test_candidate(entry.entity, max_distance);
+				continue;
+			}
+
+			const LooseOctreeNode& node = nodes[entry.node_handle];
+
+			for (const LooseOctreeItem& item : node.items)
+			{
+				if (intersectable.Intersects(item.bounding_box, hit_near, hit_far) && hit_near <= max_distance)
+				{
+					buffer.PushEntity(hit_near, item.entity);
+				}
+			}
+
+			if (node.IsLeaf())
+			{
+				continue;
+			}
+
+			for (unsigned int i = 0; i < 8; ++i)
+			{
+				const LooseOctreeNode& child = nodes[node.first_child + i];
+
+				if (child.subtree_item_count == 0)
+				{
+					continue;
+				}
+
+				if (intersectable.Intersects(child.loose_container, hit_near, hit_far) && hit_near <= max_distance)
+				{
+					buffer.PushNode(hit_near, node.first_child + i);
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// See SpatialIndex::FillWithBatchIntersections. Queries are narrowed
+	/// down by the loose container of each node, and empty subtrees are
+	/// skipped.
+	/// </summary>
+	template<typename INTERSECTABLE_T>
+	inline void LooseOctree::FillWithBatchIntersections(const INTERSECTABLE_T* intersectables, size_t count, BatchQueryBuffer& buffer) const
+	{
+		const BatchQueryRange all_queries = buffer.ActivateAll(count);
+
+		if (nodes.empty() || count == 0)
+		{
+			return;
+		}
+
+		FillWithBatchIntersections(0, all_queries, intersectables, buffer);
+	}
+
+	template<typename INTERSECTABLE_T>
+	inline void LooseOctree::FillWithBatchIntersections(unsigned int node_handle, const BatchQueryRange& parent_queries, const INTERSECTABLE_T* intersectables, BatchQueryBuffer& buffer) const
+	{
+		const LooseOctreeNode& node = nodes[node_handle];
+
+		if (node.subtree_item_count == 0)
+		{
+			return;
+		}
+
+		const BatchQueryRange node_queries = buffer.ActivateIntersecting(parent_queries, intersectables, node.loose_container);
+
+		if (node_queries.count != 0)
+		{
+			for (const LooseOctreeItem& item : node.items)
+			{
+				buffer.AddHits(node_queries, intersectables, item.bounding_box, item.entity);
+			}
+
+			if (!node.IsLeaf())
+			{
+				for (unsigned int i = 0; i < 8; ++i)
+				{
+					FillWithBatchIntersections(node.first_child + i, node_queries, intersectables, buffer);
+				}
+			}
+		}
+
+		buffer.Deactivate(node_queries);
+	}
+}
@@ -3,11 +3,14 @@
 #include "ComponentBoundingBox.h"
 #include "ComponentMesh.h"
 #include "ComponentMaterial.h"
+#include "ResourceMesh.h"
+#include "ResourceMeshCache.h"
 #include "ASSIMP/scene.h"
 #include "Globals.h"							// For LOG
 #include "Util.h"								// For String functions
 #include "Application.h"						// For Access to App
 #include "ModuleTexture.h"						// For Access to Texture::Load and Texture::Unload
+#include "ModuleSceneManager.h"					// For Access to the ResourceMeshCache
 #include "MATH_GEO_LIB/Geometry/Polyhedron.h"	// For OBB::ToPolyhedron
 #include "MATH_GEO_LIB/Geometry/Sphere.h"		// For OBB::ToMinimumEnclosingSphere
 #include "assimp/postprocess.h"					// For aiProcess_Triangulate, aiProcess_FlipUVs
@@ -19,9 +22,10 @@ namespace ModelImporter
 	namespace
 	{
 		/// <summary>
-		/// Loads texture in given file_path, if cannot load sucessfully, it unloads the default texture it loaded.
+		/// Acquires texture in given file_path from the texture cache, which only loads it if no other 
+		/// material uses it yet. The acquired texture is released by the ComponentMaterial it's given to.
 		/// </summary>
-		/// <param name="output_texture_id">Texture id loaded from file_path</param>
+		/// <param name="output_texture_id">Texture id loaded from file_path, 0 if loading was unsuccessful</param>
 		/// <param name="file_path">Path to the texture file.</param>
 		/// <returns>True if loading was successful, false if not.</returns>
 		bool ModelImporter_TryLoadingTextureFromFile(unsigned int& output_texture_id, const char* file_path)
@@ -29,7 +33,7 @@ namespace ModelImporter
 			output_texture_id = 0;
 			bool successful = false;
 
-			output_texture_id = App->texture->LoadTexture
+			output_texture_id = App->texture->AcquireTexture
 			(
 				file_path,
 				GL_NEAREST,
@@ -41,11 +45,6 @@ namespace ModelImporter
 				successful
 			);
 
-			if (!successful)
-			{
-				App->texture->UnloadTexture(&output_texture_id);
-			}
-
 			return successful;
 		}
 
@@ -133,10 +132,9 @@ namespace ModelImporter
 		/// <summary>
 		/// Loads textures and creates an array of texture ids.
 		/// </summary>
-		/// <param name="scene">Model</param>
 		/// <param name="path_to_parent_directory">Path to model directory</param>
 		/// <returns>Array of texture ids.</returns>
-		unsigned int* ModelImporter_LoadTextureIds(const aiScene* scene, const char* path_to_parent_directory, const char* file_name)
+		unsigned int* ModelImporter_LoadTextureIds(const char* path_to_parent_directory, const char* file_name)
 		{
 			//size_t number_of_textures = scene->mNumMaterials; // For now we assume we have one texture for each material.
 			//TODO: How are we supposed to know how many texture materials has the fbx if it's broken
@@ -177,7 +175,12 @@ namespace ModelImporter
 			return texture_ids;
 		}
 
-		ComponentMesh* ModelImporter_LoadComponentMeshFromMeshData(aiMesh* mesh_data, Entity* owner)
+		/// <summary>
+		/// Creates the resource of mesh_data, or finds a loaded resource with 
+		/// the same content, in the mesh cache.
+		/// </summary>
+		/// <param name="path_key">Key of the mesh in the cache, see ResourceMeshCache::MakePathKey.</param>
+		ResourceMesh* ModelImporter_LoadResourceMeshFromMeshData(aiMesh* mesh_data, const std::string& path_key)
 		{
 			size_t number_of_vertices = mesh_data->mNumVertices;
 			size_t number_of_triangles = mesh_data->mNumFaces;
@@ -226,29 +229,42 @@ namespace ModelImporter
 				indices[i * 3 + 2] = mesh_data->mFaces[i].mIndices[2];
 			}
 
-			// NOTE: This function passes dynamically allocated vertices and indices arrays to the created component_mesh.
-			// component_mesh is responsible for the deallocation of those resources.
+			// NOTE: This function passes dynamically allocated vertices and indices arrays to the mesh cache.
+			// The cache is responsible for the deallocation of those resources.
 			
-			ComponentMesh* component_mesh = new ComponentMesh();
-			component_mesh->Initialize(owner);
-			component_mesh->Load(vertices, indices, number_of_vertices, number_of_indices, number_of_triangles);
-
-			return component_mesh;
+			return App->scene_manager->GetMeshCache()->Create(
+				path_key, 
+				vertices, 
+				indices, 
+				number_of_vertices, 
+				number_of_indices, 
+				number_of_triangles
+			);
 		}
 		
 		/// <summary>
 		/// Loads meshes as entity with child entities having mesh components.
 		/// </summary>
-		/// <param name="scene">Model</param>
+		/// <param name="meshes">Resources of the meshes of the model</param>
+		/// <param name="mesh_names">Names of the meshes of the model, also used to find their textures</param>
 		/// <param name="scene_name">Name of model</param>
-		/// <param name="texture_ids">An array consisting of texture ids</param>
+		/// <param name="path_to_parent_directory">Path to model directory</param>
 		/// <returns>Entity with child entities having mesh components.</returns>
-		Entity* ModelImporter_LoadMeshesAsEntity(const aiScene* scene, const char* scene_name, const char* path_directory)
+		Entity* ModelImporter_LoadMeshesAsEntity(
+			const std::vector<ResourceMesh*>& meshes, 
+			const std::vector<std::string>& mesh_names, 
+			const char* scene_name, 
+			const char* path_to_parent_directory
+		)
 		{
 			Entity* model_entity = new Entity();
 			model_entity->Initialize(scene_name);
 
-			size_t number_of_meshes = scene->mNumMeshes;
+			// Build the model without notifying listeners for each node,
+			// single notification is made at EndBatchBuild:
+			model_entity->BeginBatchBuild();
+
+			size_t number_of_meshes = meshes.size();
 			//size_t number_of_textures = scene->mNumMaterials; // For now we assume we have one texture for each material.
 			size_t number_of_textures = 3; // For now we assume we have three texture for each material.
 
@@ -260,29 +276,24 @@ namespace ModelImporter
 
 			LOG("Loading model as entity named %s", scene_name);
 
-			aiMesh* current_mesh_data;
-
 			for (size_t i = 0; i < number_of_meshes; ++i)
 			{
-				current_mesh_data = scene->mMeshes[i];
-
-				// Get the parent directory path from full file path:
-				char* path_to_parent_directory = util::ConcatCStrings("", path_directory);
-				util::SubstrAfterCharFromEnd(&path_to_parent_directory, '\\');
+				const char* mesh_name = mesh_names[i].c_str();
 
 				// Get Texture IDs:
-				unsigned int* texture_ids = ModelImporter_LoadTextureIds(scene, path_to_parent_directory, current_mesh_data->mName.C_Str());
+				unsigned int* texture_ids = ModelImporter_LoadTextureIds(path_to_parent_directory, mesh_name);
 
 				Entity* current_node = new Entity();
-				current_node->Initialize((current_mesh_data->mName.C_Str()));
+				current_node->Initialize(mesh_name);
 				current_node->SetParent(model_entity);
 
 				ComponentMaterial* component_material = new ComponentMaterial();
 				component_material->Initialize(current_node);
 				component_material->Load(texture_ids, number_of_textures);
 
-				ComponentMesh* current_component_mesh = 
-					ModelImporter_LoadComponentMeshFromMeshData(current_mesh_data, current_node);
+				ComponentMesh* current_component_mesh = new ComponentMesh();
+				current_component_mesh->Initialize(current_node);
+				current_component_mesh->Load(meshes[i]);
 
 				// For logging purposes:
 				number_of_triangles += current_component_mesh->GetNumberOfTriangles();
@@ -290,10 +301,11 @@ namespace ModelImporter
 				number_of_vertices += current_component_mesh->GetNumberOfVertices();
 				++number_of_loaded_meshes;
 				
-				free(path_to_parent_directory);
 				free(texture_ids);
 			}
 
+			model_entity->EndBatchBuild();
+
 			LOG("Loaded model as entity named %s:\n\tNumber of child meshes: %zu\n\tNumber of triangles: %zu\n\tNumber of indices: %zu\n\tNumber of vertices: %zu",
 				scene_name,
 				number_of_loaded_meshes,
@@ -304,28 +316,78 @@ namespace ModelImporter
 
 			return model_entity;
 		}
+
+		/// <summary>
+		/// Reads the model file with Assimp and creates the resources of its
+		/// meshes in the mesh cache.
+		/// </summary>
+		/// <param name="path_to_file">File path of the model</param>
+		/// <param name="canonical_path">Canonical path of the model, the meshes are cached with</param>
+		/// <returns>False if the file could not be read.</returns>
+		bool ModelImporter_ReadMeshes(
+			const char* path_to_file, 
+			const char* canonical_path, 
+			std::vector<ResourceMesh*>& meshes, 
+			std::vector<std::string>& mesh_names
+		)
+		{
+			Assimp::Importer importer;
+			const aiScene* model = importer.ReadFile(path_to_file, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GlobalScale);
+
+			// aiProcess_Triangulate: If the model is not entirely consisting of triangles, transform all the
+			// primitive to triangles.
+			// aiProcess_FlipUVs: If texture image is reversed around the y-axis, flip it.
+			// Can use aiProcess_GenNormals as well in the future to create normal vectors for each vertex if 
+			// the loaded model has no vertex normal data.
+			// NOTE: For more flags check http://assimp.sourceforge.net/lib_html/postprocess_8h.html
+
+			if (!model)
+			{
+				LOG("Error Loading Model File \"%s\": %s", path_to_file, importer.GetErrorString());
+				return false;
+			}
+			else
+			{
+				LOG("Model file \"%s\" is loaded successfully.", path_to_file);
+			}
+
+			meshes.clear();
+			mesh_names.clear();
+
+			meshes.reserve(model->mNumMeshes);
+			mesh_names.reserve(model->mNumMeshes);
+
+			for (size_t i = 0; i < model->mNumMeshes; ++i)
+			{
+				aiMesh* mesh_data = model->mMeshes[i];
+
+				meshes.push_back(ModelImporter_LoadResourceMeshFromMeshData(mesh_data, ResourceMeshCache::MakePathKey(canonical_path, i)));
+				mesh_names.push_back(mesh_data->mName.C_Str());
+			}
+
+			App->scene_manager->GetMeshCache()->SetModelMeshNames(canonical_path, mesh_names);
+
+			return true;
+		}
 	}
 
 	Entity* Import(const char* path_to_file)
 	{
-		Assimp::Importer importer;
-		const aiScene* model = importer.ReadFile(path_to_file, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GlobalScale);
+		char* canonical_path = util::GetCanonicalPath(path_to_file);
 
-		// aiProcess_Triangulate: If the model is not entirely consisting of triangles, transform all the
-		// primitive to triangles.
-		// aiProcess_FlipUVs: If texture image is reversed around the y-axis, flip it.
-		// Can use aiProcess_GenNormals as well in the future to create normal vectors for each vertex if 
-		// the loaded model has no vertex normal data.
-		// NOTE: For more flags check http://assimp.sourceforge.net/lib_html/postprocess_8h.html
+		std::vector<ResourceMesh*> meshes;
+		std::vector<std::string> mesh_names;
 
-		if (!model)
+		// If every mesh of the model is still loaded, the file is not read 
+		// again and the new entity shares their buffers:
+		if (App->scene_manager->GetMeshCache()->FindModel(canonical_path, meshes, mesh_names))
 		{
-			LOG("Error Loading Model File \"%s\": %s", path_to_file, importer.GetErrorString());
-			return nullptr;
+			LOG("Model file \"%s\" is already loaded, reusing its meshes.", path_to_file);
 		}
-		else
+		else if (!ModelImporter_ReadMeshes(path_to_file, canonical_path, meshes, mesh_names))
 		{
-			LOG("Model file \"%s\" is loaded successfully.", path_to_file);
+			free(canonical_path);
+			return nullptr;
 		}
 
 		// Get the parent directory path from full file path:
@@ -336,7 +398,8 @@ namespace ModelImporter
 		util::SubstrBeforeCharFromEnd(&model_name, '\\');
 
 		Entity* loaded_model = ModelImporter_LoadMeshesAsEntity(
-			model,
+			meshes,
+			mesh_names,
 			model_name,
 			path_to_parent_directory
 		);
@@ -344,6 +407,7 @@ namespace ModelImporter
 		// Deallocate resources:
 		free(model_name);
 		free(path_to_parent_directory);
+		free(canonical_path);
 
 		return loaded_model;
 	}
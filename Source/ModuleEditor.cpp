@@ -272,6 +272,49 @@ void ModuleEditor::DrawPerformanceWindow()
 	ImGui::Text("Hardware");
 	App->renderer->OnPerformanceWindow();
 
+	Scene* current_scene = App->scene_manager->GetCurrentScene();
+
+	if (current_scene != nullptr)
+	{
+		const RenderQueueStats& render_stats = current_scene->GetRenderQueue().GetStats();
+
+		ImGui::Text("\n");
+		ImGui::Text("Render Queue");
+		ImGui::Text("Packets: %u", render_stats.packet_count);
+		ImGui::Text("Draw calls: %u", render_stats.draw_calls);
+		ImGui::Text("State changes: %u", render_stats.StateChanges());
+		ImGui::Text("Program changes: %u", render_stats.program_changes);
+		ImGui::Text("Material changes: %u", render_stats.material_changes);
+		ImGui::Text("Texture binds: %u", render_stats.texture_binds);
+		ImGui::Text("Vertex array binds: %u", render_stats.vertex_array_binds);
+		ImGui::Text("Instance attribute binds: %u", render_stats.instance_attribute_binds);
+
+		ImGui::Text("\n");
+		ImGui::Text("Spatial Index");
+
+		const spatial_index_type current_spatial_index_type = current_scene->GetSpatialIndexType();
+
+		if (ImGui::BeginCombo("##spatial_index_type", spatial_index_type_to_string(current_spatial_index_type)))
+		{
+			const spatial_index_type spatial_index_types[] =
+			{
+				spatial_index_type::QUADTREE,
+				spatial_index_type::LOOSE_OCTREE,
+				spatial_index_type::AABB_TREE,
+			};
+
+			for (spatial_index_type type : spatial_index_types)
+			{
+				if (ImGui::Selectable(spatial_index_type_to_string(type), type == current_spatial_index_type))
+				{
+					current_scene->SetSpatialIndexType(type);
+				}
+			}
+
+			ImGui::EndCombo();
+		}
+	}
+
 	ImGui::End();
 }
 
@@ -350,6 +393,14 @@ void ModuleEditor::DrawInspector()
 			selected_entity->SetActive(is_entity_active);
 		}
 
+		ImGui::SameLine();
+
+		bool is_entity_static = selected_entity->IsStatic();
+		if (ImGui::Checkbox("Static", &is_entity_static))
+		{
+			selected_entity->SetStatic(is_entity_static);
+		}
+
 		for (Component* component : selected_entity->Components())
 		{
 			component->DrawInspector();
@@ -5,6 +5,8 @@
 
 #include "Scene.h"
 #include "Entity.h"
+#include "TransformStore.h"
+#include "ResourceMeshCache.h"
 #include "ComponentCamera.h"
 
 #include "Util.h"
@@ -16,10 +18,17 @@ ModuleSceneManager::ModuleSceneManager() :
 	current_scene(nullptr),
 	renamed_entity_in_hierarchy(nullptr)
 {
+	// NOTE(Baran): TransformStore is created here instead of Init, 
+	// since entities of other modules (e.g ModuleCamera) may be created
+	// before this module is initialized.
+	transform_store = new TransformStore();
+	mesh_cache = new ResourceMeshCache();
 }
 
 ModuleSceneManager::~ModuleSceneManager()
 {
+	delete mesh_cache;
+	delete transform_store;
 }
 
 bool ModuleSceneManager::Init()
@@ -61,6 +70,10 @@ bool ModuleSceneManager::CleanUp()
 	// Be careful with that.
 	delete current_scene;
 
+	// Meshes of the scene have released their resources, this destroys
+	// the ones left while the OpenGL context is still alive:
+	mesh_cache->CleanUp();
+
 	// TODO(baran): Move this into a private method.
 	// Unsubscribe from file dropped event if it's 
 	// not null:
@@ -75,6 +88,9 @@ bool ModuleSceneManager::CleanUp()
 
 update_status ModuleSceneManager::PreUpdate()
 {
+	// Recalculate world matrices changed since last frame in one pass:
+	transform_store->UpdateWorldMatrices();
+
 	current_scene->PreUpdate();
 
 	return update_status::UPDATE_CONTINUE;
@@ -116,6 +132,16 @@ Scene* const ModuleSceneManager::GetCurrentScene() const
 	return current_scene;
 }
 
+TransformStore* const ModuleSceneManager::GetTransformStore() const
+{
+	return transform_store;
+}
+
+ResourceMeshCache* const ModuleSceneManager::GetMeshCache() const
+{
+	return mesh_cache;
+}
+
 void ModuleSceneManager::DrawRecursiveEntityHierarchy(Entity* entity, bool is_root_entity, bool is_parent_inactive)
 {
 	// TODO(Baran): Refactor this code as it looks ugly a.f, and make 
@@ -222,15 +248,14 @@ void ModuleSceneManager::DrawRecursiveEntityHierarchy(Entity* entity, bool is_ro
 			// to the received id should not be the same with target's id:
 			if (drag_dropped_entity_id != nullptr && *drag_dropped_entity_id != entity->Id())	
 			{
-				// Find the entity in the scene as all the entities are descendants of the root node of
-				// the scene:
-				Entity* dropped_entity = current_scene->GetRootEntity()->FindDescendant(*drag_dropped_entity_id);
+				// Find the entity from the id index of the scene:
+				Entity* dropped_entity = current_scene->FindEntity(*drag_dropped_entity_id);
 				
 				// Avoid dragged entity to be dropped on an entity that is 
 				// an ancestor of it:
 				const bool is_dropped_entity_not_an_ancestor = 
 					dropped_entity != nullptr &&
-					!dropped_entity->HasDescendant(entity->Id());
+					!entity->IsDescendantOf(dropped_entity);
 				// Set the new_dropped_child_entity to this dropped_entity, 
 				// this will be used at the end of the function, that is not
 				// a recursive area, and gets added as a child to entity:
@@ -5,6 +5,8 @@
 
 class Scene;
 class Entity;
+class TransformStore;
+class ResourceMeshCache;
 
 class ModuleSceneManager : public Module
 {
@@ -13,6 +15,10 @@ private:
 						  // we may add an additional vector that holds all the scenes
 						  // in the game, and add a load scene functionality as well.
 	Entity* renamed_entity_in_hierarchy;
+	TransformStore* transform_store; // Holds transform data of every entity, 
+									 // shared by all scenes and ModuleCamera.
+	ResourceMeshCache* mesh_cache; // Holds the geometry shared by the meshes
+								   // of all scenes.
 	EventListener<const char*> file_dropped_event_listener;
 
 public:
@@ -29,6 +35,8 @@ public:
 	void DrawHierarchyEditor();
 
 	Scene* const GetCurrentScene() const;
+	TransformStore* const GetTransformStore() const;
+	ResourceMeshCache* const GetMeshCache() const;
 
 private:
 	void DrawRecursiveEntityHierarchy(Entity* entity, bool is_root_entity, bool is_parent_inactive);
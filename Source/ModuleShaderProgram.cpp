@@ -7,7 +7,12 @@
 constexpr const char* VERTEX_SHADER_PATH = "\\Shaders\\vertex.glsl";
 constexpr const char* FRAGMENT_SHADER_PATH = "\\Shaders\\fragment.glsl";
 
-ModuleShaderProgram::ModuleShaderProgram()
+ModuleShaderProgram::ModuleShaderProgram() : 
+    program_id(0),
+    per_frame_block(),
+    light_block(),
+    per_frame_buffer(0),
+    light_buffer(0)
 {
 }
 
@@ -44,6 +49,15 @@ bool ModuleShaderProgram::Init()
     // Link shaders and create program:
     program_id = CreateProgram(vertex_shader_id, fragment_shader_id);
 
+    // Find the locations of the uniforms once, instead of asking the
+    // driver for them by name every time they are set:
+    ReflectUniforms();
+    ResolveUniforms();
+
+    // Camera and light values are shared by all draws, they go through
+    // uniform blocks that are uploaded once per frame:
+    CreateUniformBlocks();
+
     // Use the created program:
     glUseProgram(program_id);
 
@@ -59,6 +73,15 @@ bool ModuleShaderProgram::CleanUp()
     // Delete shader program:
     glDeleteProgram(program_id);
 
+    uniform_locations.clear();
+    uniforms = ShaderUniforms();
+
+    glDeleteBuffers(1, &per_frame_buffer);
+    glDeleteBuffers(1, &light_buffer);
+
+    per_frame_buffer = 0;
+    light_buffer = 0;
+
     return true;
 }
 
@@ -150,29 +173,207 @@ void ModuleShaderProgram::Use() const
     glUseProgram(program_id);
 }
 
+const ShaderUniforms& ModuleShaderProgram::GetUniforms() const
+{
+    return uniforms;
+}
+
+PerFrameUniformBlock& ModuleShaderProgram::GetPerFrameBlock()
+{
+    return per_frame_block;
+}
+
+LightUniformBlock& ModuleShaderProgram::GetLightBlock()
+{
+    return light_block;
+}
+
+/// <summary>
+/// Uploads the mirrors of the uniform blocks, one glBufferSubData each.
+/// Called once per frame before the meshes are drawn.
+/// </summary>
+void ModuleShaderProgram::UploadUniformBlocks()
+{
+    per_frame_block.time = Time->TotalTime();
+
+    glBindBuffer(GL_UNIFORM_BUFFER, per_frame_buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(PerFrameUniformBlock), &per_frame_block);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, light_buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightUniformBlock), &light_block);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/// <returns>
+/// Location of the active uniform with name, found in the table filled 
+/// after linking. SHADER_PROGRAM_INVALID_UNIFORM_LOCATION if there is none.
+/// </returns>
+int ModuleShaderProgram::GetUniformLocation(const char* name) const
+{
+    std::unordered_map<std::string, int>::const_iterator found = uniform_locations.find(name);
+
+    return found != uniform_locations.end() ? found->second : SHADER_PROGRAM_INVALID_UNIFORM_LOCATION;
+}
+
+void ModuleShaderProgram::SetUniform(const UniformHandle<int>& handle, int value) const
+{
+    glUniform1i(handle.location, value);
+}
+
+void ModuleShaderProgram::SetUniform(const UniformHandle<float>& handle, float value) const
+{
+    glUniform1f(handle.location, value);
+}
+
+void ModuleShaderProgram::SetUniform(const UniformHandle<float3>& handle, const float3& value) const
+{
+    glUniform3fv(handle.location, 1, value.ptr());
+}
+
+void ModuleShaderProgram::SetUniform(const UniformHandle<float4>& handle, const float4& value) const
+{
+    glUniform4fv(handle.location, 1, value.ptr());
+}
+
+void ModuleShaderProgram::SetUniform(const UniformHandle<float3x3>& handle, const float3x3& value, const bool transpose) const
+{
+    glUniformMatrix3fv(handle.location, 1, transpose ? GL_TRUE : GL_FALSE, value.ptr());
+}
+
+void ModuleShaderProgram::SetUniform(const UniformHandle<float4x4>& handle, const float4x4& value, const bool transpose) const
+{
+    glUniformMatrix4fv(handle.location, 1, transpose ? GL_TRUE : GL_FALSE, value.ptr());
+}
+
 void ModuleShaderProgram::SetUniformVariable(const char* name, int value) const
 {
-    glUniform1i(glGetUniformLocation(program_id, name), value);
+    glUniform1i(GetUniformLocation(name), value);
 }
 
 void ModuleShaderProgram::SetUniformVariable(const char* name, float value) const
 {
-    glUniform1f(glGetUniformLocation(program_id, name), value);
+    glUniform1f(GetUniformLocation(name), value);
 }
 
 void ModuleShaderProgram::SetUniformVariable(const char* name, const float3& value) const
 {
-    glUniform3fv(glGetUniformLocation(program_id, name), 1, value.ptr());
+    glUniform3fv(GetUniformLocation(name), 1, value.ptr());
 }
 
 void ModuleShaderProgram::SetUniformVariable(const char* name, const float4& value) const
 {
-    glUniform3fv(glGetUniformLocation(program_id, name), 1, value.ptr());
+    glUniform4fv(GetUniformLocation(name), 1, value.ptr());
+}
+
+void ModuleShaderProgram::SetUniformVariable(const char* name, const float3x3& value, const bool transpose) const
+{
+    glUniformMatrix3fv(GetUniformLocation(name), 1, transpose ? GL_TRUE : GL_FALSE, value.ptr());
 }
 
 void ModuleShaderProgram::SetUniformVariable(const char* name, const float4x4& value, const bool transpose) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(program_id, name), 1, transpose ? GL_TRUE : GL_FALSE, value.ptr());
+    glUniformMatrix4fv(GetUniformLocation(name), 1, transpose ? GL_TRUE : GL_FALSE, value.ptr());
+}
+
+/// <summary>
+/// Fills uniform_locations with every active uniform of the program. 
+/// Arrays are reported as "name[0]", they are also added as "name".
+/// </summary>
+void ModuleShaderProgram::ReflectUniforms()
+{
+    uniform_locations.clear();
+
+    int uniform_count = 0;
+    int max_name_length = 0;
+
+    glGetProgramiv(program_id, GL_ACTIVE_UNIFORMS, &uniform_count);
+    glGetProgramiv(program_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+    if (uniform_count <= 0 || max_name_length <= 0)
+    {
+        return;
+    }
+
+    char* name = (char*) malloc(max_name_length);
+
+    for (int i = 0; i < uniform_count; ++i)
+    {
+        int name_length = 0;
+        int size = 0;
+        GLenum type = 0;
+
+        glGetActiveUniform(program_id, (GLuint)i, max_name_length, &name_length, &size, &type, name);
+
+        // Index of the active uniform is not its location, so it's 
+        // queried once here:
+        const int location = glGetUniformLocation(program_id, name);
+
+        if (location == SHADER_PROGRAM_INVALID_UNIFORM_LOCATION)
+        {
+            continue;
+        }
+
+        std::string uniform_name(name, name_length);
+
+        uniform_locations[uniform_name] = location;
+
+        const size_t array_suffix = uniform_name.rfind("[0]");
+
+        if (array_suffix != std::string::npos && array_suffix + 3 == uniform_name.size())
+        {
+            uniform_locations[uniform_name.substr(0, array_suffix)] = location;
+        }
+    }
+
+    free(name);
+}
+
+/// <summary>
+/// Resolves the handles in uniforms from uniform_locations.
+/// </summary>
+void ModuleShaderProgram::ResolveUniforms()
+{
+    uniforms.material_diffuse = GetUniformHandle<int>("material.diffuse");
+    uniforms.material_specular = GetUniformHandle<int>("material.specular");
+    uniforms.material_occlusion = GetUniformHandle<int>("material.occlusion");
+    uniforms.material_shininess = GetUniformHandle<float>("material.shininess");
+}
+
+/// <summary>
+/// Creates the uniform buffer objects of the blocks, binds them to their
+/// binding points and points the blocks of the program at them.
+/// </summary>
+void ModuleShaderProgram::CreateUniformBlocks()
+{
+    glGenBuffers(1, &per_frame_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, per_frame_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(PerFrameUniformBlock), &per_frame_block, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BLOCK_PER_FRAME_BINDING, per_frame_buffer);
+
+    glGenBuffers(1, &light_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, light_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightUniformBlock), &light_block, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BLOCK_LIGHTS_BINDING, light_buffer);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    BindUniformBlock(UNIFORM_BLOCK_PER_FRAME_NAME, UNIFORM_BLOCK_PER_FRAME_BINDING);
+    BindUniformBlock(UNIFORM_BLOCK_LIGHTS_NAME, UNIFORM_BLOCK_LIGHTS_BINDING);
+}
+
+void ModuleShaderProgram::BindUniformBlock(const char* name, unsigned int binding) const
+{
+    const GLuint block_index = glGetUniformBlockIndex(program_id, name);
+
+    if (block_index == GL_INVALID_INDEX)
+    {
+        LOG("Shader program has no uniform block named %s", name);
+
+        return;
+    }
+
+    glUniformBlockBinding(program_id, block_index, binding);
 }
 
 ModuleShaderProgram::~ModuleShaderProgram()
@@ -2,7 +2,13 @@
 #include "Module.h"
 #include "MATH_GEO_LIB/Math/float3.h"
 #include "MATH_GEO_LIB/Math/float4.h"
+#include "MATH_GEO_LIB/Math/float3x3.h"
 #include "MATH_GEO_LIB/Math/float4x4.h"
+#include "ShaderUniforms.h"
+#include "UniformBlocks.h"
+
+#include <string>
+#include <unordered_map>
 
 class Application;
 
@@ -21,13 +27,75 @@ class ModuleShaderProgram : public Module
 
 	void Use() const;
 
+	const ShaderUniforms& GetUniforms() const;
+	PerFrameUniformBlock& GetPerFrameBlock();
+	LightUniformBlock& GetLightBlock();
+	void UploadUniformBlocks();
+	int GetUniformLocation(const char* name) const;
+	template<typename VALUE_T>
+	UniformHandle<VALUE_T> GetUniformHandle(const char* name) const;
+
+	void SetUniform(const UniformHandle<int>& handle, int value) const;
+	void SetUniform(const UniformHandle<float>& handle, float value) const;
+	void SetUniform(const UniformHandle<float3>& handle, const float3& value) const;
+	void SetUniform(const UniformHandle<float4>& handle, const float4& value) const;
+	void SetUniform(const UniformHandle<float3x3>& handle, const float3x3& value, const bool transpose) const;
+	void SetUniform(const UniformHandle<float4x4>& handle, const float4x4& value, const bool transpose) const;
+
+	// NOTE: Setting uniforms by name looks the location up in 
+	// uniform_locations on every call, these are kept for the editor
+	// and for uniforms that are not in ShaderUniforms:
 	void SetUniformVariable(const char* name, int value) const;
 	void SetUniformVariable(const char* name, float value) const;
 	void SetUniformVariable(const char* name, const float3& value) const;
 	void SetUniformVariable(const char* name, const float4& value) const;
+	void SetUniformVariable(const char* name, const float3x3& value, const bool transpose) const;
 	void SetUniformVariable(const char* name, const float4x4& value, const bool transpose) const;
 
+    private:
+	void ReflectUniforms();
+	void ResolveUniforms();
+	void CreateUniformBlocks();
+	void BindUniformBlock(const char* name, unsigned int binding) const;
+
     private:
 	unsigned int program_id;
+
+	/// <summary>
+	/// Locations of all the active uniforms of the program, by name. 
+	/// Filled once after linking with glGetActiveUniform.
+	/// </summary>
+	std::unordered_map<std::string, int> uniform_locations;
+
+	/// <summary>
+	/// Handles of the uniforms the engine sets per draw.
+	/// </summary>
+	ShaderUniforms uniforms;
+
+	/// <summary>
+	/// CPU side mirrors of the uniform blocks, filled by the camera and
+	/// the lights during the frame and uploaded by UploadUniformBlocks.
+	/// </summary>
+	PerFrameUniformBlock per_frame_block;
+	LightUniformBlock light_block;
+
+	/// <summary>
+	/// Uniform buffer objects of the blocks.
+	/// </summary>
+	unsigned int per_frame_buffer;
+	unsigned int light_buffer;
 };
 
+/// <returns>
+/// Handle of the uniform with name, which is invalid if the program has 
+/// no active uniform with that name.
+/// </returns>
+template<typename VALUE_T>
+inline UniformHandle<VALUE_T> ModuleShaderProgram::GetUniformHandle(const char* name) const
+{
+	UniformHandle<VALUE_T> handle;
+	handle.location = GetUniformLocation(name);
+
+	return handle;
+}
+
@@ -31,6 +31,11 @@ bool ModuleTexture::Init()
 
 bool ModuleTexture::CleanUp()
 {
+    // Materials have released their textures when the scene was deleted,
+    // and the OpenGL context that owns any left is already destroyed:
+    texture_ids_by_path.clear();
+    cached_textures.clear();
+
     util::RemoveFile(runtime_texture_data_file_path);
 
     free(runtime_texture_data_file_path);
@@ -258,6 +263,101 @@ void ModuleTexture::UnloadTexture(GLuint* texture_ptr) const
     glDeleteTextures(1, texture_ptr);
 }
 
+/// <summary>
+/// Loads the texture in file_name once, and returns the same id to every
+/// later call with the same file until all of them release it. Files are
+/// told apart by their canonical paths, see util::GetCanonicalPath. Unlike
+/// LoadTexture, nothing is loaded if the file can not be loaded, so the 
+/// returned id is 0 in that case.
+/// </summary>
+/// <returns>Id of the texture, to be given to ReleaseTexture once it's not used.</returns>
+GLuint ModuleTexture::AcquireTexture(const char* file_name,
+                                     GLint min_filter,
+                                     GLint mag_filter,
+                                     GLint wrap_s,
+                                     GLint wrap_t,
+                                     bool is_rgba,
+                                     bool generate_mipmap,
+                                     bool& loading_successful)
+{
+    char* canonical_path = util::GetCanonicalPath(file_name);
+
+    std::unordered_map<std::string, GLuint>::iterator cached_texture_id = texture_ids_by_path.find(canonical_path);
+
+    if (cached_texture_id != texture_ids_by_path.end())
+    {
+        free(canonical_path);
+
+        ++cached_textures[cached_texture_id->second].reference_count;
+
+        loading_successful = true;
+
+        return cached_texture_id->second;
+    }
+
+    // Checking the file first saves decoding and uploading the error 
+    // texture only to unload it, which is most of the time spent on the
+    // paths the importers search textures in:
+    if (!util::FileExists(canonical_path))
+    {
+        free(canonical_path);
+
+        loading_successful = false;
+
+        return 0;
+    }
+
+    GLuint texture_id = LoadTexture(file_name, min_filter, mag_filter, wrap_s, wrap_t, is_rgba, generate_mipmap, loading_successful);
+
+    if (!loading_successful)
+    {
+        free(canonical_path);
+
+        UnloadTexture(&texture_id);
+
+        return 0;
+    }
+
+    CachedTexture& cached_texture = cached_textures[texture_id];
+    cached_texture.canonical_path = canonical_path;
+    cached_texture.reference_count = 1;
+
+    texture_ids_by_path[cached_texture.canonical_path] = texture_id;
+
+    free(canonical_path);
+
+    return texture_id;
+}
+
+/// <summary>
+/// Releases a texture given by AcquireTexture, and unloads it if this was
+/// the last reference to it. Ids that were not acquired are ignored.
+/// </summary>
+void ModuleTexture::ReleaseTexture(GLuint texture_id)
+{
+    std::unordered_map<GLuint, CachedTexture>::iterator cached_texture = cached_textures.find(texture_id);
+
+    if (cached_texture == cached_textures.end())
+    {
+        return;
+    }
+
+    if (--cached_texture->second.reference_count > 0)
+    {
+        return;
+    }
+
+    texture_ids_by_path.erase(cached_texture->second.canonical_path);
+    cached_textures.erase(cached_texture);
+
+    UnloadTexture(&texture_id);
+}
+
+size_t ModuleTexture::GetCachedTextureCount() const
+{
+    return cached_textures.size();
+}
+
 // User must deallocate buffer memory.
 void ModuleTexture::GetTextureInfo(GLuint texture_id, char** buffer) const
 {
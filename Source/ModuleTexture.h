@@ -2,11 +2,29 @@
 #include "Module.h"
 #include "GL/glew.h"
 
+#include <string>
+#include <unordered_map>
+
+/// <summary>
+/// Texture loaded through ModuleTexture::AcquireTexture, shared by 
+/// everything that acquired the same file.
+/// </summary>
+struct CachedTexture
+{
+	std::string canonical_path;
+	unsigned int reference_count;
+};
 
 class ModuleTexture : public Module
 {
 private:
 	char* runtime_texture_data_file_path;
+
+	// Ids of the acquired textures by the canonical paths of their files:
+	std::unordered_map<std::string, GLuint> texture_ids_by_path;
+	// Acquired textures by their ids:
+	std::unordered_map<GLuint, CachedTexture> cached_textures;
+
 public:
 	ModuleTexture();
 	~ModuleTexture() override;
@@ -41,6 +59,19 @@ public:
 
 	void UnloadTexture(GLuint* texture_ptr) const;
 
+	GLuint AcquireTexture(const char* file_name,
+						  GLint min_filter,
+						  GLint mag_filter,
+						  GLint wrap_s,
+						  GLint wrap_t,
+						  bool is_rgba,
+						  bool generate_mipmap,
+						  bool& loading_successful);
+
+	void ReleaseTexture(GLuint texture_id);
+
+	size_t GetCachedTextureCount() const;
+
 	void GetTextureInfo(GLuint texture_id, char** buffer) const;
 
 private:
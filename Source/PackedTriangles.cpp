@@ -0,0 +1,256 @@
+#include "PackedTriangles.h"
+
+#include "MATH_GEO_LIB/Math/MathFunc.h"
+#include "MATH_GEO_LIB/Math/float3.h"
+
+// SSE is part of the x64 baseline, so it doesn't depend on MathGeoLib
+// being built with MATH_SSE:
+#if defined(MATH_SSE) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define PACKED_TRIANGLES_SSE
+#include <xmmintrin.h>
+#endif
+
+// Same tolerance as math::Triangle::IntersectLineTri, so that the kernels
+// agree with MathGeoLib on which triangles are hit:
+#define PACKED_TRIANGLES_EPSILON 1e-4f
+
+namespace StrawMath
+{
+	void PackedTriangles::Add(const math::Triangle& triangle)
+	{
+		math::float3 edge_1 = triangle.b - triangle.a;
+		math::float3 edge_2 = triangle.c - triangle.a;
+
+		vertex_x.push_back(triangle.a.x);
+		vertex_y.push_back(triangle.a.y);
+		vertex_z.push_back(triangle.a.z);
+		edge_1_x.push_back(edge_1.x);
+		edge_1_y.push_back(edge_1.y);
+		edge_1_z.push_back(edge_1.z);
+		edge_2_x.push_back(edge_2.x);
+		edge_2_y.push_back(edge_2.y);
+		edge_2_z.push_back(edge_2.z);
+	}
+
+	/// <summary>
+	/// Adds degenerate triangles, which are never hit, until the size is a
+	/// multiple of PACKED_TRIANGLES_LANE_COUNT.
+	/// </summary>
+	void PackedTriangles::AddPadding()
+	{
+		while (Size() % PACKED_TRIANGLES_LANE_COUNT != 0)
+		{
+			Add(math::Triangle(math::float3::zero, math::float3::zero, math::float3::zero));
+		}
+	}
+
+	void PackedTriangles::Clear()
+	{
+		vertex_x.clear();
+		vertex_y.clear();
+		vertex_z.clear();
+		edge_1_x.clear();
+		edge_1_y.clear();
+		edge_1_z.clear();
+		edge_2_x.clear();
+		edge_2_y.clear();
+		edge_2_z.clear();
+	}
+
+	size_t PackedTriangles::Size() const
+	{
+		return vertex_x.size();
+	}
+
+	/// <summary>
+	/// Moller-Trumbore test of the line origin + t * direction against the
+	/// triangle at index, following math::Triangle::IntersectLineTri.
+	/// </summary>
+	/// <returns>True if the triangle is hit with t in [0, max_distance].</returns>
+	static inline bool IntersectPackedTriangle(const PackedTriangles& triangles, size_t index, const math::float3& origin, const math::float3& direction, float max_distance, float& distance, float& u, float& v)
+	{
+		math::float3 vertex(triangles.vertex_x[index], triangles.vertex_y[index], triangles.vertex_z[index]);
+		math::float3 edge_1(triangles.edge_1_x[index], triangles.edge_1_y[index], triangles.edge_1_z[index]);
+		math::float3 edge_2(triangles.edge_2_x[index], triangles.edge_2_y[index], triangles.edge_2_z[index]);
+
+		math::float3 p = direction.Cross(edge_2);
+
+		const float determinant = edge_1.Dot(p);
+
+		// Segment is parallel to the plane of the triangle:
+		if (math::Abs(determinant) <= PACKED_TRIANGLES_EPSILON)
+		{
+			return false;
+		}
+
+		const float inverse_determinant = 1.0f / determinant;
+
+		math::float3 t = origin - vertex;
+
+		u = t.Dot(p) * inverse_determinant;
+
+		if (u < -PACKED_TRIANGLES_EPSILON || u > 1.0f + PACKED_TRIANGLES_EPSILON)
+		{
+			return false;
+		}
+
+		math::float3 q = t.Cross(edge_1);
+
+		v = direction.Dot(q) * inverse_determinant;
+
+		if (v < -PACKED_TRIANGLES_EPSILON || u + v > 1.0f + PACKED_TRIANGLES_EPSILON)
+		{
+			return false;
+		}
+
+		distance = edge_2.Dot(q) * inverse_determinant;
+
+		return distance >= 0.0f && distance <= max_distance;
+	}
+
+	bool IntersectPackedTrianglesScalar(const PackedTriangles& triangles, size_t begin, size_t end, const math::LineSegment& segment, TriangleHit& hit)
+	{
+		const math::float3 origin = segment.a;
+		const math::float3 direction = segment.b - segment.a;
+
+		// Hits must be on the segment:
+		float best_distance = math::Min(hit.distance, 1.0f);
+		bool is_hit = false;
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			float distance;
+			float u;
+			float v;
+
+			if (IntersectPackedTriangle(triangles, i, origin, direction, best_distance, distance, u, v))
+			{
+				best_distance = distance;
+				is_hit = true;
+
+				hit.distance = distance;
+				hit.triangle_index = (unsigned int)i;
+				hit.u = u;
+				hit.v = v;
+			}
+		}
+
+		return is_hit;
+	}
+
+	bool IntersectPackedTriangles(const PackedTriangles& triangles, size_t begin, size_t end, const math::LineSegment& segment, TriangleHit& hit)
+	{
+#ifdef PACKED_TRIANGLES_SSE
+		const math::float3 segment_direction = segment.b - segment.a;
+
+		const __m128 origin_x = _mm_set1_ps(segment.a.x);
+		const __m128 origin_y = _mm_set1_ps(segment.a.y);
+		const __m128 origin_z = _mm_set1_ps(segment.a.z);
+		const __m128 direction_x = _mm_set1_ps(segment_direction.x);
+		const __m128 direction_y = _mm_set1_ps(segment_direction.y);
+		const __m128 direction_z = _mm_set1_ps(segment_direction.z);
+
+		const __m128 epsilon = _mm_set1_ps(PACKED_TRIANGLES_EPSILON);
+		const __m128 negative_epsilon = _mm_set1_ps(-PACKED_TRIANGLES_EPSILON);
+		const __m128 one_plus_epsilon = _mm_set1_ps(1.0f + PACKED_TRIANGLES_EPSILON);
+		const __m128 sign_mask = _mm_set1_ps(-0.0f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		// Hits must be on the segment:
+		float best_distance = math::Min(hit.distance, 1.0f);
+		bool is_hit = false;
+
+		const size_t simd_end = end - (end - begin) % 4;
+
+		for (size_t i = begin; i < simd_end; i += 4)
+		{
+			const __m128 edge_1_x = _mm_loadu_ps(&triangles.edge_1_x[i]);
+			const __m128 edge_1_y = _mm_loadu_ps(&triangles.edge_1_y[i]);
+			const __m128 edge_1_z = _mm_loadu_ps(&triangles.edge_1_z[i]);
+			const __m128 edge_2_x = _mm_loadu_ps(&triangles.edge_2_x[i]);
+			const __m128 edge_2_y = _mm_loadu_ps(&triangles.edge_2_y[i]);
+			const __m128 edge_2_z = _mm_loadu_ps(&triangles.edge_2_z[i]);
+
+			// p = direction x edge_2:
+			const __m128 p_x = _mm_sub_ps(_mm_mul_ps(direction_y, edge_2_z), _mm_mul_ps(direction_z, edge_2_y));
+			const __m128 p_y = _mm_sub_ps(_mm_mul_ps(direction_z, edge_2_x), _mm_mul_ps(direction_x, edge_2_z));
+			const __m128 p_z = _mm_sub_ps(_mm_mul_ps(direction_x, edge_2_y), _mm_mul_ps(direction_y, edge_2_x));
+
+			const __m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edge_1_x, p_x), _mm_mul_ps(edge_1_y, p_y)), _mm_mul_ps(edge_1_z, p_z));
+
+			__m128 mask = _mm_cmpgt_ps(_mm_andnot_ps(sign_mask, determinant), epsilon);
+
+			// Parallel to all 4 triangles, or all 4 are padding:
+			if (_mm_movemask_ps(mask) == 0)
+			{
+				continue;
+			}
+
+			const __m128 inverse_determinant = _mm_div_ps(one, determinant);
+
+			const __m128 t_x = _mm_sub_ps(origin_x, _mm_loadu_ps(&triangles.vertex_x[i]));
+			const __m128 t_y = _mm_sub_ps(origin_y, _mm_loadu_ps(&triangles.vertex_y[i]));
+			const __m128 t_z = _mm_sub_ps(origin_z, _mm_loadu_ps(&triangles.vertex_z[i]));
+
+			const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(t_x, p_x), _mm_mul_ps(t_y, p_y)), _mm_mul_ps(t_z, p_z)), inverse_determinant);
+
+			mask = _mm_and_ps(mask, _mm_cmpge_ps(u, negative_epsilon));
+			mask = _mm_and_ps(mask, _mm_cmple_ps(u, one_plus_epsilon));
+
+			// q = t x edge_1:
+			const __m128 q_x = _mm_sub_ps(_mm_mul_ps(t_y, edge_1_z), _mm_mul_ps(t_z, edge_1_y));
+			const __m128 q_y = _mm_sub_ps(_mm_mul_ps(t_z, edge_1_x), _mm_mul_ps(t_x, edge_1_z));
+			const __m128 q_z = _mm_sub_ps(_mm_mul_ps(t_x, edge_1_y), _mm_mul_ps(t_y, edge_1_x));
+
+			const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(direction_x, q_x), _mm_mul_ps(direction_y, q_y)), _mm_mul_ps(direction_z, q_z)), inverse_determinant);
+
+			mask = _mm_and_ps(mask, _mm_cmpge_ps(v, negative_epsilon));
+			mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one_plus_epsilon));
+
+			const __m128 distance = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(edge_2_x, q_x), _mm_mul_ps(edge_2_y, q_y)), _mm_mul_ps(edge_2_z, q_z)), inverse_determinant);
+
+			mask = _mm_and_ps(mask, _mm_cmpge_ps(distance, zero));
+			mask = _mm_and_ps(mask, _mm_cmple_ps(distance, _mm_set1_ps(best_distance)));
+
+			const int hit_lanes = _mm_movemask_ps(mask);
+
+			if (hit_lanes == 0)
+			{
+				continue;
+			}
+
+			float distances[4];
+			float us[4];
+			float vs[4];
+			_mm_storeu_ps(distances, distance);
+			_mm_storeu_ps(us, u);
+			_mm_storeu_ps(vs, v);
+
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				if ((hit_lanes & (1 << lane)) != 0 && distances[lane] <= best_distance)
+				{
+					best_distance = distances[lane];
+					is_hit = true;
+
+					hit.distance = distances[lane];
+					hit.triangle_index = (unsigned int)(i + lane);
+					hit.u = us[lane];
+					hit.v = vs[lane];
+				}
+			}
+		}
+
+		// Remaining triangles that don't fill 4 lanes:
+		if (simd_end < end)
+		{
+			is_hit = IntersectPackedTrianglesScalar(triangles, simd_end, end, segment, hit) || is_hit;
+		}
+
+		return is_hit;
+#else
+		return IntersectPackedTrianglesScalar(triangles, begin, end, segment, hit);
+#endif
+	}
+}
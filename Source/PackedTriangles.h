@@ -0,0 +1,77 @@
+#pragma once
+
+#include "MATH_GEO_LIB/Geometry/LineSegment.h"
+#include "MATH_GEO_LIB/Geometry/Triangle.h"
+
+#include <vector>
+
+#define PACKED_TRIANGLES_LANE_COUNT 4
+#define TRIANGLE_HIT_INVALID_INDEX 0xFFFFFFFF
+
+namespace StrawMath
+{
+	/// <summary>
+	/// Closest intersection of a line segment with a triangle.
+	/// </summary>
+	struct TriangleHit
+	{
+		/// <summary>
+		/// Position of the hit along the segment, 0 at its start and 1 at its
+		/// end. This doesn't change when both the segment and the triangles
+		/// are transformed, so hits on different meshes can be compared.
+		/// </summary>
+		float distance;
+
+		/// <summary>
+		/// Index of the triangle that is hit, TRIANGLE_HIT_INVALID_INDEX if
+		/// nothing is hit.
+		/// </summary>
+		unsigned int triangle_index;
+
+		/// <summary>
+		/// Barycentric coordinates of the hit point on the triangle.
+		/// </summary>
+		float u;
+		float v;
+	};
+
+	/// <summary>
+	/// Triangles stored as structure of arrays, each one as its first vertex
+	/// and the two edges from it, which is what the Moller-Trumbore test
+	/// needs. The intersection kernels load the same component of
+	/// PACKED_TRIANGLES_LANE_COUNT triangles at once.
+	/// </summary>
+	class PackedTriangles
+	{
+	public:
+		std::vector<float> vertex_x;
+		std::vector<float> vertex_y;
+		std::vector<float> vertex_z;
+		std::vector<float> edge_1_x;
+		std::vector<float> edge_1_y;
+		std::vector<float> edge_1_z;
+		std::vector<float> edge_2_x;
+		std::vector<float> edge_2_y;
+		std::vector<float> edge_2_z;
+
+	public:
+		void Add(const math::Triangle& triangle);
+		void AddPadding();
+		void Clear();
+		size_t Size() const;
+	};
+
+	/// <summary>
+	/// Finds the closest of the triangles in [begin, end) that segment hits,
+	/// closer than hit.distance. Uses SSE when the target supports it,
+	/// testing 4 triangles at a time.
+	/// </summary>
+	/// <param name="hit">Closest hit, only changed if a closer one is found. Its triangle_index is the index inside triangles.</param>
+	/// <returns>True if a hit closer than hit.distance is found.</returns>
+	bool IntersectPackedTriangles(const PackedTriangles& triangles, size_t begin, size_t end, const math::LineSegment& segment, TriangleHit& hit);
+
+	/// <summary>
+	/// Scalar version of IntersectPackedTriangles, tests one triangle at a time.
+	/// </summary>
+	bool IntersectPackedTrianglesScalar(const PackedTriangles& triangles, size_t begin, size_t end, const math::LineSegment& segment, TriangleHit& hit);
+}
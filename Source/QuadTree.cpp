@@ -4,279 +4,505 @@
 #include "ComponentMesh.h"
 #include "ComponentBoundingBox.h"
 
+#include <algorithm>
+
 namespace StrawMath
 {
 	// NW NE
 	// SW SE
 
+	// Offsets of the children from the first_child of their parent:
 #define NE 0
 #define SE 1
 #define SW 2
 #define NW 3
 
-#define QUADTREE_MAX_ITEMS 8
-#define QUADTREE_MIN_SIZE 10.0f 
+#define QUADTREE_MIN_SIZE 10.0f
 
-	QuadTreeNode::QuadTreeNode()
+	QuadTree::QuadTree()
 	{
-		parent = nullptr;
-		children[NE] = nullptr;
-		children[SE] = nullptr;
-		children[SW] = nullptr;
-		children[NW] = nullptr;
+
 	}
 
-	QuadTreeNode::~QuadTreeNode()
+	QuadTree::~QuadTree()
 	{
-		for (size_t i = 0; i < 4; ++i)
-		{
-			if (children[i] != nullptr)
-			{
-				delete children[i];
-			}
-		}
+		CleanUp();
+	}
+
+	/// <returns>Root node of the tree, nullptr if the container is not set.</returns>
+	const QuadTreeNode* const QuadTree::GetRootNode() const
+	{
+		return nodes.empty() ? nullptr : &nodes[0];
 	}
 
-	bool QuadTreeNode::IsLeaf() const
+	void QuadTree::SetContainer(const math::AABB& new_container)
 	{
-		// Since quadtrees either contain 4 children node, 
-		// or they are a leaf, checking for the first child
-		// node suffices to say if this node is the LeafNode.
+		CleanUp();
 
-		return children[0] == nullptr;
+		CreateNode(QUADTREE_INVALID_HANDLE, new_container);
 	}
 
-	QuadTreeNode* const QuadTreeNode::GetParent() const
+	/// <summary>
+	/// Inserts entity to the nodes its bounding box intersects with. If it's
+	/// already in the tree, this is the same as Update.
+	/// </summary>
+	/// <returns>False if the bounding box of entity is not inside the container of the tree.</returns>
+	bool QuadTree::Insert(Entity* const entity)
 	{
-		return parent;
+		if (nodes.empty())
+		{
+			return false;
+		}
+
+		if (Contains(entity))
+		{
+			return Update(entity);
+		}
+
+		math::AABB entity_aabb = entity->BoundingBox()->GetBoundingBox().MinimalEnclosingAABB();
+
+		// Entities that are partially outside would be missed by the queries
+		// that only see their outer parts, owner of the tree should resize it:
+		if (!nodes[0].container.Contains(entity_aabb))
+		{
+			return false;
+		}
+
+		// Get an index for the entity, reusing the freed ones first:
+		unsigned int entity_index;
+
+		if (!free_entity_indices.empty())
+		{
+			entity_index = free_entity_indices.back();
+			free_entity_indices.pop_back();
+			entities[entity_index] = entity;
+		}
+		else
+		{
+			entity_index = (unsigned int)entities.size();
+			entities.push_back(entity);
+			entity_entries.emplace_back();
+		}
+
+		entity_indices[entity] = entity_index;
+		entity_entries[entity_index].bounding_box = entity_aabb;
+
+		QuadTreeItem item;
+		item.bounding_box = entity_aabb;
+		item.entity_index = entity_index;
+
+		InsertIntoNode(0, item);
+
+		return true;
 	}
 
-	QuadTreeNode* QuadTreeNode::GetChildren() const
+	/// <summary>
+	/// Removes entity from the nodes that hold it and merges the nodes that
+	/// become underfull, without searching the tree.
+	/// </summary>
+	void QuadTree::Remove(Entity* const entity)
 	{
-		return *children;
+		std::unordered_map<const Entity*, unsigned int>::iterator index = entity_indices.find(entity);
+
+		if (index == entity_indices.end())
+		{
+			return;
+		}
+
+		unsigned int entity_index = index->second;
+		entity_indices.erase(index);
+
+		// Parents of the nodes that held the entity, deepest first. A merge
+		// only frees nodes deeper than the merged one, so the nodes left
+		// in the heap are never freed before they are visited:
+		nodes_to_merge.clear();
+
+		// RemoveItem removes the node from the back-references as well:
+		std::vector<unsigned int>& entity_nodes = entity_entries[entity_index].nodes;
+
+		while (!entity_nodes.empty())
+		{
+			unsigned int node_handle = entity_nodes.back();
+
+			RemoveItem(node_handle, FindItem(node_handle, entity_index));
+
+			unsigned int node_parent = nodes[node_handle].parent;
+
+			if (node_parent != QUADTREE_INVALID_HANDLE)
+			{
+				nodes_to_merge.push_back(std::make_pair(nodes[node_parent].depth, node_parent));
+				std::push_heap(nodes_to_merge.begin(), nodes_to_merge.end());
+			}
+		}
+
+		entities[entity_index] = nullptr;
+		free_entity_indices.push_back(entity_index);
+
+		while (!nodes_to_merge.empty())
+		{
+			unsigned int node_handle = nodes_to_merge.front().second;
+
+			// Siblings share their parent, so it may have been pushed more
+			// than once:
+			while (!nodes_to_merge.empty() && nodes_to_merge.front().second == node_handle)
+			{
+				std::pop_heap(nodes_to_merge.begin(), nodes_to_merge.end());
+				nodes_to_merge.pop_back();
+			}
+
+			if (!TryMergeChildren(node_handle))
+			{
+				continue;
+			}
+
+			unsigned int node_parent = nodes[node_handle].parent;
+
+			if (node_parent != QUADTREE_INVALID_HANDLE)
+			{
+				nodes_to_merge.push_back(std::make_pair(nodes[node_parent].depth, node_parent));
+				std::push_heap(nodes_to_merge.begin(), nodes_to_merge.end());
+			}
+		}
 	}
 
-	void QuadTreeNode::CreateChildren()
+	/// <summary>
+	/// Moves entity to the nodes that match its current bounding box.
+	/// Inserts it if it's not in the tree.
+	/// </summary>
+	/// <returns>False if the bounding box of entity is not inside the container of the tree.</returns>
+	bool QuadTree::Update(Entity* const entity)
 	{
-		// We need to subdivide this node ...
-		math::float3 size = container.Size();
-		// We don't change it's y coordinate since this is a QuadTree,
-		// not an Octree:
-		math::float3 new_size(size.x * 0.5f, size.y, size.z * 0.5f);
-		// We will calculate each new child node's center using 
-		// their parent's center:
-		math::float3 center = container.CenterPoint();
-		math::float3 new_center = center;
-
-		// Create North East node from center and size:
-		new_center.x = center.x + size.x * 0.25f;
-		new_center.z = center.z + size.z * 0.25f;
-		children[NE] = new QuadTreeNode();
-		children[NE]->SetContainer(math::AABB::FromCenterAndSize(new_center, new_size));
-
-		// Create South East node from center and size:
-		new_center.x = center.x + size.x * 0.25f;
-		new_center.z = center.z - size.z * 0.25f;
-		children[SE] = new QuadTreeNode();
-		children[SE]->SetContainer(math::AABB::FromCenterAndSize(new_center, new_size));
-
-		// Create South West node from center and size:
-		new_center.x = center.x - size.x * 0.25f;
-		new_center.z = center.z - size.z * 0.25f;
-		children[SW] = new QuadTreeNode();
-		children[SW]->SetContainer(math::AABB::FromCenterAndSize(new_center, new_size));
-
-		// Create North West node from center and position:
-		new_center.x = center.x - size.x * 0.25f;
-		new_center.z = center.z + size.z * 0.25f;
-		children[NW] = new QuadTreeNode();
-		children[NW]->SetContainer(math::AABB::FromCenterAndSize(new_center, new_size));
+		std::unordered_map<const Entity*, unsigned int>::iterator index = entity_indices.find(entity);
+
+		if (index == entity_indices.end())
+		{
+			return Insert(entity);
+		}
+
+		unsigned int entity_index = index->second;
+		EntityEntry& entry = entity_entries[entity_index];
+
+		math::AABB entity_aabb = entity->BoundingBox()->GetBoundingBox().MinimalEnclosingAABB();
+
+		// Nothing to do if it has not moved:
+		if (entity_aabb.minPoint.Equals(entry.bounding_box.minPoint) &&
+			entity_aabb.maxPoint.Equals(entry.bounding_box.maxPoint))
+		{
+			return true;
+		}
+
+		// If it's held by a single leaf and still fits inside of it, it
+		// would be inserted to the same leaf again:
+		if (entry.nodes.size() == 1)
+		{
+			QuadTreeNode& node = nodes[entry.nodes[0]];
+
+			if (node.IsLeaf() && node.container.Contains(entity_aabb))
+			{
+				node.GetItem(FindItem(entry.nodes[0], entity_index)).bounding_box = entity_aabb;
+				entry.bounding_box = entity_aabb;
+
+				return true;
+			}
+		}
+
+		Remove(entity);
+
+		return Insert(entity);
 	}
 
-	const math::AABB& QuadTreeNode::GetContainer() const
+	/// <returns>True if entity is inside this tree.</returns>
+	bool QuadTree::Contains(const Entity* entity) const
 	{
-		return container;
+		return entity_indices.find(entity) != entity_indices.end();
 	}
 
-	void QuadTreeNode::SetContainer(const math::AABB& new_container)
+	/// <summary>
+	/// Removes all the nodes and entities. Memory of the pools is kept so
+	/// that the tree can be rebuilt without allocating.
+	/// </summary>
+	void QuadTree::CleanUp()
 	{
-		container = new_container;
+		nodes.clear();
+		free_children.clear();
+		entities.clear();
+		entity_entries.clear();
+		free_entity_indices.clear();
+		entity_indices.clear();
 	}
 
-	void QuadTreeNode::SetChild(size_t index, QuadTreeNode* new_child)
+	unsigned int QuadTree::CreateNode(unsigned int parent, const math::AABB& container)
 	{
-		// Give error if the index is bigger than 3:
-		assert(index <= 3);
+		nodes.emplace_back();
+
+		QuadTreeNode& node = nodes.back();
+		node.container = container;
+		node.parent = parent;
+		node.first_child = QUADTREE_INVALID_HANDLE;
+		node.depth = parent == QUADTREE_INVALID_HANDLE ? 0 : nodes[parent].depth + 1;
+		node.item_count = 0;
 
-		children[index] = new_child;
+		return (unsigned int)nodes.size() - 1;
 	}
 
-	void QuadTreeNode::SetParent(QuadTreeNode* new_parent)
+	void QuadTree::CreateChildren(unsigned int node_handle)
 	{
-		parent = new_parent;
+		// We need to subdivide this node ...
+		math::float3 size = nodes[node_handle].container.Size();
+		// We don't change it's y coordinate since this is a QuadTree,
+		// not an Octree:
+		math::float3 new_size(size.x * 0.5f, size.y, size.z * 0.5f);
+		// We will calculate each new child node's center using
+		// their parent's center:
+		math::float3 center = nodes[node_handle].container.CenterPoint();
+
+		math::AABB containers[4];
+		// North East:
+		containers[NE] = math::AABB::FromCenterAndSize(math::float3(center.x + size.x * 0.25f, center.y, center.z + size.z * 0.25f), new_size);
+		// South East:
+		containers[SE] = math::AABB::FromCenterAndSize(math::float3(center.x + size.x * 0.25f, center.y, center.z - size.z * 0.25f), new_size);
+		// South West:
+		containers[SW] = math::AABB::FromCenterAndSize(math::float3(center.x - size.x * 0.25f, center.y, center.z - size.z * 0.25f), new_size);
+		// North West:
+		containers[NW] = math::AABB::FromCenterAndSize(math::float3(center.x - size.x * 0.25f, center.y, center.z + size.z * 0.25f), new_size);
+
+		// Children are always created as 4 consecutive nodes, reuse a
+		// group freed by a merge if there is any:
+		unsigned int first_child;
+
+		if (!free_children.empty())
+		{
+			first_child = free_children.back();
+			free_children.pop_back();
+
+			for (unsigned int i = 0; i < 4; ++i)
+			{
+				QuadTreeNode& child = nodes[first_child + i];
+				child.container = containers[i];
+				child.parent = node_handle;
+				child.first_child = QUADTREE_INVALID_HANDLE;
+				child.depth = nodes[node_handle].depth + 1;
+				child.item_count = 0;
+				child.overflow_items.clear();
+			}
+		}
+		else
+		{
+			first_child = (unsigned int)nodes.size();
+
+			for (unsigned int i = 0; i < 4; ++i)
+			{
+				CreateNode(node_handle, containers[i]);
+			}
+		}
+
+		nodes[node_handle].first_child = first_child;
 	}
 
-	void QuadTreeNode::Insert(Entity* const entity)
+	void QuadTree::InsertIntoNode(unsigned int node_handle, const QuadTreeItem& item)
 	{
+		const QuadTreeNode& node = nodes[node_handle];
+
 		const bool is_container_smaller_than_max_box_size =
-			(container.HalfSize().LengthSq() <= QUADTREE_MIN_SIZE * QUADTREE_MIN_SIZE);
-		const bool has_less_than_maximum_items = entities.size() < QUADTREE_MAX_ITEMS;
+			(node.container.HalfSize().LengthSq() <= QUADTREE_MIN_SIZE * QUADTREE_MIN_SIZE);
+		const bool has_less_than_maximum_items = node.item_count < QUADTREE_MAX_ITEMS;
 
-		// Store entity on this node if this node is a leaf and it's either smaller than
-		// container size or this node has less entities inside than the maximum amount:
-		if (IsLeaf() &&
+		// Store item on this node if this node is a leaf and it's either smaller than
+		// container size or this node has less items inside than the maximum amount:
+		if (node.IsLeaf() &&
 			(has_less_than_maximum_items ||
 				is_container_smaller_than_max_box_size))
 		{
-			entities.push_back(entity);
+			AddItem(node_handle, item);
 
 			return;
 		}
 
-		// If this is a leaf and we don't satisfy above conditions, 
-		// make create child nodes and make this non-leaf by dividing to 4:
-		if (IsLeaf())
+		// If this is a leaf and we don't satisfy above conditions,
+		// make create child nodes and make this non-leaf by dividing to 4.
+		// NOTE: This may grow nodes, node reference above is invalid after this.
+		if (node.IsLeaf())
 		{
-			CreateChildren();
+			CreateChildren(node_handle);
 		}
 
-		// Add the entity to this node:
-		entities.push_back(entity);
-		// Distribute the entities between child nodes:
-		DistributeChildren();
+		// Add the item to this node:
+		AddItem(node_handle, item);
+		// Distribute the items between child nodes:
+		DistributeChildren(node_handle);
 	}
 
-	void QuadTreeNode::Remove(Entity* const entity)
+	void QuadTree::AddItem(unsigned int node_handle, const QuadTreeItem& item)
 	{
-		// Find the index of the entity inside entities list
-		// of the node:
-		std::list<Entity*>::iterator index = std::find(entities.begin(), entities.end(), entity);
-
-		// index will be equal to the entities.end() if it's not 
-		// found successfully, hence we check for it, if not
-		// we erase it from our list:
-		if (index != entities.end())
+		QuadTreeNode& node = nodes[node_handle];
+
+		if (node.item_count < QUADTREE_MAX_ITEMS)
 		{
-			entities.erase(index);
+			node.items[node.item_count] = item;
 		}
+		else
+		{
+			node.overflow_items.push_back(item);
+		}
+
+		++node.item_count;
 
-		// If this is not a leaf node, call this function for
-		// the children too:
-		if (!IsLeaf())
+		entity_entries[item.entity_index].nodes.push_back(node_handle);
+	}
+
+	void QuadTree::RemoveItem(unsigned int node_handle, unsigned int item_index)
+	{
+		QuadTreeNode& node = nodes[node_handle];
+
+		unsigned int entity_index = node.GetItem(item_index).entity_index;
+
+		// Move the last item into the removed one's place:
+		node.GetItem(item_index) = node.GetItem(node.item_count - 1);
+
+		if (node.item_count > QUADTREE_MAX_ITEMS)
 		{
-			for (size_t i = 0; i < 4; ++i)
+			node.overflow_items.pop_back();
+		}
+
+		--node.item_count;
+
+		// Remove the node from the back-references of the entity:
+		std::vector<unsigned int>& entity_nodes = entity_entries[entity_index].nodes;
+		std::vector<unsigned int>::iterator index = std::find(entity_nodes.begin(), entity_nodes.end(), node_handle);
+
+		if (index != entity_nodes.end())
+		{
+			*index = entity_nodes.back();
+			entity_nodes.pop_back();
+		}
+	}
+
+	unsigned int QuadTree::FindItem(unsigned int node_handle, unsigned int entity_index) const
+	{
+		const QuadTreeNode& node = nodes[node_handle];
+
+		for (unsigned int i = 0; i < node.item_count; ++i)
+		{
+			if (node.GetItem(i).entity_index == entity_index)
 			{
-				children[i]->Remove(entity);
+				return i;
 			}
 		}
+
+		return QUADTREE_INVALID_HANDLE;
 	}
 
-	void QuadTreeNode::DistributeChildren()
+	void QuadTree::DistributeChildren(unsigned int node_handle)
 	{
 		// When called this function will distribute the
-		// entities this node has to it's children by
-		// calculating an AABB for each entity and checking
-		// for intersections with 
+		// items this node has to it's children by checking
+		// the AABB of each item for intersections with
+		// the containers of the children.
 
-		for (std::list<Entity*>::iterator iterator = entities.begin(); iterator != entities.end();)
+		for (unsigned int i = 0; i < nodes[node_handle].item_count;)
 		{
-			// Get the entity:
-			Entity* entity = *iterator;
+			// Copy the item, since inserting to the children may grow nodes:
+			QuadTreeItem item = nodes[node_handle].GetItem(i);
+			unsigned int first_child = nodes[node_handle].first_child;
 
-			// Create an aabb that encloses obb of the entity:
-			math::AABB bounding_box;
-			bounding_box.SetFrom(entity->BoundingBox()->GetBoundingBox());
-
-			// Create an intersections array that will hold if this
-			// bounding_box is intersecting with the child node's containers:
+			// Create an intersections array that will hold if the
+			// bounding box is intersecting with the child node's containers:
 			bool intersections[4];
-			for (size_t i = 0; i < 4; ++i)
+			for (unsigned int j = 0; j < 4; ++j)
 			{
-				intersections[i] = bounding_box.Intersects(children[i]->GetContainer());
+				intersections[j] = item.bounding_box.Intersects(nodes[first_child + j].container);
 			}
 
-			// Check if bounding aabb of the entity's obb intersects with all of
+			// Check if the bounding box of the item intersects with all of
 			// the children:
 			if (intersections[0] && intersections[1] &&
 				intersections[2] && intersections[3])
 			{
 				// If it's intersects with all the children,
-				// we can just keep this entity on this node.
-				++iterator;
+				// we can just keep this item on this node.
+				++i;
 				continue;
 			}
 
-			// Erase this entity from this node:
-			iterator = entities.erase(iterator);
+			// Erase this item from this node, last item is moved into i:
+			RemoveItem(node_handle, i);
 			// Add it to the children that it intersects with:
-			for (size_t i = 0; i < 4; ++i)
+			for (unsigned int j = 0; j < 4; ++j)
 			{
-				if (!intersections[i])
+				if (!intersections[j])
 				{
 					continue;
 				}
 
-				children[i]->Insert(entity);
+				InsertIntoNode(first_child + j, item);
 			}
-
 		}
 	}
 
+	/// <summary>
+	/// Moves the items of the children into the node and frees the
+	/// children, if all of them are leaves and they hold few enough items
+	/// together with the node.
+	/// </summary>
+	/// <returns>True if children are merged into the node, false otherwise.</returns>
+	bool QuadTree::TryMergeChildren(unsigned int node_handle)
+	{
+		if (nodes[node_handle].IsLeaf())
+		{
+			return false;
+		}
 
-	// QuadTree:
+		unsigned int first_child = nodes[node_handle].first_child;
+		unsigned int total_items = nodes[node_handle].item_count;
 
-	QuadTree::QuadTree() : root_node(nullptr)
-	{
+		for (unsigned int i = 0; i < 4; ++i)
+		{
+			if (!nodes[first_child + i].IsLeaf())
+			{
+				return false;
+			}
 
-	}
+			total_items += nodes[first_child + i].item_count;
+		}
 
-	QuadTree::~QuadTree()
-	{
-		CleanUp();
-	}
+		// Items of the entities that are in more than one child are counted
+		// more than once here, so this never merges more than it should:
+		if (total_items > QUADTREE_MAX_ITEMS)
+		{
+			return false;
+		}
 
-	QuadTreeNode* const QuadTree::GetRootNode() const
-	{
-		return root_node;
-	}
+		for (unsigned int i = 0; i < 4; ++i)
+		{
+			unsigned int child_handle = first_child + i;
 
-	void QuadTree::SetContainer(const math::AABB& new_container)
-	{
-		CleanUp();
+			while (nodes[child_handle].item_count > 0)
+			{
+				QuadTreeItem item = nodes[child_handle].GetItem(0);
 
-		root_node = new QuadTreeNode();
+				RemoveItem(child_handle, 0);
 
-		root_node->SetContainer(new_container);
-	}
+				// Entities that are in more than one child are
+				// added to the node only once:
+				if (!IsInNode(item.entity_index, node_handle))
+				{
+					AddItem(node_handle, item);
+				}
+			}
 
-	void QuadTree::Insert(Entity* const entity)
-	{
-		if (root_node == nullptr)
-		{
-			return;
+			nodes[child_handle].overflow_items.clear();
 		}
 
-		const math::OBB& entity_obb = entity->BoundingBox()->GetBoundingBox();
-		
-		if (!entity_obb.MinimalEnclosingAABB().Intersects(root_node->GetContainer()))
-		{
-			return;
-		}
+		nodes[node_handle].first_child = QUADTREE_INVALID_HANDLE;
+		free_children.push_back(first_child);
 
-		root_node->Insert(entity);
+		return true;
 	}
 
-	void QuadTree::Remove(Entity* const entity)
+	bool QuadTree::IsInNode(unsigned int entity_index, unsigned int node_handle) const
 	{
-		if (root_node == nullptr)
-		{
-			return;
-		}
-	}
+		const std::vector<unsigned int>& entity_nodes = entity_entries[entity_index].nodes;
 
-	void QuadTree::CleanUp()
-	{
-		delete root_node;
+		return std::find(entity_nodes.begin(), entity_nodes.end(), node_handle) != entity_nodes.end();
 	}
-
-}
\ No newline at end of file
+}
@@ -3,156 +3,332 @@
 #include "MATH_GEO_LIB/Geometry/AABB.h"
 #include "MATH_GEO_LIB/Math/float3.h"
 
-#include <list>
-#include <map>
+#include "RayQueryBuffer.h"
+#include "BatchQueryBuffer.h"
+
+#include <vector>
+#include <unordered_map>
+#include <utility>
+
+#define QUADTREE_MAX_ITEMS 8
+#define QUADTREE_INVALID_HANDLE 0xFFFFFFFF
 
 class Entity;
 class ComponentMesh;
 
 namespace StrawMath
 {
-	class QuadTreeNode
+	/// <summary>
+	/// An entity inside a QuadTreeNode, along with the AABB that encloses
+	/// its OBB, so that queries don't need to reach the entity itself.
+	/// </summary>
+	struct QuadTreeItem
 	{
+		math::AABB bounding_box;
+		unsigned int entity_index;
+	};
+
+	/// <summary>
+	/// Node of a QuadTree. Nodes live inside the node pool of the tree and
+	/// refer to each other with handles, which are indices into that pool.
+	/// </summary>
+	struct QuadTreeNode
+	{
+		/// <summary>
+		/// Area this node covers.
+		/// </summary>
+		math::AABB container;
+
+		/// <summary>
+		/// Handle of the parent node, QUADTREE_INVALID_HANDLE for the root.
+		/// </summary>
+		unsigned int parent;
+
+		/// <summary>
+		/// Handle of the first of the 4 consecutive children nodes,
+		/// QUADTREE_INVALID_HANDLE if this is a leaf.
+		/// </summary>
+		unsigned int first_child;
+
+		/// <summary>
+		/// Number of ancestors of this node.
+		/// </summary>
+		unsigned int depth;
+
+		/// <summary>
+		/// Number of items in this node, the first QUADTREE_MAX_ITEMS of
+		/// them are in items and the rest are in overflow_items.
+		/// </summary>
+		unsigned int item_count;
+
+		/// <summary>
+		/// Items of this node, stored inline so that queries read them
+		/// along with the container.
+		/// </summary>
+		QuadTreeItem items[QUADTREE_MAX_ITEMS];
+
+		/// <summary>
+		/// Items that don't fit in items. Only the nodes that cannot be
+		/// divided further and the nodes that keep the items overlapping
+		/// all their children can have these.
+		/// </summary>
+		std::vector<QuadTreeItem> overflow_items;
+
+		bool IsLeaf() const { return first_child == QUADTREE_INVALID_HANDLE; }
+		QuadTreeItem& GetItem(unsigned int index);
+		const QuadTreeItem& GetItem(unsigned int index) const;
+	};
+
+	inline QuadTreeItem& QuadTreeNode::GetItem(unsigned int index)
+	{
+		return index < QUADTREE_MAX_ITEMS ? items[index] : overflow_items[index - QUADTREE_MAX_ITEMS];
+	}
+
+	inline const QuadTreeItem& QuadTreeNode::GetItem(unsigned int index) const
+	{
+		return index < QUADTREE_MAX_ITEMS ? items[index] : overflow_items[index - QUADTREE_MAX_ITEMS];
+	}
+
+	class QuadTree
+	{
+	private:
+		/// <summary>
+		/// Back-references of an entity inside the tree.
+		/// </summary>
+		struct EntityEntry
+		{
+			/// <summary>
+			/// AABB that encloses the OBB of the entity when it was inserted.
+			/// </summary>
+			math::AABB bounding_box;
+
+			/// <summary>
+			/// Handles of the nodes that hold the entity.
+			/// </summary>
+			std::vector<unsigned int> nodes;
+		};
+
+		/// <summary>
+		/// Pool of the nodes, root node is always the first one if the
+		/// container of the tree is set.
+		/// </summary>
+		std::vector<QuadTreeNode> nodes;
+
+		/// <summary>
+		/// First handles of the groups of 4 children nodes that were
+		/// freed by merges, reused before growing nodes.
+		/// </summary>
+		std::vector<unsigned int> free_children;
+
+		/// <summary>
+		/// Entities in the tree, indexed by entity_index of the items.
+		/// Freed indices are nullptr until they are reused.
+		/// </summary>
+		std::vector<Entity*> entities;
+		std::vector<EntityEntry> entity_entries;
+		std::vector<unsigned int> free_entity_indices;
+		std::unordered_map<const Entity*, unsigned int> entity_indices;
+
+		/// <summary>
+		/// Heap of (depth, handle) pairs of the nodes Remove may merge,
+		/// deepest first. Kept as a member so that Remove does not allocate.
+		/// </summary>
+		std::vector<std::pair<unsigned int, unsigned int>> nodes_to_merge;
+
 	public:
-		QuadTreeNode();
-		~QuadTreeNode();
-
-		bool IsLeaf() const;
-		QuadTreeNode* const GetParent() const;
-		QuadTreeNode* GetChildren() const;
-		void CreateChildren();
-		const math::AABB& GetContainer() const;
+		QuadTree();
+		~QuadTree();
+
+		const QuadTreeNode* const GetRootNode() const;
+
 		void SetContainer(const math::AABB& new_container);
-		void SetChild(size_t index, QuadTreeNode* new_child);
-		void SetParent(QuadTreeNode* new_parent);
-		void Insert(Entity* const entity);
+		bool Insert(Entity* const entity);
 		void Remove(Entity* const entity);
-		void DistributeChildren();
+		bool Update(Entity* const entity);
+		bool Contains(const Entity* entity) const;
+		void CleanUp();
 
-		template<typename INTERSECTABLE_T>
-		void FillWithIntersections(std::map<float, Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const;
 		template<typename INTERSECTABLE_T>
 		void FillWithIntersections(std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const;
+		template<typename INTERSECTABLE_T, typename CANDIDATE_FUNCTION_T>
+		void RaycastNearestFirst(const INTERSECTABLE_T& intersectable, float max_distance, RayQueryBuffer& buffer, const CANDIDATE_FUNCTION_T& test_candidate) const;
+		template<typename INTERSECTABLE_T>
+		void FillWithBatchIntersections(const INTERSECTABLE_T* intersectables, size_t count, BatchQueryBuffer& buffer) const;
 
 	private:
-		QuadTreeNode* parent;
-		QuadTreeNode* children[4];
-		std::list<Entity*> entities;
-		math::AABB container;
+		template<typename INTERSECTABLE_T>
+		void FillWithIntersections(unsigned int node_handle, std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const;
+		template<typename INTERSECTABLE_T>
+		void FillWithBatchIntersections(unsigned int node_handle, const BatchQueryRange& parent_queries, const INTERSECTABLE_T* intersectables, BatchQueryBuffer& buffer) const;
+
+		unsigned int CreateNode(unsigned int parent, const math::AABB& container);
+		void CreateChildren(unsigned int node_handle);
+		void InsertIntoNode(unsigned int node_handle, const QuadTreeItem& item);
+		void AddItem(unsigned int node_handle, const QuadTreeItem& item);
+		void RemoveItem(unsigned int node_handle, unsigned int item_index);
+		unsigned int FindItem(unsigned int node_handle, unsigned int entity_index) const;
+		void DistributeChildren(unsigned int node_handle);
+		bool TryMergeChildren(unsigned int node_handle);
+		bool IsInNode(unsigned int entity_index, unsigned int node_handle) const;
 	};
 
 	template<typename INTERSECTABLE_T>
-	inline void QuadTreeNode::FillWithIntersections(std::map<float, Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const
+	inline void QuadTree::FillWithIntersections(std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const
 	{
-		// If it's not intersecting with this node's container, halt the method
-		// don't even look at the children nodes
-		if (!intersectable.Intersects(container))
+		if (nodes.empty())
 		{
 			return;
 		}
 
-		float hit_near = 0.0f;
-		float hit_far = 0.0f;
+		FillWithIntersections(0, intersecting_entities, intersectable);
+	}
+
+	template<typename INTERSECTABLE_T>
+	inline void QuadTree::FillWithIntersections(unsigned int node_handle, std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const
+	{
+		const QuadTreeNode& node = nodes[node_handle];
+
+		if (!intersectable.Intersects(node.container))
+		{
+			return;
+		}
 
-		for (Entity* entity : entities)
+		for (unsigned int i = 0; i < node.item_count; ++i)
 		{
-			// If this intersects with the current entity's bounding box,
-			// insert it to the intersecting_entities by mapping it wrt
-			// it's hit_near:
-			if (intersectable.Intersects(entity->BoundingBox()->GetBoundingBox(), hit_near, hit_far))
+			const QuadTreeItem& item = node.GetItem(i);
+
+			// If this intersects with the current item's bounding box,
+			// push it's entity back to the intersecting_entities:
+			if (intersectable.Intersects(item.bounding_box))
 			{
-				intersecting_entities[hit_near] = entity;
+				intersecting_entities.push_back(entities[item.entity_index]);
 			}
 		}
 
 		// If it's leaf we are done:
-		if (IsLeaf())
+		if (node.IsLeaf())
 		{
 			return;
 		}
 
-		for (size_t i = 0; i < 4; ++i)
+		for (unsigned int i = 0; i < 4; ++i)
 		{
 			// If the children node has entities with intersections with intersectable
 			// as well, call this method on them too:
-			children[i]->FillWithIntersections(intersecting_entities, intersectable);
+			FillWithIntersections(node.first_child + i, intersecting_entities, intersectable);
 		}
 	}
 
-	template<typename INTERSECTABLE_T>
-	inline void QuadTreeNode::FillWithIntersections(std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const
+	/// <summary>
+	/// See SpatialIndex::RaycastNearestFirst. Children are pushed by the
+	/// distance to their containers.
+	/// </summary>
+	template<typename INTERSECTABLE_T, typename CANDIDATE_FUNCTION_T>
+	inline void QuadTree::RaycastNearestFirst(const INTERSECTABLE_T& intersectable, float max_distance, RayQueryBuffer& buffer, const CANDIDATE_FUNCTION_T& test_candidate) const
 	{
-		if (!intersectable.Intersects(container))
+		buffer.Clear();
+
+		float hit_near = 0.0f;
+		float hit_far = 0.0f;
+
+		if (nodes.empty() || !intersectable.Intersects(nodes[0].container, hit_near, hit_far))
 		{
 			return;
 		}
 
-		for (Entity* entity : entities)
+		buffer.PushNode(hit_near, 0);
+
+		while (!buffer.IsEmpty())
 		{
-			// If this intersects with the current entity's bounding box,
-			// push it back to the intersecting_entities :
-			if (intersectable.Intersects(entity->BoundingBox()->GetBoundingBox()))
+			RayQueryEntry entry = buffer.PopNearest();
+
+			// Everything left starts after the closest hit:
+			if (entry.distance > max_distance)
 			{
-				intersecting_entities.push_back(entity);
+				break;
 			}
-		}
-
-		// If it's leaf we are done:
-		if (IsLeaf())
-		{
-			return;
-		}
 
-		for (size_t i = 0; i < 4; ++i)
-		{
-			// If the children node has entities with intersections with intersectable
-			// as well, call this method on them too:
-			children[i]->FillWithIntersections(intersecting_entities, intersectable);
-		}
-	}
+			if (entry.entity != nullptr)
+			{
+				test_candidate(entry.entity, max_distance);
+				continue;
+			}
 
-	class QuadTree
-	{
-	private:
-		QuadTreeNode* root_node;
+			const QuadTreeNode& node = nodes[entry.node_handle];
 
-	public:
-		QuadTree();
-		~QuadTree();
+			// An entity may be pushed more than once if it's in more than
+			// one node, test_candidate is expected to handle that:
+			for (unsigned int i = 0; i < node.item_count; ++i)
+			{
+				const QuadTreeItem& item = node.GetItem(i);
 
-		QuadTreeNode* const GetRootNode() const;
+				if (intersectable.Intersects(item.bounding_box, hit_near, hit_far) && hit_near <= max_distance)
+				{
+					buffer.PushEntity(hit_near, entities[item.entity_index]);
+				}
+			}
 
-		void SetContainer(const math::AABB& new_container);
-		void Insert(Entity* const entity);
-		void Remove(Entity* const entity);
-		void CleanUp();
+			if (node.IsLeaf())
+			{
+				continue;
+			}
 
-		template<typename INTERSECTABLE_T>
-		void FillWithIntersections(std::map<float, Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const;
-		template<typename INTERSECTABLE_T>
-		void FillWithIntersections(std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const;
+			for (unsigned int i = 0; i < 4; ++i)
+			{
+				const unsigned int child = node.first_child + i;
 
-	};
+				if (intersectable.Intersects(nodes[child].container, hit_near, hit_far) && hit_near <= max_distance)
+				{
+					buffer.PushNode(hit_near, child);
+				}
+			}
+		}
+	}
 
+	/// <summary>
+	/// See SpatialIndex::FillWithBatchIntersections. Queries are narrowed
+	/// down by the container of each node.
+	/// </summary>
 	template<typename INTERSECTABLE_T>
-	inline void QuadTree::FillWithIntersections(std::map<float, Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const
+	inline void QuadTree::FillWithBatchIntersections(const INTERSECTABLE_T* intersectables, size_t count, BatchQueryBuffer& buffer) const
 	{
-		if (root_node == nullptr)
+		const BatchQueryRange all_queries = buffer.ActivateAll(count);
+
+		if (nodes.empty() || count == 0)
 		{
 			return;
 		}
 
-		root_node->FillWithIntersections(intersecting_entities, intersectable);
+		FillWithBatchIntersections(0, all_queries, intersectables, buffer);
 	}
 
 	template<typename INTERSECTABLE_T>
-	inline void QuadTree::FillWithIntersections(std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const
+	inline void QuadTree::FillWithBatchIntersections(unsigned int node_handle, const BatchQueryRange& parent_queries, const INTERSECTABLE_T* intersectables, BatchQueryBuffer& buffer) const
 	{
-		if (root_node == nullptr)
+		const QuadTreeNode& node = nodes[node_handle];
+
+		const BatchQueryRange node_queries = buffer.ActivateIntersecting(parent_queries, intersectables, node.container);
+
+		if (node_queries.count != 0)
 		{
-			return;
+			// An entity may be found more than once by the same query if
+			// it's in more than one node:
+			for (unsigned int i = 0; i < node.item_count; ++i)
+			{
+				const QuadTreeItem& item = node.GetItem(i);
+
+				buffer.AddHits(node_queries, intersectables, item.bounding_box, entities[item.entity_index]);
+			}
+
+			if (!node.IsLeaf())
+			{
+				for (unsigned int i = 0; i < 4; ++i)
+				{
+					FillWithBatchIntersections(node.first_child + i, node_queries, intersectables, buffer);
+				}
+			}
 		}
 
-		root_node->FillWithIntersections(intersecting_entities, intersectable);
+		buffer.Deactivate(node_queries);
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,58 @@
+#include "RayQueryBuffer.h"
+
+#include <algorithm>
+
+namespace StrawMath
+{
+	void RayQueryBuffer::Clear()
+	{
+		entries.clear();
+	}
+
+	bool RayQueryBuffer::IsEmpty() const
+	{
+		return entries.empty();
+	}
+
+	void RayQueryBuffer::PushNode(float distance, unsigned int node_handle)
+	{
+		RayQueryEntry entry;
+		entry.distance = distance;
+		entry.node_handle = node_handle;
+		entry.entity = nullptr;
+
+		Push(entry);
+	}
+
+	void RayQueryBuffer::PushEntity(float distance, Entity* entity)
+	{
+		RayQueryEntry entry;
+		entry.distance = distance;
+		entry.node_handle = 0;
+		entry.entity = entity;
+
+		Push(entry);
+	}
+
+	/// <returns>Entry with the smallest distance, removing it from the buffer. Buffer must not be empty.</returns>
+	RayQueryEntry RayQueryBuffer::PopNearest()
+	{
+		RayQueryEntry entry = entries.back();
+		entries.pop_back();
+
+		return entry;
+	}
+
+	void RayQueryBuffer::Push(const RayQueryEntry& entry)
+	{
+		// Entries are sorted by decreasing distance, insert after the ones
+		// that are farther or as far:
+		std::vector<RayQueryEntry>::iterator position = std::upper_bound(entries.begin(), entries.end(), entry,
+			[](const RayQueryEntry& new_entry, const RayQueryEntry& entry)
+			{
+				return new_entry.distance > entry.distance;
+			});
+
+		entries.insert(position, entry);
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+class Entity;
+
+namespace StrawMath
+{
+	/// <summary>
+	/// Entry of a RayQueryBuffer, either a node of a spatial index that is
+	/// yet to be opened or an entity that is yet to be tested.
+	/// </summary>
+	struct RayQueryEntry
+	{
+		/// <summary>
+		/// Distance along the ray where the bounds of the entry are entered.
+		/// </summary>
+		float distance;
+
+		/// <summary>
+		/// Handle of the node, only valid if entity is nullptr.
+		/// </summary>
+		unsigned int node_handle;
+
+		/// <summary>
+		/// Entity to be tested, nullptr if this entry is a node.
+		/// </summary>
+		Entity* entity;
+	};
+
+	/// <summary>
+	/// Small buffer of ray query entries that is kept sorted by distance, so
+	/// that spatial indices can be walked nearest first. The entries are
+	/// stored farthest first, so the nearest one is popped from the back.
+	/// Meant to be kept and reused between queries, clearing it keeps its
+	/// memory.
+	/// </summary>
+	class RayQueryBuffer
+	{
+	private:
+		std::vector<RayQueryEntry> entries;
+
+	public:
+		void Clear();
+		bool IsEmpty() const;
+		void PushNode(float distance, unsigned int node_handle);
+		void PushEntity(float distance, Entity* entity);
+		RayQueryEntry PopNearest();
+
+	private:
+		void Push(const RayQueryEntry& entry);
+	};
+}
@@ -0,0 +1,470 @@
+#include "RenderQueue.h"
+
+#include "Application.h"
+#include "ModuleShaderProgram.h"
+
+#include "Entity.h"
+#include "ComponentTransform.h"
+#include "ComponentMesh.h"
+#include "ComponentMaterial.h"
+
+#include "GLEW/include/GL/glew.h"
+
+#include <cstddef>
+#include <cstring>
+
+#define RENDER_QUEUE_NO_TEXTURE 0xFFFFFFFF
+
+RenderQueue::RenderQueue() : instance_buffer(0), stats()
+{
+}
+
+RenderQueue::~RenderQueue()
+{
+	if (instance_buffer != 0)
+	{
+		glDeleteBuffers(1, &instance_buffer);
+	}
+}
+
+/// <summary>
+/// Removes the packets of the last frame, along with the ids given out
+/// for their keys.
+/// </summary>
+void RenderQueue::Clear()
+{
+	packets.clear();
+	program_ids.clear();
+	texture_set_ids.clear();
+	material_ids.clear();
+	geometry_ids.clear();
+}
+
+/// <summary>
+/// Adds a packet that draws mesh with the given program and material.
+/// </summary>
+/// <param name="material">Material to draw mesh with, nullptr to keep the bound textures.</param>
+/// <param name="depth">Distance to the camera, 0 at the camera and 1 at the far plane. Closer packets are drawn first.</param>
+void RenderQueue::Submit(unsigned int program_id, const ComponentMesh* mesh, const ComponentMaterial* material, float depth)
+{
+	const unsigned long long texture_set_hash = HashTextureSet(material);
+
+	DrawPacket packet;
+	packet.sort_key = MakeSortKey(
+		GetProgramKey(program_id), 
+		GetTextureSetKey(texture_set_hash), 
+		GetMaterialKey(material, texture_set_hash), 
+		GetGeometryKey(mesh), 
+		depth
+	);
+	packet.program_id = program_id;
+	packet.mesh = mesh;
+	packet.material = material;
+
+	packets.push_back(packet);
+}
+
+/// <summary>
+/// Sorts the packets by their keys with a least significant digit radix
+/// sort, 8 bits per pass. Passes where every key has the same digit are
+/// skipped, which is most of the high ones since there are only a few
+/// programs and texture sets.
+/// </summary>
+void RenderQueue::Sort()
+{
+	const size_t packet_count = packets.size();
+
+	sorted_packets.resize(packet_count);
+
+	for (unsigned int shift = 0; shift < 64; shift += 8)
+	{
+		size_t offsets[256] = {};
+
+		for (const DrawPacket& packet : packets)
+		{
+			++offsets[(packet.sort_key >> shift) & 0xFF];
+		}
+
+		if (offsets[(packets.empty() ? 0 : (packets[0].sort_key >> shift) & 0xFF)] == packet_count)
+		{
+			continue;
+		}
+
+		size_t offset = 0;
+
+		for (size_t& bucket : offsets)
+		{
+			const size_t bucket_count = bucket;
+			bucket = offset;
+			offset += bucket_count;
+		}
+
+		for (const DrawPacket& packet : packets)
+		{
+			sorted_packets[offsets[(packet.sort_key >> shift) & 0xFF]++] = packet;
+		}
+
+		packets.swap(sorted_packets);
+	}
+}
+
+/// <summary>
+/// Draws the packets in order. Runs of packets that CanInstance are drawn
+/// with one glDrawElementsInstanced, reading their matrices from the 
+/// instance buffer. The program, textures, material uniforms and vertex
+/// array are only changed when they differ from the ones the previous run
+/// used. Fills the stats of this frame.
+/// </summary>
+void RenderQueue::Execute()
+{
+	stats = RenderQueueStats();
+	stats.packet_count = (unsigned int)packets.size();
+
+	if (packets.empty())
+	{
+		return;
+	}
+
+	UploadInstances();
+
+	const ShaderUniforms& uniforms = App->shader_program->GetUniforms();
+
+	// Nothing is assumed to be bound at the start of the frame, as the
+	// editor and the importers bind their own state in between:
+	unsigned int current_program = 0;
+	unsigned int current_vertex_array = 0;
+	unsigned int bound_textures[RENDER_QUEUE_TEXTURE_UNIT_COUNT];
+	const ComponentMaterial* current_material = nullptr;
+	float current_shininess = 0.0f;
+	bool is_shininess_set = false;
+
+	for (unsigned int& bound_texture : bound_textures)
+	{
+		bound_texture = RENDER_QUEUE_NO_TEXTURE;
+	}
+
+	const size_t packet_count = packets.size();
+
+	size_t batch_begin = 0;
+
+	while (batch_begin < packet_count)
+	{
+		const DrawPacket& packet = packets[batch_begin];
+
+		size_t batch_end = batch_begin + 1;
+
+		while (batch_end < packet_count && CanInstance(packet, packets[batch_end]))
+		{
+			++batch_end;
+		}
+
+		if (packet.program_id != current_program)
+		{
+			glUseProgram(packet.program_id);
+
+			App->shader_program->SetUniform(uniforms.material_diffuse, 0);
+			App->shader_program->SetUniform(uniforms.material_specular, 1);
+			App->shader_program->SetUniform(uniforms.material_occlusion, 2);
+
+			current_program = packet.program_id;
+			current_material = nullptr;
+			is_shininess_set = false;
+
+			++stats.program_changes;
+		}
+
+		if (packet.material != nullptr && !HaveSameMaterialState(packet.material, current_material))
+		{
+			for (unsigned int unit = 0; unit < RENDER_QUEUE_TEXTURE_UNIT_COUNT; ++unit)
+			{
+				const unsigned int texture_id = packet.material->GetTextureId(unit);
+
+				if (texture_id == bound_textures[unit])
+				{
+					continue;
+				}
+
+				glActiveTexture(GL_TEXTURE0 + unit);
+				glBindTexture(GL_TEXTURE_2D, texture_id);
+
+				bound_textures[unit] = texture_id;
+
+				++stats.texture_binds;
+			}
+
+			const float shininess = packet.material->GetShininess();
+
+			if (!is_shininess_set || shininess != current_shininess)
+			{
+				App->shader_program->SetUniform(uniforms.material_shininess, shininess);
+
+				current_shininess = shininess;
+				is_shininess_set = true;
+			}
+
+			current_material = packet.material;
+
+			++stats.material_changes;
+		}
+
+		const unsigned int vertex_array = packet.mesh->GetVertexArrayObject();
+
+		if (vertex_array != current_vertex_array)
+		{
+			glBindVertexArray(vertex_array);
+			EnableInstanceAttributes();
+
+			current_vertex_array = vertex_array;
+
+			++stats.vertex_array_binds;
+		}
+
+		// GL 3.3 has no base instance, so the instance attributes of the
+		// vertex array are pointed at the first instance of this run:
+		BindInstanceAttributes(batch_begin);
+
+		++stats.instance_attribute_binds;
+
+		glDrawElementsInstanced(
+			GL_TRIANGLES, 
+			(GLsizei)packet.mesh->GetNumberOfIndices(), 
+			GL_UNSIGNED_INT, 
+			nullptr, 
+			(GLsizei)(batch_end - batch_begin)
+		);
+
+		++stats.draw_calls;
+
+		batch_begin = batch_end;
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+const std::vector<DrawPacket>& RenderQueue::GetPackets() const
+{
+	return packets;
+}
+
+const RenderQueueStats& RenderQueue::GetStats() const
+{
+	return stats;
+}
+
+/// <summary>
+/// Packs the ids and the quantized depth into a sort key. Ids that don't
+/// fit in their bits wrap around, which only makes the grouping worse, as
+/// Execute compares the actual state before changing it.
+/// </summary>
+/// <param name="depth">Clamped to [0, 1].</param>
+unsigned long long RenderQueue::MakeSortKey(unsigned int program, unsigned int texture_set, unsigned int material, unsigned int geometry, float depth)
+{
+	const unsigned long long max_depth = (1ull << RENDER_QUEUE_DEPTH_BITS) - 1;
+
+	depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+
+	unsigned long long key = 0;
+
+	key |= ((unsigned long long)program & ((1ull << RENDER_QUEUE_PROGRAM_BITS) - 1)) << RENDER_QUEUE_PROGRAM_SHIFT;
+	key |= ((unsigned long long)texture_set & ((1ull << RENDER_QUEUE_TEXTURE_SET_BITS) - 1)) << RENDER_QUEUE_TEXTURE_SET_SHIFT;
+	key |= ((unsigned long long)material & ((1ull << RENDER_QUEUE_MATERIAL_BITS) - 1)) << RENDER_QUEUE_MATERIAL_SHIFT;
+	key |= ((unsigned long long)geometry & ((1ull << RENDER_QUEUE_GEOMETRY_BITS) - 1)) << RENDER_QUEUE_GEOMETRY_SHIFT;
+	key |= (unsigned long long)(depth * (float)max_depth) << RENDER_QUEUE_DEPTH_SHIFT;
+
+	return key;
+}
+
+/// <summary>
+/// Writes the matrices of the sorted packets into instances, and uploads
+/// them to instance_buffer with one call.
+/// </summary>
+void RenderQueue::UploadInstances()
+{
+	instances.resize(packets.size());
+
+	for (size_t i = 0; i < packets.size(); ++i)
+	{
+		const ComponentTransform* transform = packets[i].mesh->Owner()->Transform();
+
+		const math::float4x4 model_matrix = transform->GetMatrix().Transposed();
+		const math::float3x3 normal_matrix = transform->GetNormalMatrix().Transposed();
+
+		memcpy(instances[i].model_matrix, model_matrix.ptr(), sizeof(instances[i].model_matrix));
+		memcpy(instances[i].normal_matrix, normal_matrix.ptr(), sizeof(instances[i].normal_matrix));
+	}
+
+	if (instance_buffer == 0)
+	{
+		glGenBuffers(1, &instance_buffer);
+	}
+
+	// Reallocating orphans the storage of the last frame, so the driver
+	// does not wait for the draws that may still be reading it:
+	// instance_buffer is left bound until the end of Execute, for
+	// BindInstanceAttributes to point at:
+	glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+	glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(InstanceData), instances.data(), GL_STREAM_DRAW);
+}
+
+/// <summary>
+/// Enables the per instance attributes of the bound vertex array and makes
+/// them advance once per instance. Both are vertex array state, so they
+/// only need to be set when a vertex array is bound.
+/// </summary>
+void RenderQueue::EnableInstanceAttributes() const
+{
+	for (unsigned int column = 0; column < 4; ++column)
+	{
+		const unsigned int location = RENDER_QUEUE_INSTANCE_MODEL_MATRIX_LOCATION + column;
+
+		glEnableVertexAttribArray(location);
+		glVertexAttribDivisor(location, 1);
+	}
+
+	for (unsigned int column = 0; column < 3; ++column)
+	{
+		const unsigned int location = RENDER_QUEUE_INSTANCE_NORMAL_MATRIX_LOCATION + column;
+
+		glEnableVertexAttribArray(location);
+		glVertexAttribDivisor(location, 1);
+	}
+}
+
+/// <summary>
+/// Points the per instance attributes of the bound vertex array at 
+/// instance_buffer, starting from first_instance. Each column of the 
+/// matrices is an attribute. Expects instance_buffer to be bound to
+/// GL_ARRAY_BUFFER.
+/// </summary>
+void RenderQueue::BindInstanceAttributes(size_t first_instance) const
+{
+	const GLsizei stride = sizeof(InstanceData);
+	const size_t first_offset = first_instance * sizeof(InstanceData);
+
+	for (unsigned int column = 0; column < 4; ++column)
+	{
+		const unsigned int location = RENDER_QUEUE_INSTANCE_MODEL_MATRIX_LOCATION + column;
+		const size_t offset = first_offset + offsetof(InstanceData, model_matrix) + column * 4 * sizeof(float);
+
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+	}
+
+	for (unsigned int column = 0; column < 3; ++column)
+	{
+		const unsigned int location = RENDER_QUEUE_INSTANCE_NORMAL_MATRIX_LOCATION + column;
+		const size_t offset = first_offset + offsetof(InstanceData, normal_matrix) + column * 3 * sizeof(float);
+
+		glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+	}
+}
+
+unsigned int RenderQueue::GetProgramKey(unsigned int program_id)
+{
+	return program_ids.emplace(program_id, (unsigned int)program_ids.size()).first->second;
+}
+
+/// <summary>
+/// Materials that bind the same textures share a texture set. A collision
+/// of texture_set_hash only merges two groups.
+/// </summary>
+unsigned int RenderQueue::GetTextureSetKey(unsigned long long texture_set_hash)
+{
+	// Packets without a material hash to 0 and keep the key 0, so that
+	// they are drawn before the texture sets of the frame:
+	if (texture_set_hash == 0)
+	{
+		return 0;
+	}
+
+	return texture_set_ids.emplace(texture_set_hash, (unsigned int)texture_set_ids.size() + 1).first->second;
+}
+
+/// <summary>
+/// Materials with the same textures and shininess share a key, even if
+/// they are different components, so that copies of a model can be drawn
+/// as instances.
+/// </summary>
+unsigned int RenderQueue::GetMaterialKey(const ComponentMaterial* material, unsigned long long texture_set_hash)
+{
+	if (material == nullptr)
+	{
+		return 0;
+	}
+
+	const float shininess = material->GetShininess();
+
+	unsigned int shininess_bits = 0;
+	memcpy(&shininess_bits, &shininess, sizeof(shininess_bits));
+
+	const unsigned long long hash = (texture_set_hash ^ shininess_bits) * 1099511628211ull;
+
+	return material_ids.emplace(hash, (unsigned int)material_ids.size() + 1).first->second;
+}
+
+/// <summary>
+/// Meshes that share a vertex array share geometry.
+/// </summary>
+unsigned int RenderQueue::GetGeometryKey(const ComponentMesh* mesh)
+{
+	return geometry_ids.emplace(mesh->GetVertexArrayObject(), (unsigned int)geometry_ids.size()).first->second;
+}
+
+/// <returns>
+/// FNV-1a hash of the texture ids material binds, 0 if material is nullptr.
+/// </returns>
+unsigned long long RenderQueue::HashTextureSet(const ComponentMaterial* material)
+{
+	if (material == nullptr)
+	{
+		return 0;
+	}
+
+	unsigned long long hash = 14695981039346656037ull;
+
+	for (unsigned int unit = 0; unit < RENDER_QUEUE_TEXTURE_UNIT_COUNT; ++unit)
+	{
+		hash = (hash ^ material->GetTextureId(unit)) * 1099511628211ull;
+	}
+
+	return hash;
+}
+
+/// <returns>
+/// True if drawing with material and other_material binds the same 
+/// textures and sets the same shininess. False if only one of them is
+/// nullptr.
+/// </returns>
+bool RenderQueue::HaveSameMaterialState(const ComponentMaterial* material, const ComponentMaterial* other_material)
+{
+	if (material == other_material)
+	{
+		return true;
+	}
+
+	if (material == nullptr || other_material == nullptr)
+	{
+		return false;
+	}
+
+	for (unsigned int unit = 0; unit < RENDER_QUEUE_TEXTURE_UNIT_COUNT; ++unit)
+	{
+		if (material->GetTextureId(unit) != other_material->GetTextureId(unit))
+		{
+			return false;
+		}
+	}
+
+	return material->GetShininess() == other_material->GetShininess();
+}
+
+/// <returns>
+/// True if other_packet can be drawn as another instance of the draw call
+/// of packet.
+/// </returns>
+bool RenderQueue::CanInstance(const DrawPacket& packet, const DrawPacket& other_packet)
+{
+	return packet.program_id == other_packet.program_id &&
+		packet.mesh->GetVertexArrayObject() == other_packet.mesh->GetVertexArrayObject() &&
+		HaveSameMaterialState(packet.material, other_packet.material);
+}
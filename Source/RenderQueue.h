@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Layout of the 64 bit sort key of a draw packet, from the most to the
+/// least significant bits: program, texture set, material, geometry and
+/// depth. Packets are sorted by key, so that the packets that share the
+/// costly state end up next to each other, and the ones that also share
+/// geometry can be drawn as instances of one draw call.
+/// </summary>
+#define RENDER_QUEUE_PROGRAM_BITS 8
+#define RENDER_QUEUE_TEXTURE_SET_BITS 16
+#define RENDER_QUEUE_MATERIAL_BITS 12
+#define RENDER_QUEUE_GEOMETRY_BITS 16
+#define RENDER_QUEUE_DEPTH_BITS 12
+
+#define RENDER_QUEUE_DEPTH_SHIFT 0
+#define RENDER_QUEUE_GEOMETRY_SHIFT (RENDER_QUEUE_DEPTH_SHIFT + RENDER_QUEUE_DEPTH_BITS)
+#define RENDER_QUEUE_MATERIAL_SHIFT (RENDER_QUEUE_GEOMETRY_SHIFT + RENDER_QUEUE_GEOMETRY_BITS)
+#define RENDER_QUEUE_TEXTURE_SET_SHIFT (RENDER_QUEUE_MATERIAL_SHIFT + RENDER_QUEUE_MATERIAL_BITS)
+#define RENDER_QUEUE_PROGRAM_SHIFT (RENDER_QUEUE_TEXTURE_SET_SHIFT + RENDER_QUEUE_TEXTURE_SET_BITS)
+
+/// <summary>
+/// Number of textures a material binds, diffuse, specular and occlusion.
+/// </summary>
+#define RENDER_QUEUE_TEXTURE_UNIT_COUNT 3
+
+/// <summary>
+/// Attribute locations of the per instance matrices in the vertex shader.
+/// A mat4 takes 4 locations and a mat3 takes 3.
+/// </summary>
+#define RENDER_QUEUE_INSTANCE_MODEL_MATRIX_LOCATION 3
+#define RENDER_QUEUE_INSTANCE_NORMAL_MATRIX_LOCATION 7
+
+class ComponentMesh;
+class ComponentMaterial;
+
+/// <summary>
+/// Everything needed to draw a mesh, submitted to the render queue.
+/// </summary>
+struct DrawPacket
+{
+	unsigned long long sort_key;
+	unsigned int program_id;
+	const ComponentMesh* mesh;
+
+	/// <summary>
+	/// Material of the owner of mesh, nullptr if it has none, in which
+	/// case the textures that are already bound are used.
+	/// </summary>
+	const ComponentMaterial* material;
+};
+
+/// <summary>
+/// Per instance data of a packet, read by the vertex shader from the
+/// instance buffer. Matrices are column major, as OpenGL expects them.
+/// </summary>
+struct InstanceData
+{
+	float model_matrix[16];
+	float normal_matrix[9];
+};
+
+/// <summary>
+/// Counters of the last executed frame of a render queue.
+/// </summary>
+struct RenderQueueStats
+{
+	unsigned int packet_count;
+	unsigned int program_changes;
+	unsigned int material_changes;
+	unsigned int texture_binds;
+	unsigned int vertex_array_binds;
+
+	/// <summary>
+	/// Times the per instance attributes were pointed at a new run of the
+	/// instance buffer, once per draw call.
+	/// </summary>
+	unsigned int instance_attribute_binds;
+	unsigned int draw_calls;
+
+	/// <returns>
+	/// Sum of the state changes made by the queue.
+	/// </returns>
+	unsigned int StateChanges() const
+	{
+		return program_changes + material_changes + texture_binds + vertex_array_binds + instance_attribute_binds;
+	}
+};
+
+/// <summary>
+/// Collects the draw packets of a frame, sorts them by their keys with a
+/// radix sort and issues them, only changing the state that differs from
+/// the previous packet. Consecutive packets with the same program, vertex
+/// array and material state are drawn with one instanced draw call. 
+/// Program, texture set, material and geometry ids in the keys are given 
+/// out per frame in submission order.
+/// </summary>
+class RenderQueue
+{
+private:
+	std::vector<DrawPacket>									packets;
+	std::vector<DrawPacket>									sorted_packets;
+	std::vector<InstanceData>								instances;
+	std::unordered_map<unsigned int, unsigned int>			program_ids;
+	std::unordered_map<unsigned long long, unsigned int>	texture_set_ids;
+	std::unordered_map<unsigned long long, unsigned int>	material_ids;
+	std::unordered_map<unsigned int, unsigned int>			geometry_ids;
+	unsigned int											instance_buffer;
+	RenderQueueStats										stats;
+
+public:
+	RenderQueue();
+	~RenderQueue();
+
+	void Clear();
+	void Submit(unsigned int program_id, const ComponentMesh* mesh, const ComponentMaterial* material, float depth);
+	void Sort();
+	void Execute();
+
+	const std::vector<DrawPacket>& GetPackets() const;
+	const RenderQueueStats& GetStats() const;
+
+	static unsigned long long MakeSortKey(unsigned int program, unsigned int texture_set, unsigned int material, unsigned int geometry, float depth);
+
+private:
+	void UploadInstances();
+	void EnableInstanceAttributes() const;
+	void BindInstanceAttributes(size_t first_instance) const;
+
+	unsigned int GetProgramKey(unsigned int program_id);
+	unsigned int GetTextureSetKey(unsigned long long texture_set_hash);
+	unsigned int GetMaterialKey(const ComponentMaterial* material, unsigned long long texture_set_hash);
+	unsigned int GetGeometryKey(const ComponentMesh* mesh);
+
+	static unsigned long long HashTextureSet(const ComponentMaterial* material);
+	static bool HaveSameMaterialState(const ComponentMaterial* material, const ComponentMaterial* other_material);
+	static bool CanInstance(const DrawPacket& packet, const DrawPacket& other_packet);
+};
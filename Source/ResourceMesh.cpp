@@ -0,0 +1,196 @@
+#include "ResourceMesh.h"
+
+#include "GLEW/include/GL/glew.h"
+#include "MATH_GEO_LIB/Geometry/Triangle.h"
+
+#include <cstdlib>
+#include <cstring>
+
+ResourceMesh::ResourceMesh() :
+	vertices(nullptr),
+	indices(nullptr),
+	vertex_array_object(0),
+	vertex_buffer_object(0),
+	element_buffer_object(0),
+	bounding_box(),
+	number_of_vertices(0),
+	number_of_indices(0),
+	number_of_triangles(0),
+	content_hash(0),
+	reference_count(0)
+{
+}
+
+ResourceMesh::~ResourceMesh()
+{
+	Unload();
+}
+
+void ResourceMesh::Load(float* new_vertices, unsigned int* new_indices, size_t new_number_of_vertices, size_t new_number_of_indices, size_t new_number_of_triangles)
+{
+	// If Load was called before this call, clear
+	// all the previous mesh data and load afterwards:
+	Unload();
+
+	// Get vertices:
+	vertices = new_vertices;
+	// Get indices:
+	indices = new_indices;
+
+	// Get supplied number of vertices, indices and triangles:
+	number_of_vertices = new_number_of_vertices;
+	number_of_indices = new_number_of_indices;
+	number_of_triangles = new_number_of_triangles;
+
+	content_hash = HashContent(vertices, indices, number_of_vertices, number_of_indices);
+
+	// Cache triangles for easy access:
+	cached_triangles.reserve(number_of_triangles);
+
+	for (size_t i = 0; i < number_of_indices; i += 3)
+	{
+		size_t index_1 = indices[i];
+		size_t index_2 = indices[i + 1];
+		size_t index_3 = indices[i + 2];
+
+		math::float3 a(vertices[index_1 * 8], vertices[index_1 * 8 + 1], vertices[index_1 * 8 + 2]);
+		math::float3 b(vertices[index_2 * 8], vertices[index_2 * 8 + 1], vertices[index_2 * 8 + 2]);
+		math::float3 c(vertices[index_3 * 8], vertices[index_3 * 8 + 1], vertices[index_3 * 8 + 2]);
+
+		cached_triangles.push_back(math::Triangle(a, b, c));
+	}
+
+	// Build the BVH used by ray queries:
+	triangle_bvh.Build(cached_triangles);
+
+	// Load AABB:
+	LoadAABB();
+
+	// Generate VAO:
+	glGenVertexArrays(1, &vertex_array_object);
+	// Generate VBO:
+	glGenBuffers(1, &vertex_buffer_object);
+	// Generate EBO:
+	glGenBuffers(1, &element_buffer_object);
+
+	// Bind VAO:
+	glBindVertexArray(vertex_array_object);
+
+	// Bind VBO:
+	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_object);
+	// Allocate memory and store data within the initialized
+	// memory in the currently bound vertex buffer object
+	// a.k.a VBO with id vertex_buffer_object:
+	glBufferData(GL_ARRAY_BUFFER, number_of_vertices * 8 * sizeof(float), &vertices[0], GL_STATIC_DRAW);
+
+	// Bind EBO:
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer_object);
+	// Allocate memory and store data within the initialized
+	// memory in the currently bound vertex buffer object
+	// a.k.a EBO with id element_buffer_object:
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, number_of_indices * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+
+	size_t vertices_size = sizeof(float) * 8;
+
+	// Enable position attribute:
+	glEnableVertexAttribArray(0);
+	// Give position/size/data-type/stride of position attributes:
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, vertices_size, (void*)0); // Offset by 0 floats
+
+	// Enable normal attribute:
+	glEnableVertexAttribArray(1);
+	// Give position/size/data-type/stride of normal attributes:
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, vertices_size, (void*)(sizeof(float) * 3)); // Offset by 3 floats (position)
+
+	// Enable texture-coordinates attribute:
+	glEnableVertexAttribArray(2);
+	// Give position/size/data-type/stride of texture-coordinates attributes:
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, vertices_size, (void*)(sizeof(float) * 6)); // Offset by 6 floats (position + normal)
+
+	// Unbind VAO with id vertex_array_object_id:
+	glBindVertexArray(0);
+}
+
+void ResourceMesh::Unload()
+{
+	free(indices);
+	free(vertices);
+
+	indices = nullptr;
+	vertices = nullptr;
+
+	cached_triangles.clear();
+	triangle_bvh.CleanUp();
+
+	if (vertex_array_object != 0)
+	{
+		glDeleteBuffers(1, &element_buffer_object);
+		glDeleteBuffers(1, &vertex_buffer_object);
+		glDeleteVertexArrays(1, &vertex_array_object);
+	}
+
+	vertex_array_object = 0;
+	vertex_buffer_object = 0;
+	element_buffer_object = 0;
+
+	number_of_vertices = 0;
+	number_of_indices = 0;
+	number_of_triangles = 0;
+
+	content_hash = 0;
+}
+
+bool ResourceMesh::Intersects(const math::LineSegment& segment_local, StrawMath::TriangleHit& hit) const
+{
+	return triangle_bvh.Intersects(segment_local, hit);
+}
+
+bool ResourceMesh::HasSameContent(const float* other_vertices, const unsigned int* other_indices, size_t other_number_of_vertices, size_t other_number_of_indices) const
+{
+	if (number_of_vertices != other_number_of_vertices || number_of_indices != other_number_of_indices)
+	{
+		return false;
+	}
+
+	return memcmp(vertices, other_vertices, number_of_vertices * 8 * sizeof(float)) == 0 &&
+		memcmp(indices, other_indices, number_of_indices * sizeof(unsigned int)) == 0;
+}
+
+unsigned long long ResourceMesh::HashContent(const float* vertices, const unsigned int* indices, size_t number_of_vertices, size_t number_of_indices)
+{
+	unsigned long long hash = 14695981039346656037ull;
+
+	const unsigned char* vertex_bytes = (const unsigned char*)vertices;
+	const size_t vertex_byte_count = number_of_vertices * 8 * sizeof(float);
+
+	for (size_t i = 0; i < vertex_byte_count; ++i)
+	{
+		hash = (hash ^ vertex_bytes[i]) * 1099511628211ull;
+	}
+
+	const unsigned char* index_bytes = (const unsigned char*)indices;
+	const size_t index_byte_count = number_of_indices * sizeof(unsigned int);
+
+	for (size_t i = 0; i < index_byte_count; ++i)
+	{
+		hash = (hash ^ index_bytes[i]) * 1099511628211ull;
+	}
+
+	return hash;
+}
+
+void ResourceMesh::LoadAABB()
+{
+	float3* temp_vertices = new float3[number_of_vertices];
+
+	for (size_t i = 0; i < number_of_vertices * 8; i += 8)
+	{
+		temp_vertices[i / 8] = float3(vertices[i + 0], vertices[i + 1], vertices[i + 2]);
+	}
+
+	bounding_box.SetNegativeInfinity();
+
+	bounding_box.SetFrom(temp_vertices, number_of_vertices);
+
+	delete[] temp_vertices;
+}
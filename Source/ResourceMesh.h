@@ -0,0 +1,161 @@
+#pragma once
+
+#include "TriangleBVH.h"
+
+#include "MATH_GEO_LIB/Geometry/AABB.h"
+
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Geometry of a mesh, loaded once into GPU buffers and shared by every
+/// ComponentMesh that draws it. Created and destroyed by ResourceMeshCache,
+/// which keeps count of the components that refer to it.
+/// </summary>
+class ResourceMesh
+{
+	friend class ResourceMeshCache;
+
+private:
+	/// <summary>
+	/// Vertices of this ResourceMesh. Vertex data is stored as an
+	/// interleaved array as follows:
+	/// position_1.x, position_1.y, position_1.z, normal_1.x, normal_1.y, normal_1.z, texture_1.x, texture_1.y, ...
+	/// </summary>
+	float* vertices;
+
+	/// <summary>
+	/// Indices of this ResourceMesh. Indices data is stored as follows:
+	/// first_index_1, second_index_1, third_index_1, ...
+	/// </summary>
+	unsigned int* indices;
+
+	/// <summary>
+	/// VAO ID of this ResourceMesh.
+	/// </summary>
+	unsigned int vertex_array_object;
+
+	/// <summary>
+	/// VBO ID of this ResourceMesh.
+	/// </summary>
+	unsigned int vertex_buffer_object;
+
+	/// <summary>
+	/// EBO ID of this ResourceMesh.
+	/// </summary>
+	unsigned int element_buffer_object;
+
+	/// <summary>
+	/// AABB that encloses the vertices of this ResourceMesh.
+	/// </summary>
+	math::AABB bounding_box;
+
+	/// <summary>
+	/// Number of vertices this ResourceMesh has.
+	/// </summary>
+	size_t number_of_vertices;
+
+	/// <summary>
+	/// Number of indices this ResourceMesh has.
+	/// </summary>
+	size_t number_of_indices;
+
+	/// <summary>
+	/// Number of triangles this ResourceMesh has.
+	/// This should be equal to number_of_indices / 3,
+	/// but stored anyway.
+	/// </summary>
+	size_t number_of_triangles;
+
+	/// <summary>
+	/// This vector stores triangles of the mesh for convenience for
+	/// the intersection functions, mouse picking etc.
+	/// This is a special std::vector<math::Triangle> under the hood.
+	/// </summary>
+	math::TriangleArray cached_triangles;
+
+	/// <summary>
+	/// BVH over cached_triangles, built on Load. Used to find the triangles
+	/// a ray hits without testing all of them.
+	/// </summary>
+	StrawMath::TriangleBVH triangle_bvh;
+
+	/// <summary>
+	/// Hash of vertices and indices, see HashContent.
+	/// </summary>
+	unsigned long long content_hash;
+
+	/// <summary>
+	/// Keys this ResourceMesh is cached with in ResourceMeshCache. More
+	/// than one if meshes of different files have the same content.
+	/// </summary>
+	std::vector<std::string> path_keys;
+
+	/// <summary>
+	/// Number of ComponentMeshes that refer to this ResourceMesh.
+	/// </summary>
+	unsigned int reference_count;
+
+public:
+	ResourceMesh();
+	~ResourceMesh();
+
+	/// <summary>
+	/// Loads this mesh with provided vertices and indices, and uploads
+	/// them to the GPU. Takes the ownership of new_vertices and
+	/// new_indices, which must be allocated with malloc.
+	/// </summary>
+	/// <param name="new_vertices">Vertices array to be set as vertices.</param>
+	/// <param name="new_indices">Indices array to be set as indices.</param>
+	/// <param name="new_number_of_vertices">Value to be set as number of vertices.</param>
+	/// <param name="new_number_of_indices">Value to be set as number of indices.</param>
+	/// <param name="new_number_of_triangles">Value to be set as number of triangles.</param>
+	void Load(
+		float* new_vertices,
+		unsigned int* new_indices,
+		size_t new_number_of_vertices,
+		size_t new_number_of_indices,
+		size_t new_number_of_triangles
+	);
+
+	/// <summary>
+	/// Frees the vertices and indices, and deletes the GPU buffers.
+	/// </summary>
+	void Unload();
+
+	/// <summary>
+	/// Finds the closest triangle of this mesh that segment hits, using
+	/// triangle_bvh.
+	/// </summary>
+	/// <param name="segment_local">Segment in the local space of this mesh.</param>
+	/// <param name="hit">Closest hit, only changed if a hit closer than hit.distance is found.</param>
+	/// <returns>True if a hit closer than hit.distance is found.</returns>
+	bool Intersects(const math::LineSegment& segment_local, StrawMath::TriangleHit& hit) const;
+
+	/// <returns>
+	/// True if this ResourceMesh has exactly the given vertices and indices.
+	/// </returns>
+	bool HasSameContent(const float* other_vertices, const unsigned int* other_indices, size_t other_number_of_vertices, size_t other_number_of_indices) const;
+
+	unsigned int GetVertexArrayObject() const { return vertex_array_object; };
+	size_t GetNumberOfVertices() const { return number_of_vertices; };
+	size_t GetNumberOfIndices() const { return number_of_indices; };
+	size_t GetNumberOfTriangles() const { return number_of_triangles; };
+	const math::AABB& GetAABB() const { return bounding_box; };
+	const float* GetVertices() const { return vertices; };
+	const math::TriangleArray& GetTriangles() const { return cached_triangles; };
+	unsigned long long GetContentHash() const { return content_hash; };
+	unsigned int GetReferenceCount() const { return reference_count; };
+
+	/// <returns>
+	/// FNV-1a hash of the bytes of vertices and indices.
+	/// </returns>
+	static unsigned long long HashContent(const float* vertices, const unsigned int* indices, size_t number_of_vertices, size_t number_of_indices);
+
+private:
+	/// <summary>
+	/// Loads the AABB that encloses this ResourceMesh by traversing
+	/// its vertices array.
+	/// </summary>
+	void LoadAABB();
+};
@@ -0,0 +1,158 @@
+#include "ResourceMeshCache.h"
+#include "ResourceMesh.h"
+
+#include <cstdlib>
+
+ResourceMeshCache::ResourceMeshCache()
+{
+}
+
+ResourceMeshCache::~ResourceMeshCache()
+{
+	CleanUp();
+}
+
+ResourceMesh* ResourceMeshCache::Find(const std::string& path_key) const
+{
+	std::unordered_map<std::string, ResourceMesh*>::const_iterator it = resources_by_path.find(path_key);
+
+	return it != resources_by_path.end() ? it->second : nullptr;
+}
+
+ResourceMesh* ResourceMeshCache::Create(const std::string& path_key, float* vertices, unsigned int* indices, size_t number_of_vertices, size_t number_of_indices, size_t number_of_triangles)
+{
+	// Content is compared even if path_key is cached, as the file may 
+	// have changed since it was imported:
+	const unsigned long long content_hash = ResourceMesh::HashContent(vertices, indices, number_of_vertices, number_of_indices);
+
+	auto candidates = resources_by_content.equal_range(content_hash);
+
+	for (auto it = candidates.first; it != candidates.second; ++it)
+	{
+		ResourceMesh* resource = it->second;
+
+		if (!resource->HasSameContent(vertices, indices, number_of_vertices, number_of_indices))
+		{
+			continue;
+		}
+
+		free(indices);
+		free(vertices);
+
+		if (Find(path_key) != resource)
+		{
+			resource->path_keys.push_back(path_key);
+			resources_by_path[path_key] = resource;
+		}
+
+		return resource;
+	}
+
+	ResourceMesh* resource = new ResourceMesh();
+	resource->Load(vertices, indices, number_of_vertices, number_of_indices, number_of_triangles);
+	resource->path_keys.push_back(path_key);
+
+	resources_by_path[path_key] = resource;
+	resources_by_content.emplace(resource->GetContentHash(), resource);
+
+	return resource;
+}
+
+void ResourceMeshCache::Acquire(ResourceMesh* resource)
+{
+	++resource->reference_count;
+}
+
+void ResourceMeshCache::Release(ResourceMesh* resource)
+{
+	if (resource->reference_count > 0)
+	{
+		--resource->reference_count;
+	}
+
+	if (resource->reference_count == 0)
+	{
+		Destroy(resource);
+	}
+}
+
+void ResourceMeshCache::SetModelMeshNames(const std::string& model_path, const std::vector<std::string>& mesh_names)
+{
+	model_mesh_names[model_path] = mesh_names;
+}
+
+bool ResourceMeshCache::FindModel(const std::string& model_path, std::vector<ResourceMesh*>& meshes, std::vector<std::string>& mesh_names) const
+{
+	std::unordered_map<std::string, std::vector<std::string>>::const_iterator model = model_mesh_names.find(model_path);
+
+	if (model == model_mesh_names.end())
+	{
+		return false;
+	}
+
+	meshes.clear();
+	meshes.reserve(model->second.size());
+
+	for (size_t i = 0; i < model->second.size(); ++i)
+	{
+		ResourceMesh* resource = Find(MakePathKey(model_path, i));
+
+		if (resource == nullptr)
+		{
+			return false;
+		}
+
+		meshes.push_back(resource);
+	}
+
+	mesh_names = model->second;
+
+	return true;
+}
+
+size_t ResourceMeshCache::GetResourceCount() const
+{
+	return resources_by_content.size();
+}
+
+void ResourceMeshCache::CleanUp()
+{
+	for (std::pair<const unsigned long long, ResourceMesh*>& entry : resources_by_content)
+	{
+		delete entry.second;
+	}
+
+	resources_by_path.clear();
+	resources_by_content.clear();
+	model_mesh_names.clear();
+}
+
+std::string ResourceMeshCache::MakePathKey(const std::string& model_path, size_t mesh_index)
+{
+	return model_path + "#" + std::to_string(mesh_index);
+}
+
+void ResourceMeshCache::Destroy(ResourceMesh* resource)
+{
+	// A key may have been taken over by a newer resource since:
+	for (const std::string& path_key : resource->path_keys)
+	{
+		if (Find(path_key) == resource)
+		{
+			resources_by_path.erase(path_key);
+		}
+	}
+
+	auto candidates = resources_by_content.equal_range(resource->GetContentHash());
+
+	for (auto it = candidates.first; it != candidates.second; ++it)
+	{
+		if (it->second == resource)
+		{
+			resources_by_content.erase(it);
+			break;
+		}
+	}
+
+	delete resource;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ResourceMesh;
+
+/// <summary>
+/// Owns every ResourceMesh, keyed by the canonical path of the model file
+/// they are imported from along with their index in that file, and by the
+/// hash of their content. A mesh that is imported again, or that has the
+/// same vertices and indices as a loaded one, reuses the loaded resource
+/// instead of uploading new buffers. Resources are destroyed when the last
+/// ComponentMesh that acquired them releases them.
+/// </summary>
+class ResourceMeshCache
+{
+private:
+	/// <summary>
+	/// Resources by their path keys, see MakePathKey.
+	/// </summary>
+	std::unordered_map<std::string, ResourceMesh*> resources_by_path;
+
+	/// <summary>
+	/// Resources by their content hash. Different contents may share a
+	/// hash, so candidates are compared before they are reused.
+	/// </summary>
+	std::unordered_multimap<unsigned long long, ResourceMesh*> resources_by_content;
+
+	/// <summary>
+	/// Names of the meshes of each imported model file, by the canonical
+	/// path of the file. Lets a model be built again without reading the
+	/// file, as long as all of its meshes are still cached.
+	/// </summary>
+	std::unordered_map<std::string, std::vector<std::string>> model_mesh_names;
+
+public:
+	ResourceMeshCache();
+	~ResourceMeshCache();
+
+	/// <returns>
+	/// Resource cached with path_key, nullptr if there is none.
+	/// </returns>
+	ResourceMesh* Find(const std::string& path_key) const;
+
+	/// <summary>
+	/// Returns a loaded resource with the same content if there is one, 
+	/// otherwise creates a new resource from the given data. Either way
+	/// the returned resource is cached with path_key. Takes the ownership 
+	/// of vertices and indices, freeing them if an existing resource is
+	/// returned.
+	/// </summary>
+	/// <returns>Resource with the given content, not yet acquired.</returns>
+	ResourceMesh* Create(
+		const std::string& path_key,
+		float* vertices,
+		unsigned int* indices,
+		size_t number_of_vertices,
+		size_t number_of_indices,
+		size_t number_of_triangles
+	);
+
+	/// <summary>
+	/// Adds a reference to resource.
+	/// </summary>
+	void Acquire(ResourceMesh* resource);
+
+	/// <summary>
+	/// Removes a reference from resource, destroys it if it was the last.
+	/// </summary>
+	void Release(ResourceMesh* resource);
+
+	/// <summary>
+	/// Stores the names of the meshes of the model in model_path, in the
+	/// order of their indices.
+	/// </summary>
+	void SetModelMeshNames(const std::string& model_path, const std::vector<std::string>& mesh_names);
+
+	/// <summary>
+	/// Fills meshes and mesh_names with the cached meshes of the model in
+	/// model_path.
+	/// </summary>
+	/// <returns>False if the model was never imported, or any of its meshes was destroyed since.</returns>
+	bool FindModel(const std::string& model_path, std::vector<ResourceMesh*>& meshes, std::vector<std::string>& mesh_names) const;
+
+	/// <returns>
+	/// Number of resources that are alive.
+	/// </returns>
+	size_t GetResourceCount() const;
+
+	/// <summary>
+	/// Destroys all the resources, even the ones still referenced.
+	/// </summary>
+	void CleanUp();
+
+	/// <returns>
+	/// Key of the mesh with mesh_index in the model file in model_path.
+	/// </returns>
+	static std::string MakePathKey(const std::string& model_path, size_t mesh_index);
+
+private:
+	void Destroy(ResourceMesh* resource);
+};
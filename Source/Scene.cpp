@@ -1,10 +1,15 @@
 #include "Scene.h"
 #include "Application.h"
+#include "WorkerPool.h"
+#include "ModuleSceneManager.h"
+#include "TransformStore.h"
+#include "ModuleShaderProgram.h"
 
 #include "ComponentCamera.h"
 #include "ComponentLight.h"
 #include "ComponentTransform.h"
 #include "ComponentMesh.h"
+#include "ComponentMaterial.h"
 #include "ComponentBoundingBox.h"
 
 #include "ModelImporter.h"
@@ -16,8 +21,8 @@ Scene::Scene() :
     root_entity(nullptr),
     selected_entity(nullptr),
     main_camera(nullptr),
-    components_changed_in_descendants_event_listener(components_changed_in_descendants_event_listener),
-    hierarchy_changed_event_listener(hierarchy_changed_event_listener)
+    is_spatial_index_dirty(false),
+    picking_query(this)
 {
 }
 
@@ -46,6 +51,35 @@ Entity* const Scene::GetRootEntity() const
     return root_entity;
 }
 
+/// <summary>
+/// Finds the entity with entity_id in this scene in O(1).
+/// </summary>
+/// <param name="entity_id">Id of the entity.</param>
+/// <returns>Entity with entity_id, nullptr if it's not in this scene.</returns>
+Entity* const Scene::FindEntity(unsigned int entity_id) const
+{
+    return entity_index.Find(entity_id);
+}
+
+/// <summary>
+/// Finds the component with component_id in this scene in O(1).
+/// </summary>
+/// <param name="component_id">Id of the component.</param>
+/// <returns>Component with component_id, nullptr if it's not in this scene.</returns>
+Component* const Scene::FindComponent(unsigned int component_id) const
+{
+    return component_index.Find(component_id);
+}
+
+/// <returns>
+/// Meshes registered to this scene, in no particular order. Per frame 
+/// systems should iterate this instead of traversing the hierarchy.
+/// </returns>
+const std::vector<ComponentMesh*>& Scene::GetMeshes() const
+{
+    return mesh_registry;
+}
+
 void Scene::SetMainCamera(ComponentCamera* new_main_camera)
 {
     main_camera = new_main_camera;
@@ -72,23 +106,492 @@ void Scene::SetSelectedEntity(Entity* new_selected_entity)
     selected_entity = new_selected_entity;
 }
 
+spatial_index_type Scene::GetSpatialIndexType() const
+{
+    return spatial_index.GetType();
+}
+
+/// <summary>
+/// Switches the structure static entities are kept in. The new structure
+/// is filled before the next culling.
+/// </summary>
+void Scene::SetSpatialIndexType(spatial_index_type new_type)
+{
+    if (new_type == spatial_index.GetType())
+    {
+        return;
+    }
+
+    spatial_index.SetType(new_type);
+    is_spatial_index_dirty = true;
+}
+
+/// <returns>
+/// True if mesh was found inside the frustum of the main camera by the
+/// last CullMeshes. Meshes registered after that are not visible.
+/// </returns>
+bool Scene::IsMeshVisible(const ComponentMesh* mesh) const
+{
+    unsigned int index = mesh->registry_index;
+
+    if (index >= mesh_culling_volumes.Size())
+    {
+        return false;
+    }
+
+    return StrawMath::IsVisible(mesh_visibility, index);
+}
+
+/// <returns>
+/// Render queue the meshes were drawn with in the last DrawMeshes, with
+/// its stats.
+/// </returns>
+const RenderQueue& Scene::GetRenderQueue() const
+{
+    return render_queue;
+}
+
+/// <summary>
+/// Finds the meshes inside the frustum of the main camera and stores the 
+/// result in mesh_visibility, indexed by the registry index of each mesh.
+/// Dynamic meshes are culled in chunks of SCENE_CULLING_CHUNK_SIZE on the
+/// worker pool, each chunk writing only its own part of the bitset. Static 
+/// meshes are found with a hierarchical query on spatial_index afterwards,
+/// which rejects whole nodes outside the frustum.
+/// </summary>
 void Scene::CullMeshes()
 {
-    for (ComponentMesh* mesh : mesh_components_in_scene)
+    PrepareBoundsForWorkers();
+
+    const size_t mesh_count = mesh_registry.size();
+
+    mesh_culling_volumes.Resize(mesh_count);
+    mesh_visibility.resize((mesh_count + 31) / 32);
+
+    const math::Frustum& frustum = main_camera->GetFrustum();
+
+    App->worker_pool->ParallelFor(mesh_count, SCENE_CULLING_CHUNK_SIZE, [this, &frustum](size_t begin, size_t end)
     {
+        GatherCullingVolumes(begin, end);
+
+        StrawMath::CullVolumes(frustum, mesh_culling_volumes, begin, end, mesh_visibility);
+    });
+
+    // Query the static entities, reusing the same vector. An entity may 
+    // be found more than once if it's in more than one node:
+    static_entities_in_frustum.clear();
+    spatial_index.FillWithIntersections(static_entities_in_frustum, frustum);
+
+    for (Entity* entity : static_entities_in_frustum)
+    {
+        entity->ForEachComponent<ComponentMesh>([this](ComponentMesh* mesh)
+        {
+            unsigned int index = mesh->registry_index;
+            mesh_visibility[index / 32] |= 1u << (index % 32);
+        });
+    }
+}
+
+/// <summary>
+/// Resolves the world matrices changed since ModuleSceneManager::PreUpdate,
+/// updates spatial_index and refits every out of date bounding box. World 
+/// matrices and bounding boxes are resolved lazily when they are accessed, 
+/// which writes to them and is not safe to do from the workers. After this
+/// the workers only read the fitted bounding boxes.
+/// </summary>
+void Scene::PrepareBoundsForWorkers()
+{
+    App->scene_manager->GetTransformStore()->UpdateWorldMatrices();
+
+    UpdateSpatialIndex();
+
+    if (root_entity != nullptr)
+    {
+        root_entity->BoundingBox()->GetBoundingBox();
+    }
+}
+
+/// <summary>
+/// Fills the culling volumes of the meshes in [begin, end) of mesh_registry.
+/// Called from the workers, so it must only read the scene.
+/// </summary>
+void Scene::GatherCullingVolumes(size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        Entity* owner = mesh_registry[i]->Owner();
+
+        // Meshes of static entities are culled unless the spatial index 
+        // query finds them inside the frustum:
+        if (IsInSpatialIndex(owner))
+        {
+            mesh_culling_volumes.SetNeverVisible(i);
+            continue;
+        }
+
         // TODO: Add component bounding box to all entities:
-        ComponentBoundingBox* bounding_box = 
-            mesh->Owner()->GetComponent<ComponentBoundingBox>();
+        ComponentBoundingBox* bounding_box = owner->BoundingBox();
 
         if (bounding_box == nullptr)
+        {
+            mesh_culling_volumes.SetAlwaysVisible(i);
+            continue;
+        }
+
+        mesh_culling_volumes.Set
+        (
+            i,
+            bounding_box->GetFittedBoundingBox().MinimalEnclosingAABB(), 
+            bounding_box->GetFittedMinimalEnclosingSphereRadius()
+        );
+    }
+}
+
+/// <summary>
+/// Submits the meshes that are enabled, visible and in an active
+/// hierarchy to render_queue, and draws them sorted by their state and
+/// front to back. Meshes that share geometry and material are drawn as
+/// instances of one draw call.
+/// </summary>
+void Scene::DrawMeshes()
+{
+    render_queue.Clear();
+
+    const unsigned int program_id = App->shader_program->GetProgramId();
+
+    const math::Frustum& frustum = main_camera->GetFrustum();
+    const float inverse_far_plane_distance = 1.0f / frustum.FarPlaneDistance();
+
+    for (ComponentMesh* mesh : mesh_registry)
+    {
+        if (!mesh->Enabled() || !IsMeshVisible(mesh))
         {
             continue;
         }
 
-        math::OBB obb = bounding_box->GetBoundingBox();
+        Entity* owner = mesh->Owner();
+
+        if (!owner->IsActiveInHierarchy())
+        {
+            continue;
+        }
+
+        const math::float3 position = owner->Transform()->GetMatrix().TranslatePart();
+        const float depth = frustum.Front().Dot(position - frustum.Pos()) * inverse_far_plane_distance;
+
+        const ComponentMaterial* material = (const ComponentMaterial*)owner->GetComponent(component_type::MATERIAL);
+
+        render_queue.Submit(program_id, mesh, material, depth);
+    }
+
+    render_queue.Sort();
+
+    // Camera and lights have written their values during the update:
+    App->shader_program->UploadUniformBlocks();
+
+    render_queue.Execute();
+}
+
+/// <summary>
+/// Adds entity and its components to the indices of this scene. 
+/// Called by Entity::SetScene, do not call this directly.
+/// </summary>
+void Scene::RegisterEntity(Entity* entity)
+{
+    entity_index.Insert(entity->Id(), entity);
+
+    for (Component* component : entity->Components())
+    {
+        RegisterComponent(entity, component);
+    }
+}
 
-        mesh->SetCulled(!main_camera->DoesOBBIntersectFrustum(obb));
+/// <summary>
+/// Removes entity and its components from the indices of this scene.
+/// Called by Entity::SetScene and Entity destructor, do not call this directly.
+/// </summary>
+void Scene::UnregisterEntity(Entity* entity)
+{
+    for (Component* component : entity->Components())
+    {
+        UnregisterComponent(entity, component);
     }
+
+    entity_index.Remove(entity->Id());
+}
+
+/// <summary>
+/// Adds component of owner to the indices of this scene. owner is passed 
+/// in, as Entity::AddComponent registers a component before initializing 
+/// it, when Owner of component is not set yet.
+/// </summary>
+void Scene::RegisterComponent(Entity* owner, Component* component)
+{
+    component_index.Insert(component->Id(), component);
+
+    if (component->Type() == component_type::MESH)
+    {
+        RegisterMesh(owner, (ComponentMesh*)component);
+    }
+}
+
+void Scene::UnregisterComponent(Entity* owner, Component* component)
+{
+    if (component->Type() == component_type::MESH)
+    {
+        UnregisterMesh(owner, (ComponentMesh*)component);
+    }
+
+    component_index.Remove(component->Id());
+}
+
+/// <summary>
+/// Appends mesh to the end of mesh_registry and stores its index
+/// inside mesh, so that it can be removed in O(1).
+/// </summary>
+void Scene::RegisterMesh(Entity* owner, ComponentMesh* mesh)
+{
+    if (mesh->registry_index != COMPONENT_MESH_INVALID_REGISTRY_INDEX)
+    {
+        return;
+    }
+
+    mesh->registry_index = (unsigned int)mesh_registry.size();
+    mesh_registry.push_back(mesh);
+
+    if (owner->IsStatic())
+    {
+        UpdateInSpatialIndex(owner);
+    }
+}
+
+/// <summary>
+/// Removes mesh from mesh_registry by moving the last mesh into its
+/// slot. Only the moved mesh's index changes, others stay the same.
+/// </summary>
+void Scene::UnregisterMesh(Entity* owner, ComponentMesh* mesh)
+{
+    unsigned int index = mesh->registry_index;
+
+    if (index == COMPONENT_MESH_INVALID_REGISTRY_INDEX || 
+        index >= mesh_registry.size() || 
+        mesh_registry[index] != mesh)
+    {
+        return;
+    }
+
+    ComponentMesh* last_mesh = mesh_registry.back();
+    mesh_registry[index] = last_mesh;
+    last_mesh->registry_index = index;
+    mesh_registry.pop_back();
+
+    mesh->registry_index = COMPONENT_MESH_INVALID_REGISTRY_INDEX;
+
+    spatial_index.Remove(owner);
+}
+
+/// <summary>
+/// Called by Entity::SetStatic when entity in this scene becomes static 
+/// or dynamic, do not call this directly.
+/// </summary>
+void Scene::HandleStaticnessChanged(Entity* entity)
+{
+    UpdateInSpatialIndex(entity);
+}
+
+/// <summary>
+/// Called by Entity::InvokeComponentsChangedEvents for static entities 
+/// in this scene, and for the transform changes of any entity in this
+/// scene, do not call this directly.
+/// </summary>
+void Scene::HandleEntityChanged(const Entity* entity, component_type type)
+{
+    // Only the changes that move the bounding box of a static entity 
+    // change its place in the spatial index. They are applied on the next
+    // UpdateSpatialIndex, ids are stored since entity may be deleted until then,
+    // and each of them is stored once however many times it changes.
+    // Transforms move the whole hierarchy under entity, descendants are
+    // not notified on their own, so entity is stored as the root of a
+    // hierarchy to be walked:
+    switch (type)
+    {
+        case component_type::TRANSFORM:
+            moved_hierarchy_root_ids.insert(entity->Id());
+            break;
+        case component_type::MESH:
+        case component_type::BOUNDING_BOX:
+            moved_static_entity_ids.insert(entity->Id());
+            break;
+        default:
+            break;
+    }
+}
+
+/// <summary>
+/// Rebuilds spatial_index from scratch with the static entities that have
+/// meshes, sized to enclose all of their bounding boxes.
+/// </summary>
+void Scene::RebuildSpatialIndex()
+{
+    is_spatial_index_dirty = false;
+    moved_static_entity_ids.clear();
+    moved_hierarchy_root_ids.clear();
+
+    spatial_index.CleanUp();
+
+    math::AABB scene_bounds;
+    scene_bounds.SetNegativeInfinity();
+
+    bool has_static_entities = false;
+
+    for (ComponentMesh* mesh : mesh_registry)
+    {
+        Entity* owner = mesh->Owner();
+
+        if (!IsInSpatialIndex(owner))
+        {
+            continue;
+        }
+
+        scene_bounds.Enclose(owner->BoundingBox()->GetBoundingBox());
+        has_static_entities = true;
+    }
+
+    if (!has_static_entities)
+    {
+        return;
+    }
+
+    spatial_index.SetContainer(scene_bounds);
+
+    for (ComponentMesh* mesh : mesh_registry)
+    {
+        Entity* owner = mesh->Owner();
+
+        if (IsInSpatialIndex(owner))
+        {
+            spatial_index.Insert(owner);
+        }
+    }
+}
+
+/// <summary>
+/// Moves the static entities that have changed since the last call inside
+/// spatial_index, and rebuilds it only if one of them has left its container.
+/// </summary>
+void Scene::UpdateSpatialIndex()
+{
+    // Each entity is updated at most once. Hierarchies under another moved
+    // hierarchy are walked along with it, and the static entities reached
+    // by the walks are removed from moved_static_entity_ids:
+    for (unsigned int entity_id : moved_hierarchy_root_ids)
+    {
+        Entity* entity = FindEntity(entity_id);
+
+        if (entity == nullptr)
+        {
+            continue;
+        }
+
+        // Bounding boxes in the hierarchy have moved without being marked
+        // dirty. Mark its root, so that the refit from the scene root
+        // reaches them and refits the ones whose world matrix has changed:
+        entity->BoundingBox()->MarkDirty();
+
+        if (IsUnderMovedHierarchy(entity))
+        {
+            continue;
+        }
+
+        UpdateHierarchyInSpatialIndex(entity);
+    }
+
+    for (unsigned int entity_id : moved_static_entity_ids)
+    {
+        Entity* entity = FindEntity(entity_id);
+
+        if (entity != nullptr)
+        {
+            UpdateInSpatialIndex(entity);
+        }
+    }
+
+    moved_hierarchy_root_ids.clear();
+    moved_static_entity_ids.clear();
+
+    if (is_spatial_index_dirty)
+    {
+        RebuildSpatialIndex();
+    }
+}
+
+/// <summary>
+/// Inserts, moves or removes entity in spatial_index with respect to whether
+/// it should be in it or not.
+/// </summary>
+void Scene::UpdateInSpatialIndex(Entity* entity)
+{
+    // Whole tree will be rebuilt anyway:
+    if (is_spatial_index_dirty)
+    {
+        return;
+    }
+
+    if (!IsInSpatialIndex(entity) || entity->GetComponent<ComponentMesh>() == nullptr)
+    {
+        spatial_index.Remove(entity);
+        return;
+    }
+
+    // Rebuild the tree with new bounds if entity is outside of it:
+    if (!spatial_index.Update(entity))
+    {
+        is_spatial_index_dirty = true;
+    }
+}
+
+/// <summary>
+/// Updates entity and its descendants in spatial_index, dynamic ones are
+/// skipped as they are not in it.
+/// </summary>
+void Scene::UpdateHierarchyInSpatialIndex(Entity* entity)
+{
+    // Whole tree will be rebuilt anyway:
+    if (is_spatial_index_dirty)
+    {
+        return;
+    }
+
+    if (entity->IsStatic())
+    {
+        UpdateInSpatialIndex(entity);
+        moved_static_entity_ids.erase(entity->Id());
+    }
+
+    for (Entity* child : entity->GetChildren())
+    {
+        UpdateHierarchyInSpatialIndex(child);
+    }
+}
+
+/// <returns>True if any ancestor of entity is in moved_hierarchy_root_ids.</returns>
+bool Scene::IsUnderMovedHierarchy(const Entity* entity) const
+{
+    for (const Entity* ancestor = entity->Parent(); ancestor != nullptr; ancestor = ancestor->Parent())
+    {
+        if (moved_hierarchy_root_ids.find(ancestor->Id()) != moved_hierarchy_root_ids.end())
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// <returns>True if entity is culled through spatial_index, false if it's culled linearly.</returns>
+bool Scene::IsInSpatialIndex(const Entity* entity) const
+{
+    return entity->IsStatic() && entity->BoundingBox() != nullptr;
 }
 
 void Scene::Initialize()
@@ -100,36 +603,7 @@ void Scene::Initialize()
     // Initialize the root_entity:
     root_entity = new Entity();
     root_entity->Initialize("Root Entity");
-
-    // Subscribe to the components_changed_in_descendants event 
-    // of root_entity:
-    components_changed_in_descendants_event_listener = 
-        EventListener<component_type>
-        (
-            std::bind
-            (
-                &Scene::HandleComponentsChangedInDescendantsOfRoot, 
-                this, 
-                std::placeholders::_1
-            )
-        );
-
-    root_entity->GetComponentsChangedInDescendantsEvent()
-        ->AddListener(&components_changed_in_descendants_event_listener);
-
-    // Subscribed to hierarchy changed event of the root entity:
-    hierarchy_changed_event_listener =
-        EventListener<entity_operation>
-        (
-            std::bind
-            (
-                &Scene::HandleHierarchyChangedEvent,
-                this,
-                std::placeholders::_1
-            )
-        );
-    root_entity->GetHierarchyChangedEvent()
-        ->AddListener(&hierarchy_changed_event_listener);
+    root_entity->SetScene(this);
 
     // Add an entity with a camera component to the root
     // entity:
@@ -173,56 +647,67 @@ void Scene::Initialize()
     Entity* clock_entity = ModelImporter::Import(clock_path.c_str());
     clock_entity->SetParent(root_entity);
     clock_entity->Transform()->SetPosition(math::float3(0.0f, 1.0f, 0.0f));
+    clock_entity->SetStatic(true);
 
     std::string doll_path = working_path + "\\Models\\Dollhouse.fbx";
     Entity* doll_entity = ModelImporter::Import(doll_path.c_str());
     doll_entity->SetParent(root_entity);
     doll_entity->Transform()->SetPosition(math::float3(38.0f, 1.0f, -4.0f));
+    doll_entity->SetStatic(true);
 
     std::string drawers_path = working_path + "\\Models\\Drawers.fbx";
     Entity* drawers_entity = ModelImporter::Import(drawers_path.c_str());
     drawers_entity->SetParent(root_entity);
     drawers_entity->Transform()->SetPosition(math::float3(8.0f, 1.0f, -4.0f));
+    drawers_entity->SetStatic(true);
 
     std::string firetruck_path = working_path + "\\Models\\Firetruck.fbx";
     Entity* firetruck_entity = ModelImporter::Import(firetruck_path.c_str());
     firetruck_entity->SetParent(root_entity);
     firetruck_entity->Transform()->SetPosition(math::float3(0.0f, 1.0f, 0.0f));
+    firetruck_entity->SetStatic(true);
 
     std::string floor_path = working_path + "\\Models\\Floor.fbx";
     Entity* floor_entity = ModelImporter::Import(floor_path.c_str());
     floor_entity->SetParent(root_entity);
     floor_entity->Transform()->SetPosition(math::float3(0.0f, 1.0f, 0.0f));
+    floor_entity->SetStatic(true);
 
     std::string hearse_path = working_path + "\\Models\\Hearse.FBX";
     Entity* hearse_entity = ModelImporter::Import(hearse_path.c_str());
     hearse_entity->SetParent(root_entity);
     hearse_entity->Transform()->SetPosition(math::float3(12.0f, 1.0f, -18.0f));
+    hearse_entity->SetStatic(true);
 
     std::string player_path = working_path + "\\Models\\Player.fbx";
     Entity* player_entity = ModelImporter::Import(player_path.c_str());
     player_entity->SetParent(root_entity);
     player_entity->Transform()->SetPosition(math::float3(20.0f, 1.0f, -20.0f));
+    player_entity->SetStatic(true);
 
     std::string robot_path = working_path + "\\Models\\Robot.FBX";
     Entity* robot_entity = ModelImporter::Import(robot_path.c_str());
     robot_entity->SetParent(root_entity);
     robot_entity->Transform()->SetPosition(math::float3(23.0f, 1.0f, -18.0f));
+    robot_entity->SetStatic(true);
 
     std::string spinning_path = working_path + "\\Models\\SpinningTop.fbx";
     Entity* spinning_entity = ModelImporter::Import(spinning_path.c_str());
     spinning_entity->SetParent(root_entity);
     spinning_entity->Transform()->SetPosition(math::float3(5.0f, 1.0f, -10.0f));
+    spinning_entity->SetStatic(true);
 
     std::string wall_path = working_path + "\\Models\\Wall.FBX";
     Entity* wall_entity = ModelImporter::Import(wall_path.c_str());
     wall_entity->SetParent(root_entity);
     wall_entity->Transform()->SetPosition(math::float3(0.0f, 1.0f, 0.0f));
+    wall_entity->SetStatic(true);
 
     std::string zombunny_path = working_path + "\\Models\\Zombunny.fbx";
     Entity* zombunny_entity = ModelImporter::Import(zombunny_path.c_str());
     zombunny_entity->SetParent(root_entity);
     zombunny_entity->Transform()->SetPosition(math::float3(9.0f, 1.0f, -20.0f));
+    zombunny_entity->SetStatic(true);
 
     /*
         Entity* player_model = ModelImporter::Import();
@@ -245,14 +730,15 @@ void Scene::Update()
 {
     root_entity->Update();
 
+    // Meshes are culled once per frame, after the entities are updated:
+    CullMeshes();
+
+    DrawMeshes();
+
     if (selected_entity != nullptr)
     {
         selected_entity->DrawGizmos();
     }
-
-    // TODO: Move this inside HandleComponentsChangedInDescendantsOfRoot
-    // For now we call this here bc we draw gizmos of non culled meshes
-    CullMeshes();
 }
 
 void Scene::PostUpdate()
@@ -269,86 +755,24 @@ void Scene::Delete()
 
     root_entity = nullptr;
 
+    spatial_index.CleanUp();
+    is_spatial_index_dirty = false;
+    moved_static_entity_ids.clear();
+    moved_hierarchy_root_ids.clear();
+
     selected_entity = nullptr;
 
     main_camera = nullptr;
 }
 
-void Scene::HandleHierarchyChangedEvent(entity_operation operation)
-{
-    if (operation != entity_operation::CHILDREN_CHANGED)
-    {
-        return;
-    }
-
-    // Get mesh components in scene:
-    mesh_components_in_scene.clear();
-    mesh_components_in_scene = (root_entity->GetComponentsInDescendants<ComponentMesh>());
-}
-
-void Scene::HandleComponentsChangedInDescendantsOfRoot(component_type type)
-{
-    // Right now we will only care about changes in transform, 
-    // mesh and bounding box components of descendants, as
-    // they will change the culled entities:
-    switch (type)
-    {
-        case component_type::TRANSFORM:
-            break;
-        case component_type::MESH:
-            break;
-        case component_type::BOUNDING_BOX:
-            break;
-        default:
-            return;
-    }
-    // NOTE(Baran): Add here to make all camera should_render false if new
-    // camera changes are discovered here and we are in editor mode.
-    
-    // Get mesh components in scene:
-    mesh_components_in_scene.clear();
-    mesh_components_in_scene = (root_entity->GetComponentsInDescendants<ComponentMesh>());
-}
-
 void Scene::CheckRaycast(LineSegment segment) 
 {
-    // Get all entities with mesh components:
-    std::vector<ComponentMesh*> meshes = 
-        root_entity->GetComponentsInDescendants<ComponentMesh>();
-    Entity* best_picking_candidate_entity = nullptr;
-
-    float distance_max = segment.Length();
-
     // NOTE: This only works when the camera is inside the model.
     // We couldn't find any fix for now, so it stays like this.
+    SceneRaycastHit hit;
 
-    for (ComponentMesh* mesh : meshes)
-    {
-        math::LineSegment segment_local(segment);
-        
-        segment_local.Transform(mesh->Owner()->Transform()->GetMatrix().Inverted());
-
-        const TriangleArray& triangles = mesh->GetTriangles();
-
-        for (const Triangle& triangle : triangles)
-        {
-            float distance;
-            math::float3 hit_point = math::float3::zero;
-
-            if (segment_local.Intersects(triangle, &distance, &hit_point))
-            {   
-                if (distance < distance_max)
-                {
-                    best_picking_candidate_entity = mesh->Owner();
-                    distance_max = distance;
-                }
-            }
-            
-        }   
-    }
-
-    if (best_picking_candidate_entity != nullptr)
+    if (picking_query.Raycast(segment, hit))
     {
-        SetSelectedEntity(best_picking_candidate_entity);
+        SetSelectedEntity(hit.entity);
     }
 }
\ No newline at end of file
@@ -1,25 +1,47 @@
 #pragma once
 
 #include "Entity.h"
-#include "Event.h"
 #include "ComponentType.h"
+#include "IdIndex.h"
+#include "SpatialIndex.h"
+#include "FrustumCulling.h"
+#include "SceneQuery.h"
+#include "RenderQueue.h"
 
 #include "MATH_GEO_LIB/Geometry/LineSegment.h"
 
+#include <unordered_set>
 #include <vector>
 
+/// <summary>
+/// Number of meshes culled by each job of the worker pool. Must be a
+/// multiple of 32, so that jobs never share an element of the bitset.
+/// </summary>
+#define SCENE_CULLING_CHUNK_SIZE 4096
+
 class ComponentCamera;
 class ComponentMesh;
 
 class Scene
 {
+	friend class SceneQuery;
+
 private:
 	ComponentCamera*				main_camera;
 	Entity*							selected_entity;
 	Entity*							root_entity;
-	EventListener<component_type>	components_changed_in_descendants_event_listener;
-	EventListener<entity_operation>	hierarchy_changed_event_listener;
-	std::vector<ComponentMesh*>		mesh_components_in_scene;
+	std::vector<ComponentMesh*>		mesh_registry;
+	IdIndex<Entity>					entity_index;
+	IdIndex<Component>				component_index;
+	StrawMath::SpatialIndex			spatial_index;
+	std::vector<Entity*>			static_entities_in_frustum;
+	std::unordered_set<unsigned int>	moved_static_entity_ids;
+	std::unordered_set<unsigned int>	moved_hierarchy_root_ids;
+	StrawMath::CullingVolumes		mesh_culling_volumes;
+	std::vector<unsigned int>		mesh_visibility;
+	bool							is_spatial_index_dirty;
+	SceneQuery						picking_query;
+	RenderQueue						render_queue;
 
 public:
 	Scene();
@@ -28,12 +50,27 @@ public:
 	ComponentCamera* const GetMainCamera() const;
 	Entity* const GetSelectedEntity() const;
 	Entity* const GetRootEntity() const;
+	Entity* const FindEntity(unsigned int entity_id) const;
+	Component* const FindComponent(unsigned int component_id) const;
+	const std::vector<ComponentMesh*>& GetMeshes() const;
+	bool IsMeshVisible(const ComponentMesh* mesh) const;
+	const RenderQueue& GetRenderQueue() const;
+	spatial_index_type GetSpatialIndexType() const;
 
 	void SetMainCamera(ComponentCamera* new_main_camera);
 	void SetSelectedEntity(Entity* new_selected_entity);
+	void SetSpatialIndexType(spatial_index_type new_type);
 	void CheckRaycast(LineSegment ray);
 
 	void CullMeshes();
+	void DrawMeshes();
+
+	void RegisterEntity(Entity* entity);
+	void UnregisterEntity(Entity* entity);
+	void RegisterComponent(Entity* owner, Component* component);
+	void UnregisterComponent(Entity* owner, Component* component);
+	void HandleStaticnessChanged(Entity* entity);
+	void HandleEntityChanged(const Entity* entity, component_type type);
 
 	void Initialize();
 	void PreUpdate();
@@ -42,6 +79,14 @@ public:
 	void Delete();
 
 private:
-	void HandleHierarchyChangedEvent(entity_operation operation);
-	void HandleComponentsChangedInDescendantsOfRoot(component_type type);
+	void RegisterMesh(Entity* owner, ComponentMesh* mesh);
+	void UnregisterMesh(Entity* owner, ComponentMesh* mesh);
+	void GatherCullingVolumes(size_t begin, size_t end);
+	void PrepareBoundsForWorkers();
+	void RebuildSpatialIndex();
+	void UpdateSpatialIndex();
+	void UpdateInSpatialIndex(Entity* entity);
+	void UpdateHierarchyInSpatialIndex(Entity* entity);
+	bool IsUnderMovedHierarchy(const Entity* entity) const;
+	bool IsInSpatialIndex(const Entity* entity) const;
 };
\ No newline at end of file
@@ -0,0 +1,370 @@
+#include "SceneQuery.h"
+#include "Application.h"
+#include "WorkerPool.h"
+
+#include "Scene.h"
+#include "Entity.h"
+#include "ComponentTransform.h"
+#include "ComponentMesh.h"
+#include "ComponentBoundingBox.h"
+
+#include <algorithm>
+
+SceneQuery::SceneQuery(Scene* scene) : scene(scene)
+{
+}
+
+SceneQuery::~SceneQuery()
+{
+}
+
+/// <summary>
+/// Finds the closest mesh triangle that segment hits. Static entities are
+/// visited nearest first, and the walk stops once the closest hit is
+/// nearer than everything left.
+/// </summary>
+/// <returns>True if a mesh is hit.</returns>
+bool SceneQuery::Raycast(const math::LineSegment& segment, SceneRaycastHit& hit)
+{
+	PrepareScene();
+
+	hit.entity = nullptr;
+	hit.mesh = nullptr;
+	hit.distance = 1.0f;
+	hit.triangle_index = TRIANGLE_HIT_INVALID_INDEX;
+	hit.u = 0.0f;
+	hit.v = 0.0f;
+
+	scene->spatial_index.RaycastNearestFirst(segment, hit.distance, ray_query_buffer,
+		[&segment, &hit](Entity* entity, float& max_distance)
+		{
+			entity->ForEachComponent<ComponentMesh>([&segment, &hit](ComponentMesh* mesh)
+			{
+				IntersectMesh(mesh, mesh->Owner()->Transform()->GetInverseMatrix(), segment, hit);
+			});
+
+			max_distance = hit.distance;
+		});
+
+	// Dynamic entities are not in the spatial index, test the bounds of
+	// their meshes against the closest hit so far before the triangles:
+	for (ComponentMesh* mesh : scene->mesh_registry)
+	{
+		Entity* owner = mesh->Owner();
+
+		if (scene->IsInSpatialIndex(owner))
+		{
+			continue;
+		}
+
+		ComponentBoundingBox* bounding_box = owner->BoundingBox();
+
+		if (bounding_box != nullptr)
+		{
+			float hit_near = 0.0f;
+			float hit_far = 0.0f;
+
+			if (!bounding_box->GetBoundingBox().Intersects(segment, hit_near, hit_far) || hit_near > hit.distance)
+			{
+				continue;
+			}
+		}
+
+		IntersectMesh(mesh, owner->Transform()->GetInverseMatrix(), segment, hit);
+	}
+
+	return hit.entity != nullptr;
+}
+
+/// <summary>
+/// Finds the closest mesh triangle that each of segments hits. The
+/// spatial index is walked once for all the segments, and the triangle
+/// tests are split across the worker pool. Each segment walks the BVH of
+/// a mesh on its own: the leaves only hold a packet of triangles, so few
+/// segments of a batch ever share one, and walking them together was
+/// slower in the ray_picking benchmark.
+/// </summary>
+/// <param name="hits">Closest hit of each segment, with a nullptr entity if nothing is hit.</param>
+void SceneQuery::Raycast(const math::LineSegment* segments, size_t segment_count, SceneRaycastHit* hits)
+{
+	PrepareScene();
+
+	scene->spatial_index.FillWithBatchIntersections(segments, segment_count, batch_query_buffer);
+
+	GatherCandidates(segment_count, true);
+
+	App->worker_pool->ParallelFor(segment_count, SCENE_QUERY_CHUNK_SIZE, [this, segments, hits](size_t begin, size_t end)
+	{
+		for (size_t query_index = begin; query_index < end; ++query_index)
+		{
+			const math::LineSegment& segment = segments[query_index];
+			SceneRaycastHit& hit = hits[query_index];
+
+			hit.entity = nullptr;
+			hit.mesh = nullptr;
+			hit.distance = 1.0f;
+			hit.triangle_index = TRIANGLE_HIT_INVALID_INDEX;
+			hit.u = 0.0f;
+			hit.v = 0.0f;
+
+			for (unsigned int i = static_candidate_offsets[query_index]; i < static_candidate_offsets[query_index + 1]; ++i)
+			{
+				IntersectCandidate(candidates[static_candidates[i]], segment, hit);
+			}
+
+			for (unsigned int candidate_index : dynamic_candidates)
+			{
+				IntersectCandidate(candidates[candidate_index], segment, hit);
+			}
+		}
+	});
+}
+
+/// <summary>
+/// Finds the entities whose bounding box overlaps each of spheres.
+/// </summary>
+/// <param name="hits">Filled with the overlaps, sorted by query index.</param>
+void SceneQuery::OverlapSpheres(const math::Sphere* spheres, size_t sphere_count, std::vector<SceneOverlapHit>& hits)
+{
+	Overlap(spheres, sphere_count, hits);
+}
+
+/// <summary>
+/// Finds the entities whose bounding box overlaps each of boxes.
+/// </summary>
+/// <param name="hits">Filled with the overlaps, sorted by query index.</param>
+void SceneQuery::OverlapBoxes(const math::AABB* boxes, size_t box_count, std::vector<SceneOverlapHit>& hits)
+{
+	Overlap(boxes, box_count, hits);
+}
+
+/// <summary>
+/// Brings the world matrices, the spatial index and the bounding boxes up
+/// to date on the main thread, so that the candidates can be gathered from
+/// the fitted bounding boxes and the workers only read them.
+/// </summary>
+void SceneQuery::PrepareScene()
+{
+	scene->PrepareBoundsForWorkers();
+}
+
+/// <summary>
+/// Turns the hits of the spatial index walk into a sorted list of
+/// candidates per query, without the duplicates of entities that are in
+/// more than one node, and gathers the dynamic entities, which every
+/// query tests.
+/// </summary>
+/// <param name="gather_meshes">True to gather the meshes of the candidates and the matrices to their local space, for raycasts.</param>
+void SceneQuery::GatherCandidates(size_t query_count, bool gather_meshes)
+{
+	candidates.clear();
+	candidate_meshes.clear();
+	candidate_indices.clear();
+	static_candidates.clear();
+	dynamic_candidates.clear();
+
+	std::vector<StrawMath::BatchQueryHit>& static_hits = batch_query_buffer.hits;
+
+	std::sort(static_hits.begin(), static_hits.end(), [](const StrawMath::BatchQueryHit& a, const StrawMath::BatchQueryHit& b)
+	{
+		return a.query_index != b.query_index ? a.query_index < b.query_index : a.entity < b.entity;
+	});
+
+	static_hits.erase(std::unique(static_hits.begin(), static_hits.end(), [](const StrawMath::BatchQueryHit& a, const StrawMath::BatchQueryHit& b)
+	{
+		return a.query_index == b.query_index && a.entity == b.entity;
+	}), static_hits.end());
+
+	static_candidate_offsets.assign(query_count + 1, 0);
+
+	for (const StrawMath::BatchQueryHit& static_hit : static_hits)
+	{
+		static_candidates.push_back(AddCandidate(static_hit.entity, gather_meshes));
+		++static_candidate_offsets[static_hit.query_index + 1];
+	}
+
+	for (size_t i = 0; i < query_count; ++i)
+	{
+		static_candidate_offsets[i + 1] += static_candidate_offsets[i];
+	}
+
+	for (ComponentMesh* mesh : scene->mesh_registry)
+	{
+		Entity* owner = mesh->Owner();
+
+		// Entities with more than one mesh are added once:
+		if (scene->IsInSpatialIndex(owner) || candidate_indices.find(owner) != candidate_indices.end())
+		{
+			continue;
+		}
+
+		dynamic_candidates.push_back(AddCandidate(owner, gather_meshes));
+	}
+}
+
+/// <returns>Index of the candidate of entity, which is added if it's not already a candidate.</returns>
+unsigned int SceneQuery::AddCandidate(Entity* entity, bool gather_meshes)
+{
+	std::unordered_map<const Entity*, unsigned int>::const_iterator found = candidate_indices.find(entity);
+
+	if (found != candidate_indices.end())
+	{
+		return found->second;
+	}
+
+	Candidate candidate;
+	candidate.entity = entity;
+	candidate.first_mesh = (unsigned int)candidate_meshes.size();
+
+	ComponentBoundingBox* bounding_box = entity->BoundingBox();
+	candidate.has_bounding_box = bounding_box != nullptr;
+
+	if (candidate.has_bounding_box)
+	{
+		candidate.bounding_box = bounding_box->GetFittedBoundingBox();
+	}
+
+	if (gather_meshes)
+	{
+		const math::float4x4 world_to_local = entity->Transform()->GetInverseMatrix();
+
+		entity->ForEachComponent<ComponentMesh>([this, &world_to_local](ComponentMesh* mesh)
+		{
+			candidate_meshes.push_back({ mesh, world_to_local });
+		});
+	}
+
+	candidate.mesh_count = (unsigned int)candidate_meshes.size() - candidate.first_mesh;
+
+	const unsigned int candidate_index = (unsigned int)candidates.size();
+
+	candidates.push_back(candidate);
+	candidate_indices[entity] = candidate_index;
+
+	return candidate_index;
+}
+
+/// <summary>
+/// Tests segment against the bounding box of candidate, then against the
+/// triangles of its meshes. Called from the workers, so it must only read.
+/// </summary>
+/// <param name="hit">Closest hit, only changed if a hit closer than hit.distance is found.</param>
+/// <returns>True if a hit closer than hit.distance is found.</returns>
+bool SceneQuery::IntersectCandidate(const Candidate& candidate, const math::LineSegment& segment, SceneRaycastHit& hit) const
+{
+	if (candidate.has_bounding_box)
+	{
+		float hit_near = 0.0f;
+		float hit_far = 0.0f;
+
+		if (!candidate.bounding_box.Intersects(segment, hit_near, hit_far) || hit_near > hit.distance)
+		{
+			return false;
+		}
+	}
+
+	bool is_hit = false;
+
+	for (unsigned int i = candidate.first_mesh; i < candidate.first_mesh + candidate.mesh_count; ++i)
+	{
+		const CandidateMesh& candidate_mesh = candidate_meshes[i];
+
+		is_hit |= IntersectMesh(candidate_mesh.mesh, candidate_mesh.world_to_local, segment, hit);
+	}
+
+	return is_hit;
+}
+
+/// <summary>
+/// Tests segment against the triangles of mesh in its local space.
+/// Distances along the segment are the same in the local space of every
+/// mesh, so hits on different meshes can be compared.
+/// </summary>
+/// <param name="hit">Closest hit, only changed if a hit closer than hit.distance is found.</param>
+/// <returns>True if a hit closer than hit.distance is found.</returns>
+bool SceneQuery::IntersectMesh(ComponentMesh* mesh, const math::float4x4& world_to_local, const math::LineSegment& segment, SceneRaycastHit& hit)
+{
+	math::LineSegment segment_local(segment);
+	segment_local.Transform(world_to_local);
+
+	StrawMath::TriangleHit triangle_hit;
+	triangle_hit.distance = hit.distance;
+	triangle_hit.triangle_index = TRIANGLE_HIT_INVALID_INDEX;
+
+	if (!mesh->Intersects(segment_local, triangle_hit))
+	{
+		return false;
+	}
+
+	hit.entity = mesh->Owner();
+	hit.mesh = mesh;
+	hit.distance = triangle_hit.distance;
+	hit.triangle_index = triangle_hit.triangle_index;
+	hit.u = triangle_hit.u;
+	hit.v = triangle_hit.v;
+
+	return true;
+}
+
+/// <summary>
+/// Finds the entities whose bounding box overlaps each of volumes. The
+/// spatial index is walked once for all the volumes, which only tests
+/// their enclosing boxes, and the bounding box tests are split across the
+/// worker pool. Each job fills its own list of hits, which are joined in
+/// order at the end.
+/// </summary>
+template<typename INTERSECTABLE_T>
+void SceneQuery::Overlap(const INTERSECTABLE_T* volumes, size_t volume_count, std::vector<SceneOverlapHit>& hits)
+{
+	hits.clear();
+
+	PrepareScene();
+
+	scene->spatial_index.FillWithBatchIntersections(volumes, volume_count, batch_query_buffer);
+
+	GatherCandidates(volume_count, false);
+
+	const size_t chunk_count = (volume_count + SCENE_QUERY_CHUNK_SIZE - 1) / SCENE_QUERY_CHUNK_SIZE;
+
+	if (chunk_overlap_hits.size() < chunk_count)
+	{
+		chunk_overlap_hits.resize(chunk_count);
+	}
+
+	App->worker_pool->ParallelFor(volume_count, SCENE_QUERY_CHUNK_SIZE, [this, volumes](size_t begin, size_t end)
+	{
+		std::vector<SceneOverlapHit>& chunk_hits = chunk_overlap_hits[begin / SCENE_QUERY_CHUNK_SIZE];
+		chunk_hits.clear();
+
+		for (size_t query_index = begin; query_index < end; ++query_index)
+		{
+			const INTERSECTABLE_T& volume = volumes[query_index];
+
+			for (unsigned int i = static_candidate_offsets[query_index]; i < static_candidate_offsets[query_index + 1]; ++i)
+			{
+				const Candidate& candidate = candidates[static_candidates[i]];
+
+				if (candidate.bounding_box.Intersects(volume))
+				{
+					chunk_hits.push_back({ (unsigned int)query_index, candidate.entity });
+				}
+			}
+
+			// Dynamic entities without a bounding box have nothing to overlap:
+			for (unsigned int candidate_index : dynamic_candidates)
+			{
+				const Candidate& candidate = candidates[candidate_index];
+
+				if (candidate.has_bounding_box && candidate.bounding_box.Intersects(volume))
+				{
+					chunk_hits.push_back({ (unsigned int)query_index, candidate.entity });
+				}
+			}
+		}
+	});
+
+	for (size_t i = 0; i < chunk_count; ++i)
+	{
+		hits.insert(hits.end(), chunk_overlap_hits[i].begin(), chunk_overlap_hits[i].end());
+	}
+}
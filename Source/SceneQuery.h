@@ -0,0 +1,124 @@
+#pragma once
+
+#include "RayQueryBuffer.h"
+#include "BatchQueryBuffer.h"
+#include "PackedTriangles.h"
+
+#include "MATH_GEO_LIB/Geometry/AABB.h"
+#include "MATH_GEO_LIB/Geometry/OBB.h"
+#include "MATH_GEO_LIB/Geometry/LineSegment.h"
+#include "MATH_GEO_LIB/Geometry/Sphere.h"
+#include "MATH_GEO_LIB/Math/float4x4.h"
+
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Number of queries of a batch tested by each job of the worker pool.
+/// </summary>
+#define SCENE_QUERY_CHUNK_SIZE 16
+
+class Scene;
+class Entity;
+class ComponentMesh;
+
+/// <summary>
+/// Closest mesh triangle hit by a ray of a scene query.
+/// </summary>
+struct SceneRaycastHit
+{
+	/// <summary>
+	/// Owner of the mesh that is hit, nullptr if nothing is hit.
+	/// </summary>
+	Entity* entity;
+	ComponentMesh* mesh;
+
+	/// <summary>
+	/// Position of the hit along the ray segment, 0 at its start and 1 at
+	/// its end.
+	/// </summary>
+	float distance;
+
+	/// <summary>
+	/// Index of the triangle of mesh that is hit, and the barycentric
+	/// coordinates of the hit point on it.
+	/// </summary>
+	unsigned int triangle_index;
+	float u;
+	float v;
+};
+
+/// <summary>
+/// Entity whose bounding box overlaps one of the volumes of a scene query.
+/// </summary>
+struct SceneOverlapHit
+{
+	unsigned int query_index;
+	Entity* entity;
+};
+
+/// <summary>
+/// Read only queries over the meshes of a scene. The batched queries take
+/// arrays of rays or volumes, walk the spatial index once for all of them,
+/// and split the narrow phase across the worker pool. Keeps the memory it
+/// uses between calls, so each user should keep its own SceneQuery.
+/// Must be called from the main thread, between scene updates.
+/// </summary>
+class SceneQuery
+{
+private:
+	/// <summary>
+	/// Entity that a query may hit, with everything the workers need to
+	/// test it, gathered in the main thread since bounding boxes and
+	/// transforms refresh themselves lazily when they are accessed.
+	/// </summary>
+	struct Candidate
+	{
+		Entity* entity;
+		math::OBB bounding_box;
+		bool has_bounding_box;
+		unsigned int first_mesh;
+		unsigned int mesh_count;
+	};
+
+	/// <summary>
+	/// Mesh of a candidate, with the matrix that takes the rays to its
+	/// local space.
+	/// </summary>
+	struct CandidateMesh
+	{
+		ComponentMesh* mesh;
+		math::float4x4 world_to_local;
+	};
+
+private:
+	Scene*												scene;
+	StrawMath::RayQueryBuffer							ray_query_buffer;
+	StrawMath::BatchQueryBuffer							batch_query_buffer;
+	std::vector<Candidate>								candidates;
+	std::vector<CandidateMesh>							candidate_meshes;
+	std::unordered_map<const Entity*, unsigned int>		candidate_indices;
+	std::vector<unsigned int>							static_candidates;
+	std::vector<unsigned int>							static_candidate_offsets;
+	std::vector<unsigned int>							dynamic_candidates;
+	std::vector<std::vector<SceneOverlapHit>>			chunk_overlap_hits;
+
+public:
+	explicit SceneQuery(Scene* scene);
+	~SceneQuery();
+
+	bool Raycast(const math::LineSegment& segment, SceneRaycastHit& hit);
+	void Raycast(const math::LineSegment* segments, size_t segment_count, SceneRaycastHit* hits);
+	void OverlapSpheres(const math::Sphere* spheres, size_t sphere_count, std::vector<SceneOverlapHit>& hits);
+	void OverlapBoxes(const math::AABB* boxes, size_t box_count, std::vector<SceneOverlapHit>& hits);
+
+private:
+	void PrepareScene();
+	void GatherCandidates(size_t query_count, bool gather_meshes);
+	unsigned int AddCandidate(Entity* entity, bool gather_meshes);
+	bool IntersectCandidate(const Candidate& candidate, const math::LineSegment& segment, SceneRaycastHit& hit) const;
+	static bool IntersectMesh(ComponentMesh* mesh, const math::float4x4& world_to_local, const math::LineSegment& segment, SceneRaycastHit& hit);
+
+	template<typename INTERSECTABLE_T>
+	void Overlap(const INTERSECTABLE_T* volumes, size_t volume_count, std::vector<SceneOverlapHit>& hits);
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "MATH_GEO_LIB/Math/float3.h"
+#include "MATH_GEO_LIB/Math/float4.h"
+#include "MATH_GEO_LIB/Math/float3x3.h"
+#include "MATH_GEO_LIB/Math/float4x4.h"
+
+#define SHADER_PROGRAM_INVALID_UNIFORM_LOCATION -1
+
+/// <summary>
+/// Location of a uniform in the shader program, typed with the value it
+/// holds so that it can only be set with a value of that type. Setting an
+/// invalid handle does nothing, same as setting a uniform that the shader
+/// compiler has optimized out.
+/// </summary>
+template<typename VALUE_T>
+struct UniformHandle
+{
+	int location = SHADER_PROGRAM_INVALID_UNIFORM_LOCATION;
+
+	bool IsValid() const { return location != SHADER_PROGRAM_INVALID_UNIFORM_LOCATION; }
+};
+
+/// <summary>
+/// Handles of the uniforms the engine sets per material, resolved once by
+/// ModuleShaderProgram after the program is linked. Camera and light 
+/// values are in the uniform blocks instead, see UniformBlocks.h, and the
+/// model and normal matrices are per instance attributes, see RenderQueue.h.
+/// </summary>
+struct ShaderUniforms
+{
+	UniformHandle<int> material_diffuse;
+	UniformHandle<int> material_specular;
+	UniformHandle<int> material_occlusion;
+	UniformHandle<float> material_shininess;
+};
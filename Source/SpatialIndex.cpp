@@ -0,0 +1,125 @@
+#include "SpatialIndex.h"
+
+namespace StrawMath
+{
+	SpatialIndex::SpatialIndex() : type(spatial_index_type::QUADTREE)
+	{
+
+	}
+
+	SpatialIndex::~SpatialIndex()
+	{
+
+	}
+
+	spatial_index_type SpatialIndex::GetType() const
+	{
+		return type;
+	}
+
+	/// <summary>
+	/// Switches to the structure of new_type. The index is cleaned up and
+	/// needs to be filled again.
+	/// </summary>
+	void SpatialIndex::SetType(spatial_index_type new_type)
+	{
+		CleanUp();
+
+		type = new_type;
+	}
+
+	void SpatialIndex::SetContainer(const math::AABB& new_container)
+	{
+		switch (type)
+		{
+			case spatial_index_type::QUADTREE:
+				quad_tree.SetContainer(new_container);
+				break;
+			case spatial_index_type::LOOSE_OCTREE:
+				loose_octree.SetContainer(new_container);
+				break;
+			case spatial_index_type::AABB_TREE:
+				aabb_tree.SetContainer(new_container);
+				break;
+		}
+	}
+
+	/// <returns>False if entity is outside the container of the index.</returns>
+	bool SpatialIndex::Insert(Entity* const entity)
+	{
+		switch (type)
+		{
+			case spatial_index_type::QUADTREE:
+				return quad_tree.Insert(entity);
+			case spatial_index_type::LOOSE_OCTREE:
+				return loose_octree.Insert(entity);
+			case spatial_index_type::AABB_TREE:
+				return aabb_tree.Insert(entity);
+			default:
+				return false;
+		}
+	}
+
+	void SpatialIndex::Remove(Entity* const entity)
+	{
+		switch (type)
+		{
+			case spatial_index_type::QUADTREE:
+				quad_tree.Remove(entity);
+				break;
+			case spatial_index_type::LOOSE_OCTREE:
+				loose_octree.Remove(entity);
+				break;
+			case spatial_index_type::AABB_TREE:
+				aabb_tree.Remove(entity);
+				break;
+		}
+	}
+
+	/// <returns>False if entity has moved outside the container of the index.</returns>
+	bool SpatialIndex::Update(Entity* const entity)
+	{
+		switch (type)
+		{
+			case spatial_index_type::QUADTREE:
+				return quad_tree.Update(entity);
+			case spatial_index_type::LOOSE_OCTREE:
+				return loose_octree.Update(entity);
+			case spatial_index_type::AABB_TREE:
+				return aabb_tree.Update(entity);
+			default:
+				return false;
+		}
+	}
+
+	bool SpatialIndex::Contains(const Entity* entity) const
+	{
+		switch (type)
+		{
+			case spatial_index_type::QUADTREE:
+				return quad_tree.Contains(entity);
+			case spatial_index_type::LOOSE_OCTREE:
+				return loose_octree.Contains(entity);
+			case spatial_index_type::AABB_TREE:
+				return aabb_tree.Contains(entity);
+			default:
+				return false;
+		}
+	}
+
+	void SpatialIndex::CleanUp()
+	{
+		switch (type)
+		{
+			case spatial_index_type::QUADTREE:
+				quad_tree.CleanUp();
+				break;
+			case spatial_index_type::LOOSE_OCTREE:
+				loose_octree.CleanUp();
+				break;
+			case spatial_index_type::AABB_TREE:
+				aabb_tree.CleanUp();
+				break;
+		}
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "SpatialIndexType.h"
+#include "QuadTree.h"
+#include "LooseOctree.h"
+#include "AABBTree.h"
+
+namespace StrawMath
+{
+	/// <summary>
+	/// Spatial index whose underlying structure can be picked at runtime.
+	/// Every structure has the same interface, including the templated
+	/// FillWithIntersections queries, and calls are forwarded to the one
+	/// that is currently in use.
+	/// </summary>
+	class SpatialIndex
+	{
+	private:
+		spatial_index_type type;
+		QuadTree quad_tree;
+		LooseOctree loose_octree;
+		AABBTree aabb_tree;
+
+	public:
+		SpatialIndex();
+		~SpatialIndex();
+
+		spatial_index_type GetType() const;
+		void SetType(spatial_index_type new_type);
+
+		void SetContainer(const math::AABB& new_container);
+		bool Insert(Entity* const entity);
+		void Remove(Entity* const entity);
+		bool Update(Entity* const entity);
+		bool Contains(const Entity* entity) const;
+		void CleanUp();
+
+		template<typename INTERSECTABLE_T>
+		void FillWithIntersections(std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const;
+		template<typename INTERSECTABLE_T, typename CANDIDATE_FUNCTION_T>
+		void RaycastNearestFirst(const INTERSECTABLE_T& intersectable, float max_distance, RayQueryBuffer& buffer, const CANDIDATE_FUNCTION_T& test_candidate) const;
+		template<typename INTERSECTABLE_T>
+		void FillWithBatchIntersections(const INTERSECTABLE_T* intersectables, size_t count, BatchQueryBuffer& buffer) const;
+	};
+
+	template<typename INTERSECTABLE_T>
+	inline void SpatialIndex::FillWithIntersections(std::vector<Entity*>& intersecting_entities, const INTERSECTABLE_T& intersectable) const
+	{
+		switch (type)
+		{
+			case spatial_index_type::QUADTREE:
+				quad_tree.FillWithIntersections(intersecting_entities, intersectable);
+				break;
+			case spatial_index_type::LOOSE_OCTREE:
+				loose_octree.FillWithIntersections(intersecting_entities, intersectable);
+				break;
+			case spatial_index_type::AABB_TREE:
+				aabb_tree.FillWithIntersections(intersecting_entities, intersectable);
+				break;
+		}
+	}
+
+	/// <summary>
+	/// Walks the structure nearest first along intersectable, which can be
+	/// anything with Intersects(AABB, near, far) such as a line segment. Nodes
+	/// and entities are visited in the order intersectable enters their
+	/// bounds, and test_candidate is called for each entity with its entry
+	/// distance at most max_distance. test_candidate may lower max_distance
+	/// once it finds a hit, and the walk stops when nothing left is nearer.
+	/// An entity may be passed to test_candidate more than once if the
+	/// structure keeps it in more than one node.
+	/// </summary>
+	/// <param name="buffer">Buffer reused between queries to sort the nodes and entities.</param>
+	/// <param name="test_candidate">Called as test_candidate(entity, max_distance).</param>
+	template<typename INTERSECTABLE_T, typename CANDIDATE_FUNCTION_T>
+	inline void SpatialIndex::RaycastNearestFirst(const INTERSECTABLE_T& intersectable, float max_distance, RayQueryBuffer& buffer, const CANDIDATE_FUNCTION_T& test_candidate) const
+	{
+		switch (type)
+		{
+			case spatial_index_type::QUADTREE:
+				quad_tree.RaycastNearestFirst(intersectable, max_distance, buffer, test_candidate);
+				break;
+			case spatial_index_type::LOOSE_OCTREE:
+				loose_octree.RaycastNearestFirst(intersectable, max_distance, buffer, test_candidate);
+				break;
+			case spatial_index_type::AABB_TREE:
+				aabb_tree.RaycastNearestFirst(intersectable, max_distance, buffer, test_candidate);
+				break;
+		}
+	}
+
+	/// <summary>
+	/// Finds the entities whose bounds intersect each of intersectables in a
+	/// single walk of the structure. Each node only tests the queries that
+	/// have intersected its parent, kept in buffer by ActivateIntersecting,
+	/// and is skipped once none is left. An entity may be found more than
+	/// once by the same query if the structure keeps it in more than one node.
+	/// </summary>
+	/// <param name="buffer">Buffer reused between batches, its hits are filled with the query index and entity of each intersection.</param>
+	template<typename INTERSECTABLE_T>
+	inline void SpatialIndex::FillWithBatchIntersections(const INTERSECTABLE_T* intersectables, size_t count, BatchQueryBuffer& buffer) const
+	{
+		switch (type)
+		{
+			case spatial_index_type::QUADTREE:
+				quad_tree.FillWithBatchIntersections(intersectables, count, buffer);
+				break;
+			case spatial_index_type::LOOSE_OCTREE:
+				loose_octree.FillWithBatchIntersections(intersectables, count, buffer);
+				break;
+			case spatial_index_type::AABB_TREE:
+				aabb_tree.FillWithBatchIntersections(intersectables, count, buffer);
+				break;
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+enum class spatial_index_type
+{
+	QUADTREE,
+	LOOSE_OCTREE,
+	AABB_TREE,
+};
+
+inline const char* spatial_index_type_to_string(spatial_index_type type)
+{
+	switch (type)
+	{
+		case spatial_index_type::QUADTREE:
+		{
+			return "QuadTree";
+		}
+
+		case spatial_index_type::LOOSE_OCTREE:
+		{
+			return "Loose Octree";
+		}
+
+		case spatial_index_type::AABB_TREE:
+		{
+			return "AABB Tree";
+		}
+
+		default:
+		{
+			return "Refer to SpatialIndexType.h and add this type to the function.";
+		}
+	}
+}
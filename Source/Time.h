@@ -82,11 +82,12 @@ private:
 	unsigned int current_frame;
 	float frame_times_ms[TIMER_BUFFER_LENGTH];
 	float delta_time_ms;
+	float total_time_ms;
 	float fps;
 	NormalTimer timer;
 
 public:
-	TimeManager() : current_index(-1), current_frame(0), delta_time_ms(0.0f), fps(0.0f), timer()
+	TimeManager() : current_index(-1), current_frame(0), delta_time_ms(0.0f), total_time_ms(0.0f), fps(0.0f), timer()
 	{
 		std::fill_n(frame_times_ms, TIMER_BUFFER_LENGTH, 0.0f);
 	};
@@ -114,6 +115,8 @@ public:
 		current_index = (current_index + 1) % TIMER_BUFFER_LENGTH;
 
 		frame_times_ms[current_index] = delta_time_ms;
+
+		total_time_ms += delta_time_ms;
 		
 		++current_frame;
 
@@ -135,6 +138,11 @@ public:
 		return delta_time_ms;
 	};
 
+	float TotalTime() const
+	{
+		return total_time_ms * DIVIDE_BY_THOUSAND;
+	};
+
 private:
 	float CalculateFPS()
 	{
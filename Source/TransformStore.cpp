@@ -0,0 +1,422 @@
+#include "TransformStore.h"
+
+namespace
+{
+	/// <summary>
+	/// Reorders values so that the value at order[i] ends up at i.
+	/// </summary>
+	template<typename T>
+	void TransformStore_Permute(std::vector<T>& values, const std::vector<unsigned int>& order)
+	{
+		std::vector<T> permuted_values;
+		permuted_values.reserve(order.size());
+
+		for (unsigned int slot : order)
+		{
+			permuted_values.push_back(values[slot]);
+		}
+
+		values.swap(permuted_values);
+	}
+}
+
+TransformStore::TransformStore() :
+	current_stamp(0),
+	is_order_dirty(false),
+	has_pending_changes(false)
+{
+}
+
+TransformStore::~TransformStore()
+{
+}
+
+unsigned int TransformStore::Create()
+{
+	unsigned int handle;
+
+	if (free_handles.size() > 0)
+	{
+		handle = free_handles.back();
+		free_handles.pop_back();
+	}
+	else
+	{
+		handle = (unsigned int)slots_of_handles.size();
+		slots_of_handles.push_back(TRANSFORM_STORE_INVALID_HANDLE);
+	}
+
+	// New transforms are roots, so appending them to the end
+	// doesn't break the parent before child order:
+	slots_of_handles[handle] = (unsigned int)handles_of_slots.size();
+
+	local_positions.push_back(math::float3::zero);
+	local_rotations.push_back(math::Quat::identity);
+	local_scales.push_back(math::float3::one);
+	world_matrices.push_back(math::float4x4::identity);
+	world_stamps.push_back(++current_stamp);
+	parent_stamps.push_back(0);
+	parent_handles.push_back(TRANSFORM_STORE_INVALID_HANDLE);
+	parent_slots.push_back(TRANSFORM_STORE_INVALID_HANDLE);
+	handles_of_slots.push_back(handle);
+	local_dirty_flags.push_back(0);
+
+	return handle;
+}
+
+void TransformStore::Destroy(unsigned int handle)
+{
+	const unsigned int slot = slots_of_handles[handle];
+	const unsigned int last_slot = (unsigned int)handles_of_slots.size() - 1;
+
+	// Fill the gap with the last slot:
+	if (slot != last_slot)
+	{
+		MoveSlot(last_slot, slot);
+	}
+
+	PopSlot();
+
+	slots_of_handles[handle] = TRANSFORM_STORE_INVALID_HANDLE;
+
+	// NOTE: The handle is not reused until the next order rebuild,
+	// children that still refer to it are turned into roots there:
+	pending_free_handles.push_back(handle);
+
+	is_order_dirty = true;
+	has_pending_changes = true;
+}
+
+void TransformStore::SetParent(unsigned int handle, unsigned int parent_handle)
+{
+	// Copy the world matrix as the reference may be invalidated
+	// while resolving the parent:
+	const math::float4x4 world_matrix = GetWorldMatrix(handle);
+
+	math::float4x4 local_matrix = world_matrix;
+
+	if (parent_handle != TRANSFORM_STORE_INVALID_HANDLE)
+	{
+		local_matrix = GetWorldMatrix(parent_handle).Inverted() * world_matrix;
+	}
+
+	const unsigned int slot = slots_of_handles[handle];
+
+	local_matrix.Decompose(local_positions[slot], local_rotations[slot], local_scales[slot]);
+
+	parent_handles[slot] = parent_handle;
+	local_dirty_flags[slot] = 1;
+
+	is_order_dirty = true;
+	has_pending_changes = true;
+}
+
+void TransformStore::SetLocal(unsigned int handle, const math::float3& position, const math::Quat& rotation, const math::float3& scale)
+{
+	const unsigned int slot = slots_of_handles[handle];
+
+	local_positions[slot] = position;
+	local_rotations[slot] = rotation;
+	local_scales[slot] = scale;
+	local_dirty_flags[slot] = 1;
+
+	has_pending_changes = true;
+}
+
+void TransformStore::SetWorld(unsigned int handle, const math::float3& position, const math::Quat& rotation, const math::float3& scale)
+{
+	const unsigned int slot = slots_of_handles[handle];
+	const unsigned int parent_slot = GetParentSlot(slot);
+
+	// If there is no parent, world values are the local values:
+	if (parent_slot == TRANSFORM_STORE_INVALID_HANDLE)
+	{
+		SetLocal(handle, position, rotation, scale);
+
+		return;
+	}
+
+	ResolveWorldMatrix(parent_slot);
+
+	math::float4x4 local_matrix =
+		world_matrices[parent_slot].Inverted() * math::float4x4::FromTRS(position, rotation, scale);
+
+	local_matrix.Decompose(local_positions[slot], local_rotations[slot], local_scales[slot]);
+	local_dirty_flags[slot] = 1;
+
+	has_pending_changes = true;
+}
+
+const math::float3& TransformStore::GetLocalPosition(unsigned int handle) const
+{
+	return local_positions[slots_of_handles[handle]];
+}
+
+const math::Quat& TransformStore::GetLocalRotation(unsigned int handle) const
+{
+	return local_rotations[slots_of_handles[handle]];
+}
+
+const math::float3& TransformStore::GetLocalScale(unsigned int handle) const
+{
+	return local_scales[slots_of_handles[handle]];
+}
+
+math::float4x4 TransformStore::GetLocalMatrix(unsigned int handle) const
+{
+	const unsigned int slot = slots_of_handles[handle];
+
+	return math::float4x4::FromTRS(local_positions[slot], local_rotations[slot], local_scales[slot]);
+}
+
+const math::float4x4& TransformStore::GetWorldMatrix(unsigned int handle)
+{
+	const unsigned int slot = slots_of_handles[handle];
+
+	ResolveWorldMatrix(slot);
+
+	return world_matrices[slot];
+}
+
+unsigned long long TransformStore::GetWorldStamp(unsigned int handle)
+{
+	const unsigned int slot = slots_of_handles[handle];
+
+	ResolveWorldMatrix(slot);
+
+	return world_stamps[slot];
+}
+
+void TransformStore::UpdateWorldMatrices()
+{
+	if (!has_pending_changes && !is_order_dirty)
+	{
+		return;
+	}
+
+	if (is_order_dirty)
+	{
+		RebuildOrder();
+	}
+
+	const unsigned int size = (unsigned int)handles_of_slots.size();
+
+	// As parents always come before their children, by the time a slot
+	// is visited its parent is already up to date:
+	for (unsigned int slot = 0; slot < size; ++slot)
+	{
+		const unsigned int parent_slot = parent_slots[slot];
+
+		if (IsStale(slot, parent_slot))
+		{
+			RecalculateWorldMatrix(slot, parent_slot);
+		}
+	}
+
+	has_pending_changes = false;
+}
+
+size_t TransformStore::Size() const
+{
+	return handles_of_slots.size();
+}
+
+void TransformStore::RebuildOrder()
+{
+	const unsigned int size = (unsigned int)handles_of_slots.size();
+
+	// Children of destroyed transforms become roots:
+	for (unsigned int slot = 0; slot < size; ++slot)
+	{
+		const unsigned int parent_handle = parent_handles[slot];
+
+		if (parent_handle != TRANSFORM_STORE_INVALID_HANDLE &&
+			slots_of_handles[parent_handle] == TRANSFORM_STORE_INVALID_HANDLE)
+		{
+			parent_handles[slot] = TRANSFORM_STORE_INVALID_HANDLE;
+			local_dirty_flags[slot] = 1;
+		}
+	}
+
+	// No slot refers to destroyed handles anymore, so they are safe
+	// to be reused:
+	free_handles.insert(free_handles.end(), pending_free_handles.begin(), pending_free_handles.end());
+	pending_free_handles.clear();
+
+	// Calculate the depth of each slot:
+	std::vector<unsigned int> depths(size, TRANSFORM_STORE_INVALID_HANDLE);
+	std::vector<unsigned int> chain;
+	unsigned int max_depth = 0;
+
+	for (unsigned int slot = 0; slot < size; ++slot)
+	{
+		// Walk up until a slot with known depth or a root is found:
+		unsigned int current_slot = slot;
+
+		while (current_slot != TRANSFORM_STORE_INVALID_HANDLE &&
+			depths[current_slot] == TRANSFORM_STORE_INVALID_HANDLE)
+		{
+			chain.push_back(current_slot);
+			current_slot = GetParentSlot(current_slot);
+		}
+
+		unsigned int depth = current_slot == TRANSFORM_STORE_INVALID_HANDLE ? 0 : depths[current_slot] + 1;
+
+		// Assign depths on the way back down:
+		for (size_t i = chain.size(); i > 0; --i)
+		{
+			depths[chain[i - 1]] = depth++;
+		}
+
+		chain.clear();
+
+		max_depth = depths[slot] > max_depth ? depths[slot] : max_depth;
+	}
+
+	// Stable counting sort of the slots by depth:
+	std::vector<unsigned int> offsets(max_depth + 2, 0);
+
+	for (unsigned int slot = 0; slot < size; ++slot)
+	{
+		++offsets[depths[slot] + 1];
+	}
+
+	for (size_t i = 1; i < offsets.size(); ++i)
+	{
+		offsets[i] += offsets[i - 1];
+	}
+
+	std::vector<unsigned int> order(size);
+
+	for (unsigned int slot = 0; slot < size; ++slot)
+	{
+		order[offsets[depths[slot]]++] = slot;
+	}
+
+	TransformStore_Permute(local_positions, order);
+	TransformStore_Permute(local_rotations, order);
+	TransformStore_Permute(local_scales, order);
+	TransformStore_Permute(world_matrices, order);
+	TransformStore_Permute(world_stamps, order);
+	TransformStore_Permute(parent_stamps, order);
+	TransformStore_Permute(parent_handles, order);
+	TransformStore_Permute(handles_of_slots, order);
+	TransformStore_Permute(local_dirty_flags, order);
+
+	for (unsigned int slot = 0; slot < size; ++slot)
+	{
+		slots_of_handles[handles_of_slots[slot]] = slot;
+	}
+
+	for (unsigned int slot = 0; slot < size; ++slot)
+	{
+		parent_slots[slot] = GetParentSlot(slot);
+	}
+
+	is_order_dirty = false;
+}
+
+void TransformStore::ResolveWorldMatrix(unsigned int slot)
+{
+	// If nothing has changed since the last pass, every
+	// world matrix is already up to date:
+	if (!has_pending_changes)
+	{
+		return;
+	}
+
+	// Walk up to the root, as a stale ancestor makes every slot below it
+	// stale as well:
+	resolve_chain.clear();
+
+	for (unsigned int current_slot = slot; current_slot != TRANSFORM_STORE_INVALID_HANDLE; current_slot = GetParentSlot(current_slot))
+	{
+		resolve_chain.push_back(current_slot);
+	}
+
+	// Resolve on the way back down, so that each parent is up to date
+	// before its child is checked:
+	for (size_t i = resolve_chain.size(); i > 0; --i)
+	{
+		const unsigned int current_slot = resolve_chain[i - 1];
+		const unsigned int parent_slot = i < resolve_chain.size() ? resolve_chain[i] : TRANSFORM_STORE_INVALID_HANDLE;
+
+		if (IsStale(current_slot, parent_slot))
+		{
+			RecalculateWorldMatrix(current_slot, parent_slot);
+		}
+	}
+}
+
+bool TransformStore::IsStale(unsigned int slot, unsigned int parent_slot) const
+{
+	if (local_dirty_flags[slot] != 0)
+	{
+		return true;
+	}
+
+	// Roots are calculated with a parent stamp of 0:
+	const unsigned long long expected_parent_stamp =
+		parent_slot == TRANSFORM_STORE_INVALID_HANDLE ? 0 : world_stamps[parent_slot];
+
+	return parent_stamps[slot] != expected_parent_stamp;
+}
+
+void TransformStore::RecalculateWorldMatrix(unsigned int slot, unsigned int parent_slot)
+{
+	const math::float4x4 local_matrix =
+		math::float4x4::FromTRS(local_positions[slot], local_rotations[slot], local_scales[slot]);
+
+	if (parent_slot == TRANSFORM_STORE_INVALID_HANDLE)
+	{
+		world_matrices[slot] = local_matrix;
+		parent_stamps[slot] = 0;
+	}
+	else
+	{
+		world_matrices[slot] = world_matrices[parent_slot] * local_matrix;
+		parent_stamps[slot] = world_stamps[parent_slot];
+	}
+
+	world_stamps[slot] = ++current_stamp;
+	local_dirty_flags[slot] = 0;
+}
+
+unsigned int TransformStore::GetParentSlot(unsigned int slot) const
+{
+	const unsigned int parent_handle = parent_handles[slot];
+
+	return parent_handle == TRANSFORM_STORE_INVALID_HANDLE ?
+		TRANSFORM_STORE_INVALID_HANDLE :
+		slots_of_handles[parent_handle];
+}
+
+void TransformStore::MoveSlot(unsigned int from, unsigned int to)
+{
+	local_positions[to] = local_positions[from];
+	local_rotations[to] = local_rotations[from];
+	local_scales[to] = local_scales[from];
+	world_matrices[to] = world_matrices[from];
+	world_stamps[to] = world_stamps[from];
+	parent_stamps[to] = parent_stamps[from];
+	parent_handles[to] = parent_handles[from];
+	parent_slots[to] = parent_slots[from];
+	handles_of_slots[to] = handles_of_slots[from];
+	local_dirty_flags[to] = local_dirty_flags[from];
+
+	slots_of_handles[handles_of_slots[to]] = to;
+}
+
+void TransformStore::PopSlot()
+{
+	local_positions.pop_back();
+	local_rotations.pop_back();
+	local_scales.pop_back();
+	world_matrices.pop_back();
+	world_stamps.pop_back();
+	parent_stamps.pop_back();
+	parent_handles.pop_back();
+	parent_slots.pop_back();
+	handles_of_slots.pop_back();
+	local_dirty_flags.pop_back();
+}
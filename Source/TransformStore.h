@@ -0,0 +1,200 @@
+#pragma once
+
+#include "MATH_GEO_LIB/Math/float3.h"
+#include "MATH_GEO_LIB/Math/Quat.h"
+#include "MATH_GEO_LIB/Math/float4x4.h"
+
+#include <vector>
+
+#define TRANSFORM_STORE_INVALID_HANDLE 0xFFFFFFFF
+
+/// <summary>
+/// Contiguous storage for the transform data of every ComponentTransform.
+/// Local TRS values and world matrices are kept in parallel arrays that are
+/// ordered so that a parent always comes before its children. This lets
+/// UpdateWorldMatrices recompute the whole hierarchy with a single linear
+/// pass, while GetWorldMatrix can still resolve a single transform lazily
+/// in between passes.
+/// Transforms are referred to by handles that stay valid until Destroy is
+/// called, the slots they point to may move when the order is rebuilt.
+/// </summary>
+class TransformStore
+{
+private:
+	/// <summary>
+	/// Local position of each slot.
+	/// </summary>
+	std::vector<math::float3> local_positions;
+
+	/// <summary>
+	/// Local rotation of each slot.
+	/// </summary>
+	std::vector<math::Quat> local_rotations;
+
+	/// <summary>
+	/// Local scale of each slot.
+	/// </summary>
+	std::vector<math::float3> local_scales;
+
+	/// <summary>
+	/// Cached world matrix of each slot. Only valid if the slot is not
+	/// stale, see IsStale.
+	/// </summary>
+	std::vector<math::float4x4> world_matrices;
+
+	/// <summary>
+	/// Stamp given to the world matrix of each slot when it was last
+	/// recalculated. Stamps are unique, so a changed stamp means the
+	/// matrix has changed.
+	/// </summary>
+	std::vector<unsigned long long> world_stamps;
+
+	/// <summary>
+	/// Stamp of the parent's world matrix that was used to calculate
+	/// the world matrix of each slot.
+	/// </summary>
+	std::vector<unsigned long long> parent_stamps;
+
+	/// <summary>
+	/// Handle of the parent of each slot, TRANSFORM_STORE_INVALID_HANDLE
+	/// if the slot is a root.
+	/// </summary>
+	std::vector<unsigned int> parent_handles;
+
+	/// <summary>
+	/// Slot of the parent of each slot. Only valid while is_order_dirty
+	/// is false.
+	/// </summary>
+	std::vector<unsigned int> parent_slots;
+
+	/// <summary>
+	/// Handle that owns each slot.
+	/// </summary>
+	std::vector<unsigned int> handles_of_slots;
+
+	/// <summary>
+	/// Set to 1 if the local values of a slot has changed since its
+	/// world matrix was calculated.
+	/// </summary>
+	std::vector<unsigned char> local_dirty_flags;
+
+	/// <summary>
+	/// Maps handles to slots. Destroyed handles map to
+	/// TRANSFORM_STORE_INVALID_HANDLE.
+	/// </summary>
+	std::vector<unsigned int> slots_of_handles;
+
+	/// <summary>
+	/// Handles that can be given out again by Create.
+	/// </summary>
+	std::vector<unsigned int> free_handles;
+
+	/// <summary>
+	/// Handles that were destroyed since the last order rebuild. They are
+	/// not reused until then, so that children still pointing to them are
+	/// not confused with a new transform.
+	/// </summary>
+	std::vector<unsigned int> pending_free_handles;
+
+	/// <summary>
+	/// Slots from the one being resolved up to its root, reused by
+	/// ResolveWorldMatrix to avoid allocating on every call.
+	/// </summary>
+	std::vector<unsigned int> resolve_chain;
+
+	/// <summary>
+	/// Source of the world stamps.
+	/// </summary>
+	unsigned long long current_stamp;
+
+	/// <summary>
+	/// True if slots are not in parent before child order anymore.
+	/// </summary>
+	bool is_order_dirty;
+
+	/// <summary>
+	/// True if anything has changed since the last UpdateWorldMatrices.
+	/// </summary>
+	bool has_pending_changes;
+
+public:
+	TransformStore();
+	~TransformStore();
+
+	/// <summary>
+	/// Creates an identity root transform.
+	/// </summary>
+	/// <returns>Handle of the created transform.</returns>
+	unsigned int Create();
+
+	/// <summary>
+	/// Destroys the transform with the given handle. Children of it are
+	/// treated as roots until they are given a new parent.
+	/// </summary>
+	/// <param name="handle">Handle of the transform to be destroyed.</param>
+	void Destroy(unsigned int handle);
+
+	/// <summary>
+	/// Sets the parent of the transform while keeping its world matrix
+	/// the same, local values are recalculated relative to the new parent.
+	/// </summary>
+	/// <param name="handle">Handle of the transform.</param>
+	/// <param name="parent_handle">Handle of the new parent, TRANSFORM_STORE_INVALID_HANDLE for none.</param>
+	void SetParent(unsigned int handle, unsigned int parent_handle);
+
+	/// <summary>
+	/// Sets all the local values of the transform at once.
+	/// </summary>
+	void SetLocal(unsigned int handle, const math::float3& position, const math::Quat& rotation, const math::float3& scale);
+
+	/// <summary>
+	/// Sets the local values of the transform so that its world matrix
+	/// is made of the given position, rotation and scale.
+	/// </summary>
+	void SetWorld(unsigned int handle, const math::float3& position, const math::Quat& rotation, const math::float3& scale);
+
+	const math::float3& GetLocalPosition(unsigned int handle) const;
+	const math::Quat& GetLocalRotation(unsigned int handle) const;
+	const math::float3& GetLocalScale(unsigned int handle) const;
+
+	/// <returns>
+	/// Local matrix built from the local values of the transform.
+	/// </returns>
+	math::float4x4 GetLocalMatrix(unsigned int handle) const;
+
+	/// <summary>
+	/// Returns the world matrix of the transform, recalculating it and
+	/// its stale ancestors if needed. The reference is invalidated by
+	/// any call that creates, destroys or reparents transforms.
+	/// </summary>
+	/// <returns>World matrix of the transform.</returns>
+	const math::float4x4& GetWorldMatrix(unsigned int handle);
+
+	/// <summary>
+	/// Returns the stamp of the world matrix of the transform, after
+	/// resolving it. Callers can cache values derived from the world
+	/// matrix and compare stamps to see if they need to refresh them.
+	/// </summary>
+	/// <returns>World stamp of the transform.</returns>
+	unsigned long long GetWorldStamp(unsigned int handle);
+
+	/// <summary>
+	/// Recalculates the world matrices of every stale transform in one
+	/// pass over the slots. Called once per frame.
+	/// </summary>
+	void UpdateWorldMatrices();
+
+	/// <returns>
+	/// Number of transforms in this store.
+	/// </returns>
+	size_t Size() const;
+
+private:
+	void RebuildOrder();
+	void ResolveWorldMatrix(unsigned int slot);
+	bool IsStale(unsigned int slot, unsigned int parent_slot) const;
+	void RecalculateWorldMatrix(unsigned int slot, unsigned int parent_slot);
+	unsigned int GetParentSlot(unsigned int slot) const;
+	void MoveSlot(unsigned int from, unsigned int to);
+	void PopSlot();
+};
@@ -0,0 +1,419 @@
+#include "TriangleBVH.h"
+
+#include "MATH_GEO_LIB/Math/MathFunc.h"
+
+#include <cfloat>
+
+namespace StrawMath
+{
+	/// <summary>
+	/// Slab test of the line a + t * (b - a) against bounding_box.
+	/// </summary>
+	/// <returns>Entry distance if the box is hit before max_distance, FLT_MAX otherwise.</returns>
+	static float IntersectBox(const math::AABB& bounding_box, const math::float3& origin, const math::float3& inverse_direction, float max_distance)
+	{
+		float t_x_1 = (bounding_box.minPoint.x - origin.x) * inverse_direction.x;
+		float t_x_2 = (bounding_box.maxPoint.x - origin.x) * inverse_direction.x;
+		float t_y_1 = (bounding_box.minPoint.y - origin.y) * inverse_direction.y;
+		float t_y_2 = (bounding_box.maxPoint.y - origin.y) * inverse_direction.y;
+		float t_z_1 = (bounding_box.minPoint.z - origin.z) * inverse_direction.z;
+		float t_z_2 = (bounding_box.maxPoint.z - origin.z) * inverse_direction.z;
+
+		float t_near = math::Max(math::Min(t_x_1, t_x_2), math::Min(t_y_1, t_y_2), math::Min(t_z_1, t_z_2));
+		float t_far = math::Min(math::Max(t_x_1, t_x_2), math::Max(t_y_1, t_y_2), math::Max(t_z_1, t_z_2));
+
+		if (t_far < t_near || t_far < 0.0f || t_near > max_distance)
+		{
+			return FLT_MAX;
+		}
+
+		return t_near;
+	}
+
+	/// <returns>Surface area of bounding_box, 0 if it's empty.</returns>
+	static float SurfaceArea(const math::AABB& bounding_box)
+	{
+		math::float3 size = bounding_box.maxPoint - bounding_box.minPoint;
+
+		if (size.x < 0.0f || size.y < 0.0f || size.z < 0.0f)
+		{
+			return 0.0f;
+		}
+
+		return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	TriangleBVH::TriangleBVH()
+	{
+
+	}
+
+	TriangleBVH::~TriangleBVH()
+	{
+
+	}
+
+	/// <summary>
+	/// Builds the tree over triangles, replacing the previous one. Nodes are
+	/// split at the bin boundary with the lowest surface area heuristic cost,
+	/// and become leaves when no split is cheaper than testing all of their
+	/// triangles.
+	/// </summary>
+	void TriangleBVH::Build(const math::TriangleArray& triangles)
+	{
+		CleanUp();
+
+		if (triangles.empty())
+		{
+			return;
+		}
+
+		const unsigned int triangle_count = (unsigned int)triangles.size();
+
+		std::vector<math::AABB> triangle_boxes(triangle_count);
+		std::vector<math::float3> centroids(triangle_count);
+
+		triangle_indices.resize(triangle_count);
+
+		for (unsigned int i = 0; i < triangle_count; ++i)
+		{
+			triangle_boxes[i] = triangles[i].BoundingAABB();
+			centroids[i] = triangles[i].Centroid();
+			triangle_indices[i] = i;
+		}
+
+		// A binary tree with n leaves has 2n - 1 nodes:
+		nodes.reserve(2 * triangle_count - 1);
+		nodes.emplace_back();
+
+		TriangleBVHNode& root = nodes.back();
+		root.left_first = 0;
+		root.triangle_count = triangle_count;
+
+		Subdivide(0, 0, triangle_boxes, centroids);
+
+		nodes.shrink_to_fit();
+
+		PackTriangles(triangles);
+	}
+
+	void TriangleBVH::CleanUp()
+	{
+		nodes.clear();
+		packed_triangles.Clear();
+		triangle_indices.clear();
+	}
+
+	bool TriangleBVH::IsEmpty() const
+	{
+		return nodes.empty();
+	}
+
+	size_t TriangleBVH::GetNodeCount() const
+	{
+		return nodes.size();
+	}
+
+	/// <summary>
+	/// Finds the closest triangle segment hits, closer than hit.distance.
+	/// Children are visited nearest first, and nodes that start after the
+	/// closest hit so far are skipped.
+	/// </summary>
+	/// <param name="segment">Segment to test, in the space of the triangles this tree was built with.</param>
+	/// <param name="hit">Closest hit, only changed if a closer one is found. Set its distance to 1 or more to accept any hit. Its triangle_index is the index of the triangle passed to Build.</param>
+	/// <returns>True if a hit closer than hit.distance is found.</returns>
+	bool TriangleBVH::Intersects(const math::LineSegment& segment, TriangleHit& hit) const
+	{
+		if (nodes.empty())
+		{
+			return false;
+		}
+
+		const math::float3 origin = segment.a;
+		const math::float3 direction = segment.b - segment.a;
+		const math::float3 inverse_direction(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+		// Hits must be on the segment:
+		float best_distance = math::Min(hit.distance, 1.0f);
+		bool is_hit = false;
+
+		if (IntersectBox(nodes[0].bounding_box, origin, inverse_direction, best_distance) == FLT_MAX)
+		{
+			return false;
+		}
+
+		// Depth of the tree is limited, so the stack can't overflow:
+		unsigned int stack[TRIANGLE_BVH_MAX_DEPTH];
+		float stack_distances[TRIANGLE_BVH_MAX_DEPTH];
+		unsigned int stack_size = 0;
+
+		unsigned int node_index = 0;
+
+		while (true)
+		{
+			const TriangleBVHNode& node = nodes[node_index];
+
+			if (node.IsLeaf())
+			{
+				// Padding is never hit, so whole packets can be tested:
+				const unsigned int packed_count = (node.triangle_count + PACKED_TRIANGLES_LANE_COUNT - 1) / PACKED_TRIANGLES_LANE_COUNT * PACKED_TRIANGLES_LANE_COUNT;
+
+				if (IntersectPackedTriangles(packed_triangles, node.left_first, node.left_first + packed_count, segment, hit))
+				{
+					best_distance = hit.distance;
+					is_hit = true;
+				}
+			}
+			else
+			{
+				unsigned int near_child = node.left_first;
+				unsigned int far_child = node.left_first + 1;
+
+				float near_distance = IntersectBox(nodes[near_child].bounding_box, origin, inverse_direction, best_distance);
+				float far_distance = IntersectBox(nodes[far_child].bounding_box, origin, inverse_direction, best_distance);
+
+				if (far_distance < near_distance)
+				{
+					unsigned int temp_child = near_child;
+					near_child = far_child;
+					far_child = temp_child;
+
+					float temp_distance = near_distance;
+					near_distance = far_distance;
+					far_distance = temp_distance;
+				}
+
+				if (near_distance != FLT_MAX)
+				{
+					if (far_distance != FLT_MAX)
+					{
+						stack[stack_size] = far_child;
+						stack_distances[stack_size] = far_distance;
+						++stack_size;
+					}
+
+					node_index = near_child;
+					continue;
+				}
+			}
+
+			// Pop the next node that may still have a closer hit:
+			bool has_next = false;
+
+			while (stack_size > 0)
+			{
+				--stack_size;
+
+				if (stack_distances[stack_size] <= best_distance)
+				{
+					node_index = stack[stack_size];
+					has_next = true;
+					break;
+				}
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+		}
+
+		// The kernel reports the index inside packed_triangles:
+		if (is_hit)
+		{
+			hit.triangle_index = triangle_indices[hit.triangle_index];
+		}
+
+		return is_hit;
+	}
+
+	void TriangleBVH::Subdivide(unsigned int node_index, unsigned int depth, const std::vector<math::AABB>& triangle_boxes, const std::vector<math::float3>& centroids)
+	{
+		const unsigned int first = nodes[node_index].left_first;
+		const unsigned int count = nodes[node_index].triangle_count;
+
+		math::AABB node_box;
+		node_box.SetNegativeInfinity();
+
+		math::AABB centroid_box;
+		centroid_box.SetNegativeInfinity();
+
+		for (unsigned int i = first; i < first + count; ++i)
+		{
+			node_box.Enclose(triangle_boxes[triangle_indices[i]]);
+			centroid_box.Enclose(centroids[triangle_indices[i]]);
+		}
+
+		nodes[node_index].bounding_box = node_box;
+
+		if (count <= TRIANGLE_BVH_MAX_LEAF_TRIANGLES || depth + 1 >= TRIANGLE_BVH_MAX_DEPTH)
+		{
+			return;
+		}
+
+		// Find the cheapest split among the bin boundaries of all axes:
+		float best_cost = FLT_MAX;
+		int best_axis = -1;
+		unsigned int best_split = 0;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float bounds_min = centroid_box.minPoint[axis];
+			const float bounds_max = centroid_box.maxPoint[axis];
+
+			if (bounds_max <= bounds_min)
+			{
+				continue;
+			}
+
+			math::AABB bin_boxes[TRIANGLE_BVH_BIN_COUNT];
+			unsigned int bin_counts[TRIANGLE_BVH_BIN_COUNT] = {};
+
+			for (unsigned int b = 0; b < TRIANGLE_BVH_BIN_COUNT; ++b)
+			{
+				bin_boxes[b].SetNegativeInfinity();
+			}
+
+			const float scale = TRIANGLE_BVH_BIN_COUNT / (bounds_max - bounds_min);
+
+			for (unsigned int i = first; i < first + count; ++i)
+			{
+				const unsigned int triangle_index = triangle_indices[i];
+				unsigned int bin = (unsigned int)((centroids[triangle_index][axis] - bounds_min) * scale);
+				bin = math::Min(bin, (unsigned int)TRIANGLE_BVH_BIN_COUNT - 1);
+
+				bin_boxes[bin].Enclose(triangle_boxes[triangle_index]);
+				++bin_counts[bin];
+			}
+
+			// Sweep from both sides to get the cost of each boundary:
+			float left_areas[TRIANGLE_BVH_BIN_COUNT - 1];
+			unsigned int left_counts[TRIANGLE_BVH_BIN_COUNT - 1];
+
+			math::AABB left_box;
+			left_box.SetNegativeInfinity();
+			unsigned int left_count = 0;
+
+			for (unsigned int b = 0; b < TRIANGLE_BVH_BIN_COUNT - 1; ++b)
+			{
+				left_box.Enclose(bin_boxes[b]);
+				left_count += bin_counts[b];
+
+				left_areas[b] = SurfaceArea(left_box);
+				left_counts[b] = left_count;
+			}
+
+			math::AABB right_box;
+			right_box.SetNegativeInfinity();
+			unsigned int right_count = 0;
+
+			for (unsigned int b = TRIANGLE_BVH_BIN_COUNT - 1; b > 0; --b)
+			{
+				right_box.Enclose(bin_boxes[b]);
+				right_count += bin_counts[b];
+
+				if (left_counts[b - 1] == 0 || right_count == 0)
+				{
+					continue;
+				}
+
+				float cost = left_counts[b - 1] * left_areas[b - 1] + right_count * SurfaceArea(right_box);
+
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best_axis = axis;
+					best_split = b;
+				}
+			}
+		}
+
+		// Keep as a leaf if splitting costs more than testing every triangle:
+		if (best_axis == -1 || best_cost >= count * SurfaceArea(node_box))
+		{
+			return;
+		}
+
+		// Partition the triangle indices so that the ones in bins before
+		// best_split come first:
+		const float bounds_min = centroid_box.minPoint[best_axis];
+		const float scale = TRIANGLE_BVH_BIN_COUNT / (centroid_box.maxPoint[best_axis] - bounds_min);
+
+		unsigned int left = first;
+		unsigned int right = first + count - 1;
+
+		while (left <= right)
+		{
+			unsigned int bin = (unsigned int)((centroids[triangle_indices[left]][best_axis] - bounds_min) * scale);
+			bin = math::Min(bin, (unsigned int)TRIANGLE_BVH_BIN_COUNT - 1);
+
+			if (bin < best_split)
+			{
+				++left;
+			}
+			else
+			{
+				unsigned int temp = triangle_indices[left];
+				triangle_indices[left] = triangle_indices[right];
+				triangle_indices[right] = temp;
+
+				if (right == 0)
+				{
+					break;
+				}
+
+				--right;
+			}
+		}
+
+		const unsigned int left_count = left - first;
+
+		const unsigned int left_child = (unsigned int)nodes.size();
+		nodes.emplace_back();
+		nodes.emplace_back();
+
+		nodes[left_child].left_first = first;
+		nodes[left_child].triangle_count = left_count;
+		nodes[left_child + 1].left_first = left;
+		nodes[left_child + 1].triangle_count = count - left_count;
+
+		nodes[node_index].left_first = left_child;
+		nodes[node_index].triangle_count = 0;
+
+		Subdivide(left_child, depth + 1, triangle_boxes, centroids);
+		Subdivide(left_child + 1, depth + 1, triangle_boxes, centroids);
+	}
+
+	/// <summary>
+	/// Copies the triangles into packed_triangles in leaf order, and points
+	/// the leaves to their packed triangles.
+	/// </summary>
+	void TriangleBVH::PackTriangles(const math::TriangleArray& triangles)
+	{
+		std::vector<unsigned int> packed_triangle_indices;
+		packed_triangle_indices.reserve(triangle_indices.size() + nodes.size());
+
+		for (TriangleBVHNode& node : nodes)
+		{
+			if (!node.IsLeaf())
+			{
+				continue;
+			}
+
+			const unsigned int first = node.left_first;
+
+			node.left_first = (unsigned int)packed_triangles.Size();
+
+			for (unsigned int i = first; i < first + node.triangle_count; ++i)
+			{
+				packed_triangles.Add(triangles[triangle_indices[i]]);
+				packed_triangle_indices.push_back(triangle_indices[i]);
+			}
+
+			packed_triangles.AddPadding();
+			packed_triangle_indices.resize(packed_triangles.Size(), TRIANGLE_HIT_INVALID_INDEX);
+		}
+
+		triangle_indices.swap(packed_triangle_indices);
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "PackedTriangles.h"
+
+#include "MATH_GEO_LIB/Geometry/AABB.h"
+#include "MATH_GEO_LIB/Geometry/LineSegment.h"
+#include "MATH_GEO_LIB/Geometry/Triangle.h"
+#include "MATH_GEO_LIB/Math/float3.h"
+
+#include <vector>
+
+#define TRIANGLE_BVH_BIN_COUNT 16
+#define TRIANGLE_BVH_MAX_LEAF_TRIANGLES PACKED_TRIANGLES_LANE_COUNT
+#define TRIANGLE_BVH_MAX_DEPTH 64
+
+namespace StrawMath
+{
+	/// <summary>
+	/// Node of a TriangleBVH, kept at 32 bytes so that two nodes share a
+	/// cache line. The children of a node are always consecutive, so a
+	/// single index is enough to find both of them.
+	/// </summary>
+	struct TriangleBVHNode
+	{
+		math::AABB bounding_box;
+
+		/// <summary>
+		/// Index of the left child for inner nodes, the right child is the
+		/// one after it. Index of the first triangle in packed_triangles of
+		/// the tree for leaves, always a multiple of PACKED_TRIANGLES_LANE_COUNT.
+		/// </summary>
+		unsigned int left_first;
+
+		/// <summary>
+		/// Number of triangles of a leaf, 0 for inner nodes.
+		/// </summary>
+		unsigned int triangle_count;
+
+		bool IsLeaf() const { return triangle_count != 0; }
+	};
+
+	static_assert(sizeof(TriangleBVHNode) == 32, "TriangleBVHNode must be 32 bytes.");
+
+	/// <summary>
+	/// Bounding volume hierarchy over the triangles of a single mesh. Built
+	/// once with binned SAH, then traversed front to back so that nodes
+	/// farther than the closest hit so far are never visited. The triangles
+	/// are copied in leaf order into packed_triangles, and each leaf is
+	/// padded to a full packet so that it's tested with a single pass of the
+	/// packet kernel.
+	/// </summary>
+	class TriangleBVH
+	{
+	private:
+		std::vector<TriangleBVHNode> nodes;
+
+		/// <summary>
+		/// Triangles of the leaves, the triangles of each leaf are consecutive.
+		/// </summary>
+		PackedTriangles packed_triangles;
+
+		/// <summary>
+		/// Index of the source triangle of each triangle in packed_triangles,
+		/// TRIANGLE_HIT_INVALID_INDEX for padding. Before the triangles are
+		/// packed, indices of the source triangles reordered so that the
+		/// ones of each leaf are consecutive.
+		/// </summary>
+		std::vector<unsigned int> triangle_indices;
+
+	public:
+		TriangleBVH();
+		~TriangleBVH();
+
+		void Build(const math::TriangleArray& triangles);
+		void CleanUp();
+		bool IsEmpty() const;
+		size_t GetNodeCount() const;
+
+		bool Intersects(const math::LineSegment& segment, TriangleHit& hit) const;
+
+	private:
+		void Subdivide(unsigned int node_index, unsigned int depth, const std::vector<math::AABB>& triangle_boxes, const std::vector<math::float3>& centroids);
+		void PackTriangles(const math::TriangleArray& triangles);
+	};
+}
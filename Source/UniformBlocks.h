@@ -0,0 +1,73 @@
+#pragma once
+
+#include "MATH_GEO_LIB/Math/float3.h"
+
+/// <summary>
+/// Binding points of the uniform blocks shared by the shaders.
+/// </summary>
+#define UNIFORM_BLOCK_PER_FRAME_BINDING 0
+#define UNIFORM_BLOCK_LIGHTS_BINDING 1
+
+#define UNIFORM_BLOCK_PER_FRAME_NAME "PerFrame"
+#define UNIFORM_BLOCK_LIGHTS_NAME "Lights"
+
+/// <summary>
+/// CPU side mirror of the PerFrame block of the shaders, in std140
+/// layout. Matrices are stored row major as in MathGeoLib, the block
+/// declares them row_major so they are not transposed.
+/// </summary>
+struct PerFrameUniformBlock
+{
+	float view_matrix[16];
+	float projection_matrix[16];
+	math::float3 camera_position;
+	float time;
+};
+
+/// <summary>
+/// Each vec3 is followed by a float, which std140 packs into the same 16
+/// bytes, so these match the shader structs without hidden padding.
+/// </summary>
+struct DirectionalLightUniformBlock
+{
+	math::float3 direction;
+	float intensity;
+	math::float3 diffuse;
+	float padding;
+};
+
+struct PointLightUniformBlock
+{
+	math::float3 position;
+	float radius;
+	math::float3 diffuse;
+	float intensity;
+};
+
+struct SpotLightUniformBlock
+{
+	math::float3 position;
+	float radius;
+	math::float3 direction;
+	float intensity;
+	math::float3 diffuse;
+	float inner;
+	float outer;
+	float padding[3];
+};
+
+/// <summary>
+/// CPU side mirror of the Lights block of the shaders, in std140 layout.
+/// Lights write their values here while the scene is updated.
+/// </summary>
+struct LightUniformBlock
+{
+	DirectionalLightUniformBlock directional_light;
+	PointLightUniformBlock point_light;
+	SpotLightUniformBlock spot_light;
+};
+
+static_assert(sizeof(PerFrameUniformBlock) == 144, "PerFrameUniformBlock must match the std140 layout of PerFrame.");
+static_assert(sizeof(DirectionalLightUniformBlock) == 32, "DirectionalLightUniformBlock must match the std140 layout of LightD.");
+static_assert(sizeof(PointLightUniformBlock) == 32, "PointLightUniformBlock must match the std140 layout of LightP.");
+static_assert(sizeof(SpotLightUniformBlock) == 64, "SpotLightUniformBlock must match the std140 layout of LightS.");
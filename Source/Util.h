@@ -105,6 +105,13 @@ namespace util
 		return remove(file_name) == 0;
 	}
 
+	inline bool FileExists(const char* file_name)
+	{
+		const DWORD attributes = GetFileAttributesA(file_name);
+
+		return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) == 0;
+	}
+
 	inline void OverwriteFile(const char* file_name, const char* data)
 	{
 		FILE* file;
@@ -295,6 +302,27 @@ namespace util
 		_getcwd(*buffer, MAX_PATH);
 	}
 
+	// Absolute path of path, in lower case and with '\\' as separator, so
+	// that every spelling of a file gives the same path on Windows. Used 
+	// as a key by the resource caches.
+	// User is responsible for deallocation.
+	inline char* GetCanonicalPath(const char* path)
+	{
+		char* canonical_path = (char*)malloc(MAX_PATH);
+
+		if (_fullpath(canonical_path, path, MAX_PATH) == nullptr)
+		{
+			CopyIntoBuffer(canonical_path, path, MAX_PATH, strlen(path));
+		}
+
+		for (char* character = canonical_path; *character != '\0'; ++character)
+		{
+			*character = *character == '/' ? '\\' : (char)tolower((unsigned char)*character);
+		}
+
+		return canonical_path;
+	}
+
 	// User is responsible for deallocation.
 	inline char* CopyCString(const char* source)
 	{
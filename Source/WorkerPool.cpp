@@ -0,0 +1,153 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(size_t worker_count) :
+	job_generation(0),
+	busy_worker_count(0),
+	job_function(nullptr),
+	job_item_count(0),
+	job_chunk_size(0),
+	job_chunk_count(0),
+	next_chunk(0),
+	is_shutting_down(false)
+{
+	if (worker_count == 0)
+	{
+		// The calling thread also runs chunks, so leave one hardware
+		// thread for it:
+		unsigned int hardware_thread_count = std::thread::hardware_concurrency();
+		worker_count = hardware_thread_count > 1 ? hardware_thread_count - 1 : 0;
+	}
+
+	workers.reserve(worker_count);
+
+	for (size_t i = 0; i < worker_count; ++i)
+	{
+		workers.emplace_back(&WorkerPool::RunWorker, this);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(job_mutex);
+		is_shutting_down = true;
+	}
+
+	job_started.notify_all();
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+size_t WorkerPool::GetWorkerCount() const
+{
+	return workers.size();
+}
+
+/// <summary>
+/// Splits [0, item_count) into chunks of chunk_size items and calls function
+/// for each chunk on the workers and the calling thread. Returns once all
+/// the chunks are done. Chunks are not run in any particular order, so
+/// function must only write to data owned by its own range.
+/// </summary>
+/// <param name="item_count">Number of items to process.</param>
+/// <param name="chunk_size">Number of items per chunk, the last one may have less.</param>
+/// <param name="function">Function to call for each chunk.</param>
+void WorkerPool::ParallelFor(size_t item_count, size_t chunk_size, const chunk_function& function)
+{
+	if (item_count == 0)
+	{
+		return;
+	}
+
+	if (chunk_size == 0)
+	{
+		chunk_size = item_count;
+	}
+
+	size_t chunk_count = (item_count + chunk_size - 1) / chunk_size;
+
+	// Waking the workers costs more than a single chunk:
+	if (chunk_count == 1 || workers.empty())
+	{
+		for (size_t begin = 0; begin < item_count; begin += chunk_size)
+		{
+			size_t end = begin + chunk_size < item_count ? begin + chunk_size : item_count;
+			function(begin, end);
+		}
+
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(job_mutex);
+
+		job_function = &function;
+		job_item_count = item_count;
+		job_chunk_size = chunk_size;
+		job_chunk_count = chunk_count;
+		next_chunk.store(0);
+		busy_worker_count = workers.size();
+		++job_generation;
+	}
+
+	job_started.notify_all();
+
+	RunChunks();
+
+	// Wait until all workers are done, they may still be running the last
+	// chunks even if the counter has passed the end:
+	std::unique_lock<std::mutex> lock(job_mutex);
+	job_finished.wait(lock, [this]() { return busy_worker_count == 0; });
+
+	job_function = nullptr;
+}
+
+void WorkerPool::RunWorker()
+{
+	unsigned long long last_generation = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(job_mutex);
+			job_started.wait(lock, [this, last_generation]()
+			{
+				return is_shutting_down || job_generation != last_generation;
+			});
+
+			if (is_shutting_down)
+			{
+				return;
+			}
+
+			last_generation = job_generation;
+		}
+
+		RunChunks();
+
+		bool is_last_worker;
+		{
+			std::lock_guard<std::mutex> lock(job_mutex);
+			is_last_worker = --busy_worker_count == 0;
+		}
+
+		if (is_last_worker)
+		{
+			job_finished.notify_one();
+		}
+	}
+}
+
+void WorkerPool::RunChunks()
+{
+	for (size_t chunk = next_chunk.fetch_add(1); chunk < job_chunk_count; chunk = next_chunk.fetch_add(1))
+	{
+		size_t begin = chunk * job_chunk_size;
+		size_t end = begin + job_chunk_size < job_item_count ? begin + job_chunk_size : job_item_count;
+
+		(*job_function)(begin, end);
+	}
+}
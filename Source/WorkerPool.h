@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Fixed set of worker threads that run data parallel jobs. A job is a range
+/// of items split into chunks; workers and the calling thread take chunks
+/// from a shared counter until none is left, so the caller never waits on
+/// an idle worker. Only one job runs at a time, ParallelFor must be called
+/// from the main thread.
+/// </summary>
+class WorkerPool
+{
+public:
+	/// <summary>
+	/// Function called for each chunk, with the half open range [begin, end)
+	/// of item indices it covers.
+	/// </summary>
+	typedef std::function<void(size_t begin, size_t end)> chunk_function;
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex job_mutex;
+	std::condition_variable job_started;
+	std::condition_variable job_finished;
+
+	/// <summary>
+	/// Incremented each time a job starts, so that a worker can tell a new
+	/// job from the one it has just finished.
+	/// </summary>
+	unsigned long long job_generation;
+
+	/// <summary>
+	/// Number of workers that are still taking chunks of the current job.
+	/// </summary>
+	size_t busy_worker_count;
+
+	const chunk_function* job_function;
+	size_t job_item_count;
+	size_t job_chunk_size;
+	size_t job_chunk_count;
+	std::atomic<size_t> next_chunk;
+	bool is_shutting_down;
+
+public:
+	/// <param name="worker_count">Number of threads to create, 0 to create one less than the hardware threads.</param>
+	explicit WorkerPool(size_t worker_count = 0);
+	~WorkerPool();
+
+	size_t GetWorkerCount() const;
+
+	void ParallelFor(size_t item_count, size_t chunk_size, const chunk_function& function);
+
+private:
+	void RunWorker();
+	void RunChunks();
+};